@@ -5,6 +5,12 @@
 #include <SoftwareCore/Process.hpp>
 #include <yaml-cpp/yaml.h>
 #include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
 
 void ConsoleOutput(const char* message, ::Core::LoggerSeverity severity)
 {
@@ -31,12 +37,289 @@ void ConsoleOutput(const char* message, ::Core::LoggerSeverity severity)
 	}
 }
 
+// Runs the full frame path (acquire, record, submit, present) against a headless surface, optionally dumping the last frame.
+// Returns false if no frame could be rendered or the requested dump was not written.
+bool RunHeadlessBenchmark(const VulkanBackend::BackendData& backendData, uint32_t frameCount, const char* dumpPath)
+{
+	VulkanBackend::SurfaceData surfaceData{};
+	if (!VulkanBackend::CreateHeadlessSurface(backendData, surfaceData, 1280, 720))
+	{
+		return false;
+	}
+	VulkanBackend::GetSurfaceCapabilities(backendData, surfaceData);
+	VulkanBackend::GetSurfaceFormat(backendData, surfaceData);
+	VulkanBackend::GetSurfaceExtent(backendData, surfaceData);
+	VulkanBackend::GetPresentMode(backendData, surfaceData);
+	VulkanBackend::GetSwapchainImageCount(surfaceData);
+	VulkanBackend::FilterPresentQueues(backendData, surfaceData);
+	VulkanBackend::SelectPresentQueue(backendData, surfaceData);
+
+	auto manager = VulkanBackend::CreateSwapchainManager(backendData, surfaceData, 2,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+	const VkExtent2D extent = surfaceData.surfaceExtent;
+	auto readbackRing = VulkanBackend::CreateReadbackRing(backendData, 3, (VkDeviceSize)extent.width * extent.height * 4);
+	const bool bgra = surfaceData.surfaceFormat.format == VK_FORMAT_B8G8R8A8_UNORM || surfaceData.surfaceFormat.format == VK_FORMAT_B8G8R8A8_SRGB;
+	// Frames are submitted on the general queue and presented on the selected present queue.
+	VkQueue presentQueue = surfaceData.defaultPresentQueue;
+	uint32_t renderedFrames = 0;
+	bool dumped = false;
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t f = 0; f < frameCount; ++f)
+	{
+		VkCommandBuffer commandBuffer = VulkanBackend::BeginSwapchainFrame(backendData, surfaceData, manager);
+		if (!commandBuffer)
+		{
+			continue;
+		}
+		VkImage image = manager.images[manager.imageIndex];
+
+		VulkanBackend::TransitionImageLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, image, 1,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+			0, VK_ACCESS_TRANSFER_WRITE_BIT);
+		VkClearColorValue clearColor = { { (float)f / frameCount, 0.25f, 0.5f, 1.0f } };
+		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &range);
+
+		// The readback is delivered by a later frame once this one has finished, the loop never waits for it.
+		VulkanBackend::BeginReadbackFrame(backendData, readbackRing, manager.completedFrames);
+		const bool dump = dumpPath && f == frameCount - 1;
+		if (dump)
+		{
+			VulkanBackend::TransitionImageLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, 1,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+			VulkanBackend::RequestImageReadback(backendData, readbackRing, commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_IMAGE_ASPECT_COLOR_BIT, 4, { 0, 0 }, extent,
+				[&](const void* data, VkDeviceSize size)
+				{
+					dumped = VulkanBackend::WriteImagePNG(dumpPath, extent.width, extent.height, data, bgra);
+				});
+		}
+		VulkanBackend::EndReadbackFrame(readbackRing, commandBuffer, manager.frameNumber);
+
+		VulkanBackend::TransitionImageLayout(commandBuffer,
+			dump ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, image, 1,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+		VulkanBackend::EndSwapchainFrame(backendData, surfaceData, manager, presentQueue);
+		++renderedFrames;
+	}
+	VulkanCheck(vkQueueWaitIdle(backendData.generalQueues[0]));
+	if (presentQueue != backendData.generalQueues[0])
+	{
+		VulkanCheck(vkQueueWaitIdle(presentQueue));
+	}
+	VulkanBackend::PollReadbacks(backendData, readbackRing, manager.frameNumber);
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	CoreLogInfo(DefaultLogger, "Headless frame loop (%ux%u): %.3f ms per frame over %u frames", extent.width, extent.height,
+		milliseconds / (std::max)(1u, frameCount), frameCount);
+
+	VulkanBackend::DestroyReadbackRing(backendData, readbackRing);
+	VulkanBackend::DestroySwapchainManager(backendData, surfaceData, manager);
+	VulkanBackend::DestroySurface(backendData, surfaceData.surface);
+
+	return renderedFrames > 0 && (!dumpPath || dumped);
+}
+
+template<typename T>
+void AppendValue(std::vector<uint8_t>& bytes, T value)
+{
+	const uint8_t* data = (const uint8_t*)&value;
+	bytes.insert(bytes.end(), data, data + sizeof(T));
+}
+
+bool WriteFile(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char*)bytes.data(), bytes.size());
+	return file.good();
+}
+
+// Writes a 4x4 RGBA8 KTX2 file with two levels and a single-level DDS file, then loads both through the staging ring.
+// Returns false if either file fails to load with the expected mip count.
+bool RunTextureLoadTest(const VulkanBackend::BackendData& backendData, const std::string& ktx2Path, const std::string& ddsPath)
+{
+	std::vector<uint8_t> ktx2 = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	for (uint32_t value : { (uint32_t)VK_FORMAT_R8G8B8A8_UNORM, 1u, 4u, 4u, 0u, 0u, 1u, 2u, 0u })
+	{
+		AppendValue(ktx2, value);
+	}
+	// Data format descriptor, key/value data and supercompression data are all empty.
+	ktx2.resize(80, 0);
+	const uint64_t levelSizes[2] = { 4 * 4 * 4, 2 * 2 * 4 };
+	uint64_t levelOffset = 80 + 2 * 24;
+	for (uint64_t levelSize : levelSizes)
+	{
+		AppendValue(ktx2, levelOffset);
+		AppendValue(ktx2, levelSize);
+		AppendValue(ktx2, levelSize);
+		levelOffset += levelSize;
+	}
+	for (uint64_t t = 0; t < levelSizes[0] + levelSizes[1]; ++t)
+	{
+		ktx2.push_back((uint8_t)t);
+	}
+
+	std::vector<uint8_t> dds;
+	AppendValue(dds, (uint32_t)0x20534444);
+	AppendValue(dds, 124u);
+	AppendValue(dds, 0x100Fu);
+	AppendValue(dds, 4u);
+	AppendValue(dds, 4u);
+	dds.resize(4 + 72, 0);
+	// RGB pixel format, 32 bits with red in the lowest byte.
+	for (uint32_t value : { 32u, 0x41u, 0u, 32u, 0x000000FFu, 0x0000FF00u, 0x00FF0000u, 0xFF000000u, 0x1000u })
+	{
+		AppendValue(dds, value);
+	}
+	dds.resize(4 + 124, 0);
+	for (uint32_t t = 0; t < 4 * 4 * 4; ++t)
+	{
+		dds.push_back((uint8_t)t);
+	}
+
+	if (!WriteFile(ktx2Path, ktx2) || !WriteFile(ddsPath, dds))
+	{
+		CoreLogError(DefaultLogger, "Texture loader test: Failed to write the test files.");
+		return false;
+	}
+
+	auto stagingRing = VulkanBackend::CreateStagingRing(backendData, 64 * 1024);
+	VkCommandBuffer commandBuffer = VulkanBackend::AllocateCommandBuffer(backendData, backendData.generalCommandPool);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VulkanCheck(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+	auto ktx2Texture = VulkanBackend::LoadTexture(backendData, stagingRing, commandBuffer, ktx2Path.c_str());
+	auto ddsTexture = VulkanBackend::LoadTexture(backendData, stagingRing, commandBuffer, ddsPath.c_str());
+	VulkanCheck(vkEndCommandBuffer(commandBuffer));
+
+	VulkanBackend::SubmitStaging(backendData, stagingRing, backendData.generalQueues[0], commandBuffer);
+	VulkanCheck(vkQueueWaitIdle(backendData.generalQueues[0]));
+	VulkanBackend::RetireStaging(backendData, stagingRing);
+
+	CoreLogInfo(DefaultLogger, "Texture loader test: KTX2 %s (%u mips), DDS %s (%u mips)",
+		ktx2Texture.image.image ? "loaded" : "failed", ktx2Texture.mipCount, ddsTexture.image.image ? "loaded" : "failed", ddsTexture.mipCount);
+
+	const bool passed = ktx2Texture.image.image && ktx2Texture.mipCount == 2 && ddsTexture.image.image && ddsTexture.mipCount == 1;
+
+	VulkanBackend::DestroyTexture(backendData, ktx2Texture);
+	VulkanBackend::DestroyTexture(backendData, ddsTexture);
+	VulkanBackend::FreeCommandBuffer(backendData, backendData.generalCommandPool, commandBuffer);
+	VulkanBackend::DestroyStagingRing(backendData, stagingRing);
+	return passed;
+}
+
+bool IsNewBindlessIndex(const std::vector<uint32_t>& live, uint32_t index)
+{
+	return index != UINT32_MAX && std::find(live.begin(), live.end(), index) == live.end();
+}
+
+// Adds, removes and reuses bindless indices across frames. Removed indices must stay reserved for the frames in flight,
+// and removing an index that is not in use must be rejected instead of handing it out twice later.
+// Returns false if a check fails, a device that cannot create the heap skips the test.
+bool RunBindlessHeapTest(const VulkanBackend::BackendData& backendData)
+{
+	if (!backendData.enabledFeatures12.descriptorIndexing)
+	{
+		CoreLogInfo(DefaultLogger, "Bindless heap test: skipped, descriptor indexing is not enabled.");
+		return true;
+	}
+	const uint32_t framesInFlight = 2;
+	VulkanBackend::BindlessHeap heap;
+	if (!VulkanBackend::CreateBindlessHeap(backendData, heap, framesInFlight, 16, 16, 16, 16))
+	{
+		CoreLogInfo(DefaultLogger, "Bindless heap test: skipped, the heap could not be created on this device.");
+		return true;
+	}
+	VkSampler sampler = VulkanBackend::CreateImageSampler(backendData, VK_FILTER_LINEAR, VK_FILTER_LINEAR, VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+		VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, 0.f, 1.f);
+
+	bool passed = true;
+	std::vector<uint32_t> live;
+	for (uint32_t r = 0; r < 4; ++r)
+	{
+		const uint32_t index = VulkanBackend::AddBindlessSampler(backendData, heap, sampler);
+		passed &= IsNewBindlessIndex(live, index);
+		live.push_back(index);
+	}
+
+	const std::vector<uint32_t> removed = { live[1], live[2] };
+	for (uint32_t index : removed)
+	{
+		passed &= VulkanBackend::RemoveBindlessResource(heap, VulkanBackend::BindlessType::Sampler, index);
+		live.erase(std::find(live.begin(), live.end(), index));
+	}
+	// A second remove of the same index and a remove of an index never handed out are both rejected.
+	passed &= !VulkanBackend::RemoveBindlessResource(heap, VulkanBackend::BindlessType::Sampler, removed[0]);
+	passed &= !VulkanBackend::RemoveBindlessResource(heap, VulkanBackend::BindlessType::Sampler, 15);
+
+	// One add per frame: fresh indices while the removed ones are pending, then exactly the removed ones.
+	for (uint32_t frame = 0; frame < framesInFlight + (uint32_t)removed.size(); ++frame)
+	{
+		const uint32_t index = VulkanBackend::AddBindlessSampler(backendData, heap, sampler);
+		const bool reused = std::find(removed.begin(), removed.end(), index) != removed.end();
+		passed &= IsNewBindlessIndex(live, index) && reused == (frame >= framesInFlight);
+		live.push_back(index);
+		VulkanBackend::AdvanceBindlessFrame(heap);
+	}
+
+	for (uint32_t index : live)
+	{
+		passed &= VulkanBackend::RemoveBindlessResource(heap, VulkanBackend::BindlessType::Sampler, index);
+	}
+
+	CoreLogInfo(DefaultLogger, "Bindless heap test: %s", passed ? "passed" : "failed");
+
+	VulkanBackend::DestroyBindlessHeap(backendData, heap);
+	VulkanBackend::DestroyImageSampler(backendData, sampler);
+
+	return passed;
+}
+
 int main(int argc, char* argv[])
 {
 	DefaultLogger.SetNewOutput(ConsoleOutput);
 
+	// Usage: [--benchmarks] [--textures] [--bindless] [--headless <frame count> [--dump <path.png>]]
+	// The headless run uses its own configuration, so it also works on machines without a display or a dedicated GPU.
+	// The bindless test (unless combined with --headless) uses one requiring descriptor indexing, otherwise it is skipped.
+	// Any failed test makes the process exit with a non-zero code, so automated runs notice it.
+	int exitCode = 0;
+	bool benchmarks = false;
+	bool textureTest = false;
+	bool bindlessTest = false;
+	uint32_t headlessFrames = 0;
+	const char* dumpPath = nullptr;
+	for (int a = 1; a < argc; ++a)
+	{
+		if (strcmp(argv[a], "--benchmarks") == 0)
+		{
+			benchmarks = true;
+		}
+		else if (strcmp(argv[a], "--textures") == 0)
+		{
+			textureTest = true;
+		}
+		else if (strcmp(argv[a], "--bindless") == 0)
+		{
+			bindlessTest = true;
+		}
+		else if (strcmp(argv[a], "--headless") == 0 && a + 1 < argc)
+		{
+			headlessFrames = (uint32_t)atoi(argv[++a]);
+		}
+		else if (strcmp(argv[a], "--dump") == 0 && a + 1 < argc)
+		{
+			dumpPath = argv[++a];
+		}
+	}
+
 	Core::Filesystem filesystem(CoreProcess.GetRuntimePath());
-	std::string pathToYamlFile = filesystem.GetAbsolutePath("../../testfile.yml");
+	std::string pathToYamlFile = filesystem.GetAbsolutePath(headlessFrames > 0 ? "../../headless.yml" :
+		bindlessTest ? "../../bindless.yml" : "../../testfile.yml");
 
 	VulkanBackend::BackendData backendData = VulkanBackend::Initialize(pathToYamlFile.c_str());
 
@@ -44,13 +327,53 @@ int main(int argc, char* argv[])
 		24, VMA_MEMORY_USAGE_GPU_ONLY);
 	VulkanBackend::DestroyBuffer(backendData, buffer);
 
-	VulkanCheck(VK_SUCCESS);
+	if (benchmarks)
+	{
+		auto uploadBenchmark = VulkanBackend::BenchmarkImageUpload(backendData, 2048, 2048, 8);
+		CoreLogInfo(DefaultLogger, "Image upload (2048x2048 RGBA8): staged %.3f ms", uploadBenchmark.stagedMilliseconds);
+		if (uploadBenchmark.hostCopyAvailable)
+		{
+			CoreLogInfo(DefaultLogger, "Image upload (2048x2048 RGBA8): host copy %.3f ms", uploadBenchmark.hostCopyMilliseconds);
+		}
 
-	VkDeviceCreateInfo deviceCreateInfo{};
-	VkDevice device;
-	VulkanCheck(vkCreateDevice(backendData.physicalDevice, &deviceCreateInfo, nullptr, &device));
+		for (uint32_t bindingCount : { 64u, 4096u })
+		{
+			const double reflectionMilliseconds = VulkanBackend::BenchmarkShaderReflection(bindingCount, 100);
+			CoreLogInfo(DefaultLogger, "Shader reflection (%u bindings): %.3f ms", bindingCount, reflectionMilliseconds);
+		}
+	}
+	if (textureTest)
+	{
+		if (!RunTextureLoadTest(backendData, filesystem.GetAbsolutePath("loader_test.ktx2"), filesystem.GetAbsolutePath("loader_test.dds")))
+		{
+			exitCode = 1;
+		}
+	}
+	if (bindlessTest)
+	{
+		if (!RunBindlessHeapTest(backendData))
+		{
+			exitCode = 1;
+		}
+	}
+	if (headlessFrames > 0)
+	{
+		if (!RunHeadlessBenchmark(backendData, headlessFrames, dumpPath))
+		{
+			exitCode = 1;
+		}
+	}
+	else
+	{
+		// Deliberately invalid device creation, shows how failed calls are reported (skipped on the headless CI run).
+		VulkanCheck(VK_SUCCESS);
+
+		VkDeviceCreateInfo deviceCreateInfo{};
+		VkDevice device;
+		VulkanCheck(vkCreateDevice(backendData.physicalDevice, &deviceCreateInfo, nullptr, &device));
+	}
 
 	VulkanBackend::Shutdown(backendData);
 
-	return 0;
-}
\ No newline at end of file
+	return exitCode;
+}
@@ -3,16 +3,59 @@
 #include <vulkan/vulkan_core.h>
 #include <vk_mem_alloc.h>
 #include <vector>
+#include <string>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <type_traits>
 
 namespace VulkanBackend
 {
 	// ======================== Backend ========================
 
+	// Null for the states the device does not support.
+	struct ExtendedDynamicStateFunctions
+	{
+		PFN_vkCmdSetCullModeEXT setCullMode;
+		PFN_vkCmdSetFrontFaceEXT setFrontFace;
+		PFN_vkCmdSetPrimitiveTopologyEXT setPrimitiveTopology;
+		PFN_vkCmdSetDepthTestEnableEXT setDepthTestEnable;
+		PFN_vkCmdSetDepthWriteEnableEXT setDepthWriteEnable;
+		PFN_vkCmdSetDepthCompareOpEXT setDepthCompareOp;
+		PFN_vkCmdSetStencilTestEnableEXT setStencilTestEnable;
+#ifdef VK_EXT_extended_dynamic_state2
+		PFN_vkCmdSetRasterizerDiscardEnableEXT setRasterizerDiscardEnable;
+		PFN_vkCmdSetDepthBiasEnableEXT setDepthBiasEnable;
+		PFN_vkCmdSetPrimitiveRestartEnableEXT setPrimitiveRestartEnable;
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+		PFN_vkCmdSetPolygonModeEXT setPolygonMode;
+		PFN_vkCmdSetRasterizationSamplesEXT setRasterizationSamples;
+		PFN_vkCmdSetColorBlendEnableEXT setColorBlendEnable;
+		PFN_vkCmdSetColorWriteMaskEXT setColorWriteMask;
+#endif
+	};
+
+	struct FramebufferCache;
+	struct DescriptorSetCache;
+
 	struct BackendData
 	{
 		VkInstance instance;
 		VkDebugUtilsMessengerEXT debugMessenger;
+		std::vector<std::string> enabledInstanceExtensions;
 		VkPhysicalDevice physicalDevice;
+		VkPhysicalDeviceProperties deviceProperties;
+		VkPhysicalDeviceFeatures enabledFeatures;
+		VkPhysicalDeviceVulkan12Features enabledFeatures12;
+		std::vector<std::string> enabledDeviceExtensions;
+		// Image layouts usable as the destination of host image copies (empty without VK_EXT_host_image_copy).
+		std::vector<VkImageLayout> hostImageCopyLayouts;
+		// Zero without VK_EXT_external_memory_host.
+		VkDeviceSize minImportedHostPointerAlignment;
 		VkDevice logicalDevice;
 		std::vector<VkQueue> generalQueues;
 		int generalFamilyIndex;
@@ -24,11 +67,33 @@ namespace VulkanBackend
 		VmaAllocator allocator;
 		VkCommandPool transferCommandPool;
 		VkCommandPool generalCommandPool;
+		// Dynamic states beyond the core ones that the device supports.
+		std::vector<VkDynamicState> extendedDynamicStates;
+		ExtendedDynamicStateFunctions extendedDynamicStateFunctions;
+#ifdef VK_KHR_dynamic_rendering
+		// Null without VK_KHR_dynamic_rendering, fetched once since they are recorded every frame.
+		PFN_vkCmdBeginRenderingKHR cmdBeginRendering;
+		PFN_vkCmdEndRenderingKHR cmdEndRendering;
+#endif
+#ifdef VK_EXT_host_image_copy
+		// Null without VK_EXT_host_image_copy, fetched once since every host upload calls them.
+		PFN_vkTransitionImageLayoutEXT transitionImageLayout;
+		PFN_vkCopyMemoryToImageEXT copyMemoryToImage;
+#endif
+		// Null without VK_EXT_external_memory_host.
+		PFN_vkGetMemoryHostPointerPropertiesEXT getMemoryHostPointerProperties;
+		// Set through RegisterFramebufferCache, destroying an image view or a render pass evicts the framebuffers using it.
+		FramebufferCache* framebufferCache;
+		// Set through RegisterDescriptorSetCache, destroying a buffer, image view or sampler invalidates the sets using it.
+		DescriptorSetCache* descriptorSetCache;
 	};
 
 	BackendData Initialize(const char* configFilePath);
 	void Shutdown(BackendData& backendData);
 
+	bool IsInstanceExtensionEnabled(const BackendData& backendData, const char* extension);
+	bool IsDeviceExtensionEnabled(const BackendData& backendData, const char* extension);
+
 	// ======================== Surface ========================
 
 	struct SurfaceData
@@ -50,6 +115,9 @@ namespace VulkanBackend
 	};
 
 	void CreateSurface(const BackendData& backendData, SurfaceData& surfaceData, void* windowHandle, void* connection);
+	// Creates a surface without a display (VK_EXT_headless_surface), its swapchain images are never shown.
+	// The size is taken as the window size, the rest of the surface data is filled the same way as for a window.
+	bool CreateHeadlessSurface(const BackendData& backendData, SurfaceData& surfaceData, uint32_t width, uint32_t height);
 	void DestroySurface(const BackendData& backendData, VkSurfaceKHR& surface);
 
 	void GetDepthFormat(const BackendData& backendData, SurfaceData& surfaceData);
@@ -116,21 +184,32 @@ namespace VulkanBackend
 		VkAccessFlags destinationAccessMask, int sourceQueueFamily, int destinationQueueFamily);
 
 	VkImageView CreateImageView2D(const BackendData& backendData, VkImage image, VkFormat format, VkImageSubresourceRange& subresource);
+	VkImageView CreateImageView(const BackendData& backendData, const VkImageViewCreateInfo& imageViewCreateInfo);
 	void DestroyImageView(const BackendData& backendData, VkImageView& imageView);
 
 	VkSampler CreateImageSampler(const BackendData& backendData, VkFilter magnificationFilter, VkFilter minificationFilter, VkBorderColor borderColor,
 		VkSamplerAddressMode uAddressMode, VkSamplerAddressMode vAddressMode, VkSamplerAddressMode wAddressMode,
 		float minLod, float maxLod, float mipLodBias = 0.f, VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR, float maxAnisotropy = 1.f);
+	VkSampler CreateImageSampler(const BackendData& backendData, const VkSamplerCreateInfo& samplerCreateInfo);
 	void DestroyImageSampler(const BackendData& backendData, VkSampler& sampler);
 
 	struct Buffer
 	{
 		VkBuffer buffer = nullptr;
 		VmaAllocation allocation = nullptr;
+		// Set instead of the allocation for buffers backed by imported host memory.
+		VkDeviceMemory importedMemory = nullptr;
+		// Only set for buffers created with the shader device address usage.
+		VkDeviceAddress deviceAddress = 0;
 	};
 
+	// Buffers with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT need the "buffer device address" device feature.
 	Buffer CreateBuffer(const BackendData& backendData, VkBufferUsageFlags usage, VkDeviceSize size, VmaMemoryUsage residency);
+	// Uses the host memory directly as the buffer storage (no copy), the memory has to outlive the buffer.
+	// When the import is not possible, a device local buffer is created and filled through a staging buffer instead.
+	Buffer CreateBufferFromHostMemory(const BackendData& backendData, VkBufferUsageFlags usage, void* hostPointer, VkDeviceSize size);
 	void DestroyBuffer(const BackendData& backendData, Buffer& buffer);
+	VkDeviceAddress GetBufferDeviceAddress(const BackendData& backendData, VkBuffer buffer);
 
 	void ReleaseBufferOwnership(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize size,
 		VkDeviceSize offset, VkPipelineStageFlags sourceStage, VkPipelineStageFlags destinationStage, VkAccessFlags sourceAccessMask,
@@ -143,9 +222,506 @@ namespace VulkanBackend
 		VkCommandBuffer commandBuffer, VkDeviceSize sourceOffset = 0, VkDeviceSize destinationOffset = 0);
 	void CopyBufferToImage(const BackendData& backendData, VkBuffer source, VkImage destination, VkImageLayout layout,
 		VkCommandBuffer commandBuffer, uint32_t width, uint32_t height, VkImageAspectFlags aspect);
+	// Copies all the regions (e.g. every mip level of a texture) with a single command.
+	void CopyBufferToImage(const BackendData& backendData, VkBuffer source, VkImage destination, VkImageLayout layout,
+		VkCommandBuffer commandBuffer, const std::vector<VkBufferImageCopy>& regions);
 	void CopyImageToBuffer(const BackendData& backendData, VkImage source, VkBuffer destination, VkImageLayout layout,
 		VkCommandBuffer commandBuffer, uint32_t width, uint32_t height, VkImageAspectFlags aspect, int32_t xOffset = 0, int32_t yOffset = 0);
 
+	// Images uploaded through UploadImage2D need this usage, it includes host transfer when host image copy is enabled.
+	VkImageUsageFlags GetUploadImageUsage(const BackendData& backendData);
+	// The usage is the one the image was created with, host copies need VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT in it.
+	bool CanUploadImageFromHost(const BackendData& backendData, VkFormat format, VkImageUsageFlags usage, VkImageLayout finalLayout);
+	// Uploads tightly packed mip levels (stored one after another) into an image in the undefined layout and leaves it in the final layout.
+	// Host image copy writes the data directly when available, otherwise it goes through a staging buffer on the general queue.
+	void UploadImage2D(const BackendData& backendData, VkImage image, VkFormat format, VkImageUsageFlags usage, uint32_t width, uint32_t height,
+		uint32_t mipCount, uint32_t bytesPerTexel, const void* data, VkImageLayout finalLayout, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT);
+	void UploadImage2DStaged(const BackendData& backendData, VkImage image, uint32_t width, uint32_t height, uint32_t mipCount,
+		uint32_t bytesPerTexel, const void* data, VkImageLayout finalLayout, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT);
+
+	struct ImageUploadBenchmark
+	{
+		bool hostCopyAvailable;
+		double stagedMilliseconds;
+		double hostCopyMilliseconds;
+	};
+
+	// Uploads an RGBA8 image of the given size repeatedly through both paths and reports the average times.
+	ImageUploadBenchmark BenchmarkImageUpload(const BackendData& backendData, uint32_t width, uint32_t height, uint32_t iterations);
+
+	// ======================== Caches =========================
+
+	struct CacheStatistics
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint32_t liveObjects = 0;
+	};
+
+	struct SamplerCacheEntry
+	{
+		VkSamplerCreateInfo createInfo;
+		VkSampler sampler;
+		uint32_t referenceCount;
+	};
+
+	// Identical create infos share one driver object, the lookups are thread-safe.
+	struct SamplerCache
+	{
+		std::mutex mutex;
+		std::unordered_multimap<size_t, SamplerCacheEntry> entries;
+		std::unordered_map<VkSampler, size_t> hashes;
+		CacheStatistics statistics;
+	};
+
+	struct ImageViewCacheEntry
+	{
+		VkImageViewCreateInfo createInfo;
+		VkImageView imageView;
+		uint32_t referenceCount;
+	};
+
+	struct ImageViewCache
+	{
+		std::mutex mutex;
+		std::unordered_multimap<size_t, ImageViewCacheEntry> entries;
+		std::unordered_map<VkImageView, size_t> hashes;
+		CacheStatistics statistics;
+	};
+
+	// Every acquire must be paired with a release, the object is destroyed with the last reference.
+	// Create infos with a pNext chain bypass the cache.
+	VkSampler AcquireImageSampler(const BackendData& backendData, SamplerCache& cache, VkFilter magnificationFilter, VkFilter minificationFilter,
+		VkBorderColor borderColor, VkSamplerAddressMode uAddressMode, VkSamplerAddressMode vAddressMode, VkSamplerAddressMode wAddressMode,
+		float minLod, float maxLod, float mipLodBias = 0.f, VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR, float maxAnisotropy = 1.f);
+	VkSampler AcquireImageSampler(const BackendData& backendData, SamplerCache& cache, const VkSamplerCreateInfo& samplerCreateInfo);
+	void ReleaseImageSampler(const BackendData& backendData, SamplerCache& cache, VkSampler& sampler);
+	void DestroySamplerCache(const BackendData& backendData, SamplerCache& cache);
+	CacheStatistics GetSamplerCacheStatistics(SamplerCache& cache);
+
+	VkImageView AcquireImageView2D(const BackendData& backendData, ImageViewCache& cache, VkImage image, VkFormat format,
+		const VkImageSubresourceRange& subresource);
+	VkImageView AcquireImageView(const BackendData& backendData, ImageViewCache& cache, const VkImageViewCreateInfo& imageViewCreateInfo);
+	void ReleaseImageView(const BackendData& backendData, ImageViewCache& cache, VkImageView& imageView);
+	// Must be called before the image is destroyed, a new image could otherwise reuse the handle and hit stale views.
+	void EvictImageViews(const BackendData& backendData, ImageViewCache& cache, VkImage image);
+	void DestroyImageViewCache(const BackendData& backendData, ImageViewCache& cache);
+	CacheStatistics GetImageViewCacheStatistics(ImageViewCache& cache);
+
+	struct FramebufferCacheEntry
+	{
+		VkRenderPass renderPass;
+		std::vector<VkImageView> attachments;
+		uint32_t width;
+		uint32_t height;
+		uint32_t layers;
+		VkFramebuffer framebuffer;
+	};
+
+	// Framebuffers are owned by the cache, they live until one of their attachments or their render pass is evicted.
+	struct FramebufferCache
+	{
+		std::mutex mutex;
+		std::unordered_multimap<size_t, FramebufferCacheEntry> entries;
+		CacheStatistics statistics;
+	};
+
+	// Once registered, DestroyImageView, DestroyRenderPass and the deletion queues created afterwards evict through the cache.
+	// Registering a null cache stops that, it has to happen before the registered cache is destroyed.
+	void RegisterFramebufferCache(BackendData& backendData, FramebufferCache* cache);
+	VkFramebuffer AcquireFramebuffer(const BackendData& backendData, FramebufferCache& cache, VkRenderPass renderPass,
+		const std::vector<VkImageView>& attachments, uint32_t width, uint32_t height, uint32_t layers = 1);
+	// Evicted framebuffers are destroyed right away, they must not be in use on the GPU.
+	void EvictFramebuffers(const BackendData& backendData, FramebufferCache& cache, VkImageView imageView);
+	void EvictFramebuffers(const BackendData& backendData, FramebufferCache& cache, VkRenderPass renderPass);
+	// Removes the framebuffers referencing the view or render pass from the cache and hands them over for deferred destruction.
+	std::vector<VkFramebuffer> DetachFramebuffers(FramebufferCache& cache, VkImageView imageView);
+	std::vector<VkFramebuffer> DetachFramebuffers(FramebufferCache& cache, VkRenderPass renderPass);
+	void DestroyFramebufferCache(const BackendData& backendData, FramebufferCache& cache);
+	CacheStatistics GetFramebufferCacheStatistics(FramebufferCache& cache);
+
+	// ======================= Streaming =======================
+
+	// Fills the destination with tightly packed texel blocks (texels for uncompressed formats) of the requested region of the given mip level.
+	using TileLoader = std::function<void(uint32_t mip, VkOffset3D offset, VkExtent3D extent, void* destination)>;
+
+	enum class TileState : uint8_t
+	{
+		Empty,
+		Pending,
+		Resident,
+		// No longer reported as resident, unbound once the frames that could still sample it have completed.
+		Evicting
+	};
+
+	struct StreamingTexture
+	{
+		VkImage image = VK_NULL_HANDLE;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t mipCount = 0;
+		// Texel block of the format, 1x1 for uncompressed formats.
+		VkExtent2D blockExtent{};
+		uint32_t blockSize = 0;
+		TileLoader loader;
+
+		// Sparse layout of the image (a tile is one sparse block).
+		VkExtent3D tileExtent{};
+		VkDeviceSize tileSize = 0;
+		uint32_t memoryTypeBits = 0;
+		uint32_t mipTailFirstLod = 0;
+		VmaAllocation mipTailAllocation = VK_NULL_HANDLE;
+
+		// Tiles of all the mip levels before the mip tail, stored mip after mip.
+		std::vector<uint32_t> mipTileOffsets;
+		std::vector<uint32_t> mipTileColumns;
+		std::vector<uint32_t> mipTileRows;
+		std::vector<TileState> tileStates;
+		std::vector<VmaAllocation> tileAllocations;
+		std::vector<uint64_t> tileLastUsedFrames;
+
+		// Feedback-driven desired mip and the finest fully resident mip per region of mip 0 tile size.
+		uint32_t regionColumns = 0;
+		uint32_t regionRows = 0;
+		std::vector<uint8_t> desiredMips;
+		std::vector<uint8_t> residentMips;
+	};
+
+	struct StreamingStatistics
+	{
+		uint64_t frame = 0;
+		uint32_t tilesRequested = 0;
+		uint32_t tilesPagedIn = 0;
+		uint32_t tilesEvicted = 0;
+		uint32_t tilesPending = 0;
+		VkDeviceSize bytesUploaded = 0;
+		VkDeviceSize bytesResident = 0;
+		VkDeviceSize memoryBudget = 0;
+		bool uploadStalled = false;
+	};
+
+	struct TileEviction
+	{
+		// The last frame that could still sample the tile.
+		uint64_t frame;
+		uint32_t texture;
+		uint32_t tile;
+	};
+
+	struct TextureStreamer
+	{
+		std::vector<StreamingTexture> textures;
+
+		// Sparse binding capable queue (transfer if possible) and its submission objects.
+		VkQueue queue = VK_NULL_HANDLE;
+		uint32_t queueFamilyIndex = 0;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkSemaphore bindSemaphore = VK_NULL_HANDLE;
+		VkFence uploadFence = VK_NULL_HANDLE;
+		bool uploadInFlight = false;
+
+		Buffer stagingBuffer;
+		void* stagingData = nullptr;
+		VkDeviceSize stagingSize = 0;
+		uint32_t maxTilesPerUpdate = 0;
+
+		// Tiles of the in-flight batch (texture, tile) and memory released once the batch completes.
+		std::vector<std::pair<uint32_t, uint32_t>> pendingTiles;
+		std::vector<VmaAllocation> pendingFrees;
+		std::deque<TileEviction> evictions;
+
+		VkDeviceSize memoryBudget = 0;
+		VkDeviceSize bytesResident = 0;
+		uint64_t frame = 0;
+		uint64_t completedFrame = 0;
+		StreamingStatistics statistics;
+	};
+
+	// Streaming requires the "sparse residency" feature and a sparse binding capable general or transfer queue.
+	TextureStreamer CreateTextureStreamer(const BackendData& backendData, VkDeviceSize memoryBudget,
+		uint32_t maxTilesPerUpdate = 64);
+	void DestroyTextureStreamer(const BackendData& backendData, TextureStreamer& streamer);
+
+	// The image stays in the general layout, the mip tail is made resident and uploaded on creation.
+	// Returns the texture index within the streamer or UINT32_MAX if the format cannot be sparsely resident.
+	uint32_t CreateStreamingTexture(const BackendData& backendData, TextureStreamer& streamer, uint32_t width, uint32_t height,
+		uint32_t mipCount, VkFormat format, const TileLoader& loader);
+
+	// The desired mips contain the finest mip level wanted for each region (regionColumns * regionRows values).
+	void SetStreamingFeedback(TextureStreamer& streamer, uint32_t texture, const uint8_t* desiredMips);
+	// Non-blocking, called once per frame; pages in requested tiles and evicts cold ones under the memory budget.
+	void UpdateTextureStreamer(const BackendData& backendData, TextureStreamer& streamer);
+	// The frame (StreamingStatistics::frame) whose rendering is known to be finished, after its fence or timeline value was waited on.
+	// Evicted tiles are only unbound once every frame that could sample them has completed.
+	void SetStreamingCompletedFrame(TextureStreamer& streamer, uint64_t frame);
+
+	const std::vector<uint8_t>& GetStreamingResidency(const TextureStreamer& streamer, uint32_t texture);
+	const StreamingStatistics& GetStreamingStatistics(const TextureStreamer& streamer);
+
+	// ======================== Registry =======================
+
+	// Handles pack a slot index (low 20 bits) with the generation of the slot (high 12 bits), zero is never valid.
+	struct BufferHandle
+	{
+		uint32_t value = 0;
+	};
+
+	struct ImageHandle
+	{
+		uint32_t value = 0;
+	};
+
+	// Last known synchronization state of a resource (the layout is only used by images).
+	struct ResourceState
+	{
+		VkPipelineStageFlags stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		VkAccessFlags access = 0;
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	};
+
+	struct SlotTable
+	{
+		std::vector<uint16_t> generations;
+		std::vector<uint32_t> freeSlots;
+		// Dense list of the live slots, so that iterating them does not touch dead ones.
+		std::vector<uint32_t> liveSlots;
+		std::vector<uint32_t> livePositions;
+	};
+
+	// Structure of arrays indexed by the slot of the handle.
+	struct BufferTable
+	{
+		SlotTable slots;
+		std::vector<VkBuffer> buffers;
+		std::vector<VmaAllocation> allocations;
+		std::vector<VkDeviceMemory> importedMemories;
+		std::vector<VkDeviceAddress> deviceAddresses;
+		std::vector<VkDeviceSize> sizes;
+		std::vector<VkBufferUsageFlags> usages;
+		std::vector<ResourceState> states;
+	};
+
+	struct ImageTable
+	{
+		SlotTable slots;
+		std::vector<VkImage> images;
+		std::vector<VmaAllocation> allocations;
+		std::vector<VkExtent3D> extents;
+		std::vector<VkFormat> formats;
+		std::vector<VkImageUsageFlags> usages;
+		std::vector<ResourceState> states;
+	};
+
+	struct ResourceRegistry
+	{
+		BufferTable buffers;
+		ImageTable images;
+	};
+
+	struct RegistryStatistics
+	{
+		uint32_t liveBuffers = 0;
+		uint32_t liveImages = 0;
+		VkDeviceSize bufferBytes = 0;
+		VkDeviceSize imageBytes = 0;
+	};
+
+	uint32_t GetHandleSlot(uint32_t handleValue);
+
+	// Return a zero handle when the registry is out of slots, the created resources are then destroyed again.
+	BufferHandle RegisterBuffer(ResourceRegistry& registry, const Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage);
+	BufferHandle CreateRegisteredBuffer(const BackendData& backendData, ResourceRegistry& registry, VkBufferUsageFlags usage,
+		VkDeviceSize size, VmaMemoryUsage residency);
+	// Removes the buffer from the registry and hands its ownership back to the caller.
+	Buffer UnregisterBuffer(ResourceRegistry& registry, BufferHandle& handle);
+	void DestroyRegisteredBuffer(const BackendData& backendData, ResourceRegistry& registry, BufferHandle& handle);
+	bool IsHandleValid(const ResourceRegistry& registry, BufferHandle handle);
+	Buffer GetBuffer(const ResourceRegistry& registry, BufferHandle handle);
+	// Null for stale handles.
+	ResourceState* GetBufferState(ResourceRegistry& registry, BufferHandle handle);
+
+	ImageHandle RegisterImage(ResourceRegistry& registry, const Image& image, VkExtent3D extent, VkFormat format, VkImageUsageFlags usage);
+	ImageHandle CreateRegisteredImage2D(const BackendData& backendData, ResourceRegistry& registry, uint32_t width, uint32_t height,
+		uint32_t layerCount, uint32_t mipCount, VkImageUsageFlags usage, VkFormat format, VmaMemoryUsage residency);
+	Image UnregisterImage(ResourceRegistry& registry, ImageHandle& handle);
+	void DestroyRegisteredImage(const BackendData& backendData, ResourceRegistry& registry, ImageHandle& handle);
+	bool IsHandleValid(const ResourceRegistry& registry, ImageHandle handle);
+	Image GetImage(const ResourceRegistry& registry, ImageHandle handle);
+	ResourceState* GetImageState(ResourceRegistry& registry, ImageHandle handle);
+
+	void ForEachBuffer(const ResourceRegistry& registry, const std::function<void(BufferHandle handle, uint32_t slot)>& function);
+	void ForEachImage(const ResourceRegistry& registry, const std::function<void(ImageHandle handle, uint32_t slot)>& function);
+	RegistryStatistics GetRegistryStatistics(const BackendData& backendData, const ResourceRegistry& registry);
+	// Destroys all the live resources.
+	void ClearRegistry(const BackendData& backendData, ResourceRegistry& registry);
+
+	// ====================== Destruction ======================
+
+	struct DeferredDestruction
+	{
+		uint64_t frame;
+		VkObjectType type;
+		uint64_t handle;
+		VmaAllocation allocation;
+	};
+
+	// Objects are tagged with the current frame (or timeline value) and destroyed once the GPU has passed it.
+	struct DeletionQueue
+	{
+		VkDevice logicalDevice = VK_NULL_HANDLE;
+		VmaAllocator allocator = VK_NULL_HANDLE;
+		// The framebuffer cache registered when the queue was created, deferred views and render passes take their framebuffers along.
+		FramebufferCache* framebufferCache = nullptr;
+		// The descriptor set cache registered when the queue was created, invalidated as the resources are actually destroyed.
+		DescriptorSetCache* descriptorSetCache = nullptr;
+
+		std::mutex mutex;
+		std::deque<DeferredDestruction> entries;
+		uint64_t currentFrame = 0;
+		uint64_t completedFrame = 0;
+		uint32_t framesInFlight = 0;
+
+		// Optional background worker doing the actual destruction.
+		std::thread worker;
+		std::condition_variable condition;
+		bool running = false;
+	};
+
+	void CreateDeletionQueue(const BackendData& backendData, DeletionQueue& deletionQueue, uint32_t framesInFlight,
+		bool backgroundThread = false);
+	// Stops the worker and destroys everything that is left, the device must not be using any of the objects anymore.
+	void DestroyDeletionQueue(DeletionQueue& deletionQueue);
+
+	// Starts a new frame after its fence was waited on, the objects deferred frames in flight ago are released.
+	void AdvanceDeletionFrame(DeletionQueue& deletionQueue);
+	// Timeline variant: new objects are tagged with the given value and released once the completed value reaches it.
+	void SetDeletionTimelineValue(DeletionQueue& deletionQueue, uint64_t value);
+	void ReleaseDeletions(DeletionQueue& deletionQueue, uint64_t completedValue);
+	void FlushDeletionQueue(DeletionQueue& deletionQueue);
+
+	void DeferDestroy(DeletionQueue& deletionQueue, VkObjectType type, uint64_t handle, VmaAllocation allocation = VK_NULL_HANDLE);
+	void DeferDestroyBuffer(DeletionQueue& deletionQueue, Buffer& buffer);
+	void DeferDestroyImage(DeletionQueue& deletionQueue, Image& image);
+	void DeferDestroyImageView(DeletionQueue& deletionQueue, VkImageView& imageView);
+	void DeferDestroyImageSampler(DeletionQueue& deletionQueue, VkSampler& sampler);
+	void DeferDestroyFramebuffer(DeletionQueue& deletionQueue, VkFramebuffer& framebuffer);
+	void DeferDestroyRenderPass(DeletionQueue& deletionQueue, VkRenderPass& renderPass);
+	void DeferDestroyPipeline(DeletionQueue& deletionQueue, VkPipeline& pipeline);
+	void DeferDestroyPipelineLayout(DeletionQueue& deletionQueue, VkPipelineLayout& pipelineLayout);
+	void DeferDestroyDescriptorPool(DeletionQueue& deletionQueue, VkDescriptorPool& descriptorPool);
+	void DeferDestroyDescriptorSetLayout(DeletionQueue& deletionQueue, VkDescriptorSetLayout& descriptorSetLayout);
+	void DeferDestroyShaderModule(DeletionQueue& deletionQueue, VkShaderModule& shaderModule);
+	void DeferDestroySemaphore(DeletionQueue& deletionQueue, VkSemaphore& semaphore);
+	void DeferDestroyFence(DeletionQueue& deletionQueue, VkFence& fence);
+	void DeferDestroySwapchain(DeletionQueue& deletionQueue, VkSwapchainKHR& swapchain);
+
+	// ======================== Readback =======================
+
+	// Receives the mapped readback data, it is only valid for the duration of the call.
+	using ReadbackCallback = std::function<void(const void* data, VkDeviceSize size)>;
+
+	struct ReadbackRequest
+	{
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		ReadbackCallback callback;
+	};
+
+	struct ReadbackFrame
+	{
+		Buffer buffer;
+		uint8_t* data = nullptr;
+		VkDeviceSize used = 0;
+		// The frame number (or timeline value) of the submission carrying the copies, valid once submitted.
+		uint64_t submitValue = 0;
+		bool submitted = false;
+		std::vector<ReadbackRequest> requests;
+	};
+
+	// A ring of host-cached readback buffers, each guarded by the frame number (or timeline value) of the submission that
+	// carried its copies, e.g. SwapchainManager::frameNumber while recording and SwapchainManager::completedFrames.
+	struct ReadbackRing
+	{
+		std::vector<ReadbackFrame> frames;
+		uint32_t currentFrame = 0;
+		VkDeviceSize frameCapacity = 0;
+		// False while the current buffer is still in flight, the requests are then dropped.
+		bool recording = false;
+	};
+
+	// The frame count should exceed the number of frames in flight, so that a buffer is always free when a frame begins.
+	ReadbackRing CreateReadbackRing(const BackendData& backendData, uint32_t frameCount, VkDeviceSize frameCapacity);
+	// Pending readbacks are dropped, the device must be done with their copies.
+	void DestroyReadbackRing(const BackendData& backendData, ReadbackRing& ring);
+
+	// Delivers the finished readbacks and moves to the next buffer of the ring, never waits.
+	// Values up to (but excluding) the completed value are known to have finished on the GPU.
+	void BeginReadbackFrame(const BackendData& backendData, ReadbackRing& ring, uint64_t completedValue);
+	// The requests record their copies into the given command buffer, the source has to be ready for transfer reads.
+	bool RequestBufferReadback(const BackendData& backendData, ReadbackRing& ring, VkCommandBuffer commandBuffer, VkBuffer source,
+		VkDeviceSize offset, VkDeviceSize size, const ReadbackCallback& callback);
+	bool RequestImageReadback(const BackendData& backendData, ReadbackRing& ring, VkCommandBuffer commandBuffer, VkImage source,
+		VkImageLayout layout, VkImageAspectFlags aspect, uint32_t bytesPerTexel, VkOffset2D offset, VkExtent2D extent,
+		const ReadbackCallback& callback, uint32_t mipLevel = 0, uint32_t arrayLayer = 0);
+	// Records the host visibility barrier, the submit value identifies the submission the command buffer goes into.
+	void EndReadbackFrame(ReadbackRing& ring, VkCommandBuffer commandBuffer, uint64_t submitValue);
+	// Delivers all the readbacks whose submissions have already finished on the GPU, never waits.
+	void PollReadbacks(const BackendData& backendData, ReadbackRing& ring, uint64_t completedValue);
+
+	// Writes 8-bit RGBA (or BGRA, swizzled on the way) pixels as an uncompressed PNG, meant for debug and benchmark dumps.
+	bool WriteImagePNG(const char* path, uint32_t width, uint32_t height, const void* pixels, bool bgra = false);
+
+	// ======================== Staging ========================
+
+	struct StagingSubmission
+	{
+		VkFence fence;
+		VkDeviceSize end;
+	};
+
+	// Persistently mapped upload buffer, the space is reused once the fences of the submissions reading it are signaled.
+	struct StagingRing
+	{
+		Buffer buffer;
+		uint8_t* data = nullptr;
+		VkDeviceSize capacity = 0;
+		VkDeviceSize head = 0;
+		VkDeviceSize tail = 0;
+		bool hasOpenAllocations = false;
+		std::deque<StagingSubmission> submissions;
+		std::vector<VkFence> freeFences;
+	};
+
+	StagingRing CreateStagingRing(const BackendData& backendData, VkDeviceSize capacity);
+	void DestroyStagingRing(const BackendData& backendData, StagingRing& ring);
+
+	// Waits for older submissions only when the ring is full, fails if the request can never fit.
+	bool AllocateStaging(const BackendData& backendData, StagingRing& ring, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	// Submits the recorded command buffer that reads the allocations made since the last call, the ring fences that submission itself.
+	bool SubmitStaging(const BackendData& backendData, StagingRing& ring, VkQueue queue, VkCommandBuffer commandBuffer);
+	void RetireStaging(const BackendData& backendData, StagingRing& ring);
+
+	// ======================== Textures =======================
+
+	struct Texture
+	{
+		Image image;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t layerCount = 0;
+		uint32_t mipCount = 0;
+	};
+
+	// Loads a KTX2 or DDS file (detected from its contents) by mapping it and copying the levels straight into the staging ring.
+	// The upload is recorded into the command buffer as one batched copy and the image ends in the shader read only layout.
+	// Block-compressed data is passed through as is, cube maps are loaded as 6-layer arrays.
+	Texture LoadTexture(const BackendData& backendData, StagingRing& ring, VkCommandBuffer commandBuffer, const char* path,
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT);
+	void DestroyTexture(const BackendData& backendData, Texture& texture);
+
 	// ====================== Presentation =====================
 
 	VkSwapchainKHR CreateSwapchain(const BackendData& backendData, const SurfaceData& surfaceData,
@@ -158,9 +734,119 @@ namespace VulkanBackend
 	void GetSwapchainImages(const BackendData& backendData, VkSwapchainKHR swapchain, std::vector<VkImage>& images);
 
 	VkFramebuffer CreateFramebuffer(const BackendData& backendData, uint32_t width, uint32_t height, VkRenderPass renderPass,
-		const std::vector<VkImageView>& attachments);
+		const std::vector<VkImageView>& attachments, uint32_t layers = 1);
 	void DestroyFramebuffer(const BackendData& backendData, VkFramebuffer& framebuffer);
 
+	struct SwapchainFrame
+	{
+		VkSemaphore imageAcquired;
+		VkFence inFlight;
+		VkCommandPool commandPool;
+		VkCommandBuffer commandBuffer;
+	};
+
+	// Kept alive until all the frames that could have used it have finished.
+	struct RetiredSwapchain
+	{
+		VkSwapchainKHR swapchain;
+		std::vector<VkImageView> imageViews;
+		std::vector<VkSemaphore> renderFinished;
+		uint64_t retireFrame;
+	};
+
+	struct SwapchainManager
+	{
+		VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+		VkImageUsageFlags imageUsage = 0;
+		std::vector<VkImage> images;
+		std::vector<VkImageView> imageViews;
+		// One per image, the presentation engine may still wait on it after the frame fence has been signaled.
+		std::vector<VkSemaphore> renderFinished;
+		std::vector<SwapchainFrame> frames;
+		std::vector<RetiredSwapchain> retired;
+		uint32_t currentFrame = 0;
+		uint32_t imageIndex = 0;
+		uint64_t frameNumber = 0;
+		// The frames numbered below this value have finished on the GPU, advanced whenever a frame slot has been waited on.
+		uint64_t completedFrames = 0;
+		// Ids attached to the presents when VK_KHR_present_id is enabled, they keep increasing across recreations.
+		uint64_t presentId = 0;
+		uint64_t swapchainFirstPresentId = 1;
+		bool needsRecreation = false;
+	};
+
+	// The surface data must be fully initialized (including the selected present queue).
+	SwapchainManager CreateSwapchainManager(const BackendData& backendData, SurfaceData& surfaceData, uint32_t framesInFlight = 2,
+		VkImageUsageFlags imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+	void DestroySwapchainManager(const BackendData& backendData, const SurfaceData& surfaceData, SwapchainManager& manager);
+
+	// Waits for the frame slot, acquires the next image and returns the frame's command buffer in the recording state.
+	// Returns null when no frame can be rendered now (e.g. a minimized window), the frame must then be skipped.
+	// Out of date and suboptimal swapchains are recreated through oldSwapchain, the device is never idled.
+	VkCommandBuffer BeginSwapchainFrame(const BackendData& backendData, SurfaceData& surfaceData, SwapchainManager& manager);
+	// Submits the command buffer (waiting for the acquired image) to the first general queue and presents the image on queue,
+	// which must support presenting to the surface (e.g. surfaceData.defaultPresentQueue).
+	void EndSwapchainFrame(const BackendData& backendData, const SurfaceData& surfaceData, SwapchainManager& manager, VkQueue queue);
+	// Recreates the swapchain on the next frame with the new window size.
+	void ResizeSwapchain(SurfaceData& surfaceData, SwapchainManager& manager, uint32_t width, uint32_t height);
+
+	// ====================== Frame Pacing =====================
+
+	enum class FramePacingMode : uint8_t
+	{
+		// Frames start as soon as a frame slot is free.
+		Unthrottled,
+		// Frames start once the previous ones have been presented (or finished on the GPU without present wait).
+		LowLatency,
+		// Low latency with frame starts additionally spaced by the target frame time.
+		TargetFrameTime
+	};
+
+	struct FrameLatency
+	{
+		uint64_t presentId;
+		double milliseconds;
+	};
+
+	// Raw per-frame values, nothing is averaged.
+	struct FramePacingStatistics
+	{
+		double lastLatencyMilliseconds = 0.0;
+		double lastFrameTimeMilliseconds = 0.0;
+		uint64_t latencySamples = 0;
+		// Latencies of the most recent measured presents, oldest first.
+		std::deque<FrameLatency> latencies;
+	};
+
+	struct FramePacer
+	{
+		FramePacingMode mode = FramePacingMode::Unthrottled;
+		double targetFrameTimeMilliseconds = 0.0;
+		// Number of presented frames allowed to be queued ahead of the display.
+		uint32_t maxQueuedFrames = 1;
+		bool presentWaitAvailable = false;
+#ifdef VK_KHR_present_wait
+		PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+#endif
+		uint64_t lastFrameStart = 0;
+		uint64_t waitedPresentId = 0;
+		// Input timestamps of the frames still waiting to be presented, keyed by their present id.
+		// Each latency ends when the present wait for the id of its frame returns, frames already presented before the wait are not measured.
+		// Without present wait, the latency is measured up to the GPU completion of the frame instead.
+		std::deque<std::pair<uint64_t, uint64_t>> pendingInputs;
+		FramePacingStatistics statistics;
+	};
+
+	FramePacer CreateFramePacer(const BackendData& backendData, FramePacingMode mode, double targetFrameTimeMilliseconds = 0.0,
+		uint32_t maxQueuedFrames = 1);
+	void SetFramePacingMode(FramePacer& pacer, FramePacingMode mode, double targetFrameTimeMilliseconds = 0.0);
+
+	// Blocks until the next frame may start, called before BeginSwapchainFrame.
+	void PaceFrame(const BackendData& backendData, FramePacer& pacer, const SwapchainManager& manager);
+	// Marks the moment the input for the upcoming frame was sampled, the latency is measured from it to the present.
+	void MarkFrameInput(FramePacer& pacer, const SwapchainManager& manager);
+	FramePacingStatistics GetFramePacingStatistics(const FramePacer& pacer);
+
 	// ======================== Pipeline =======================
 
 	VkRenderPass CreateRenderPass(const BackendData& backendData, const SurfaceData& surfaceData, bool depth = false,
@@ -178,10 +864,441 @@ namespace VulkanBackend
 		VkBool32 depthWriteEnable, VkCompareOp compareOp, VkSampleCountFlagBits sampleCount, const std::vector<VkDynamicState>& dynamicStates,
 		VkPipelineVertexInputStateCreateInfo& vertexInputState, VkRenderPass renderPass, VkPipelineLayout pipelineLayout,
 		const std::vector<VkPipelineShaderStageCreateInfo>& shaderStages, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+#ifdef VK_KHR_dynamic_rendering
+	// Dynamic rendering variant, the pipeline is compatible with any rendering using the same attachment formats.
+	VkPipeline CreateGraphicsPipeline(const BackendData& backendData, VkPrimitiveTopology primitiveTopology, VkPolygonMode polygonMode,
+		VkCullModeFlags cullMode, VkFrontFace frontFace, VkColorComponentFlags colorComponents, VkBool32 depthTestEnable,
+		VkBool32 depthWriteEnable, VkCompareOp compareOp, VkSampleCountFlagBits sampleCount, const std::vector<VkDynamicState>& dynamicStates,
+		VkPipelineVertexInputStateCreateInfo& vertexInputState, const std::vector<VkFormat>& colorFormats, VkFormat depthFormat,
+		VkFormat stencilFormat, VkPipelineLayout pipelineLayout, const std::vector<VkPipelineShaderStageCreateInfo>& shaderStages,
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+#endif
 	VkPipeline CreateComputePipeline(const BackendData& backendData, VkPipelineLayout pipelineLayout,
 		const VkPipelineShaderStageCreateInfo& shaderStage, VkPipelineCache pipelineCache);
 	void DestroyPipeline(const BackendData& backendData, VkPipeline& pipeline);
 
+	// ==================== Pipeline Layout ====================
+
+	struct DescriptorSetLayoutDescription
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		VkDescriptorSetLayoutCreateFlags flags = 0;
+	};
+
+	// Sets are indexed by their set number, sets without any bindings get an empty layout.
+	// Ordering the sets by their update frequency (per frame, per material, per draw) avoids rebinding the unchanged ones.
+	struct PipelineLayoutDescription
+	{
+		std::vector<DescriptorSetLayoutDescription> sets;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+	};
+
+	void AddDescriptorBinding(PipelineLayoutDescription& description, uint32_t set, uint32_t binding, VkDescriptorType type,
+		VkShaderStageFlags stages, uint32_t descriptorCount = 1);
+	void AddPushConstantRange(PipelineLayoutDescription& description, VkShaderStageFlags stages, uint32_t offset, uint32_t size);
+
+	VkDescriptorSetLayout CreateDescriptorSetLayout(const BackendData& backendData, const DescriptorSetLayoutDescription& description);
+	VkPipelineLayout CreatePipelineLayout(const BackendData& backendData, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+		const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+	// The immutable sampler pointers of the cached description point into immutableSamplers, a copy of the caller's handles.
+	struct DescriptorSetLayoutCacheEntry
+	{
+		DescriptorSetLayoutDescription description;
+		std::vector<VkSampler> immutableSamplers;
+		VkDescriptorSetLayout descriptorSetLayout;
+	};
+
+	struct PipelineLayoutCacheEntry
+	{
+		PipelineLayoutDescription description;
+		std::vector<VkSampler> immutableSamplers;
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+		VkPipelineLayout pipelineLayout;
+	};
+
+	// Layouts are owned by the cache and live until it is destroyed. Pipeline layouts share the set layouts of the cache,
+	// so identical sets of different pipeline layouts stay compatible for binding.
+	struct LayoutCache
+	{
+		std::mutex mutex;
+		std::unordered_multimap<size_t, DescriptorSetLayoutCacheEntry> descriptorSetLayouts;
+		std::unordered_multimap<size_t, PipelineLayoutCacheEntry> pipelineLayouts;
+		CacheStatistics statistics;
+	};
+
+	VkDescriptorSetLayout AcquireDescriptorSetLayout(const BackendData& backendData, LayoutCache& cache,
+		const DescriptorSetLayoutDescription& description);
+	// Returns a null handle when the description exceeds the device limits.
+	VkPipelineLayout AcquirePipelineLayout(const BackendData& backendData, LayoutCache& cache, const PipelineLayoutDescription& description);
+	void DestroyLayoutCache(const BackendData& backendData, LayoutCache& cache);
+	CacheStatistics GetLayoutCacheStatistics(LayoutCache& cache);
+
+	// ====================== Render Pass ======================
+
+	struct SubpassDescription
+	{
+		std::vector<VkAttachmentReference> colorAttachments;
+		// Either empty or one per color attachment (VK_ATTACHMENT_UNUSED for the ones that are not resolved).
+		std::vector<VkAttachmentReference> resolveAttachments;
+		std::vector<VkAttachmentReference> inputAttachments;
+		std::vector<uint32_t> preserveAttachments;
+		VkAttachmentReference depthStencilAttachment = { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+	};
+
+	struct RenderPassDescription
+	{
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<SubpassDescription> subpasses;
+		std::vector<VkSubpassDependency> dependencies;
+	};
+
+	// Returns the index of the attachment within the description.
+	uint32_t AddColorAttachment(RenderPassDescription& description, VkFormat format, VkSampleCountFlagBits samples,
+		VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkImageLayout initialLayout, VkImageLayout finalLayout);
+	uint32_t AddDepthStencilAttachment(RenderPassDescription& description, VkFormat format, VkSampleCountFlagBits samples,
+		VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkAttachmentLoadOp stencilLoadOp, VkAttachmentStoreOp stencilStoreOp,
+		VkImageLayout initialLayout, VkImageLayout finalLayout);
+	// The reference layouts are derived from the attachment formats. Resolve attachments pair with the color attachments.
+	// Returns the index of the subpass.
+	uint32_t AddSubpass(RenderPassDescription& description, const std::vector<uint32_t>& colorAttachments,
+		uint32_t depthStencilAttachment = VK_ATTACHMENT_UNUSED, const std::vector<uint32_t>& inputAttachments = {},
+		const std::vector<uint32_t>& resolveAttachments = {}, const std::vector<uint32_t>& preserveAttachments = {});
+	void AddSubpassDependency(RenderPassDescription& description, uint32_t sourceSubpass, uint32_t destinationSubpass,
+		VkPipelineStageFlags sourceStage, VkPipelineStageFlags destinationStage, VkAccessFlags sourceAccessMask,
+		VkAccessFlags destinationAccessMask, VkDependencyFlags flags = VK_DEPENDENCY_BY_REGION_BIT);
+
+	// Returns null if a subpass exceeds the device limits.
+	VkRenderPass CreateRenderPass(const BackendData& backendData, const RenderPassDescription& description);
+
+	struct RenderPassCacheEntry
+	{
+		RenderPassDescription description;
+		VkRenderPass renderPass;
+	};
+
+	// Render passes are owned by the cache and live until it is destroyed, framebuffers using them have to be evicted first.
+	struct RenderPassCache
+	{
+		std::mutex mutex;
+		std::unordered_multimap<size_t, RenderPassCacheEntry> entries;
+		CacheStatistics statistics;
+	};
+
+	VkRenderPass AcquireRenderPass(const BackendData& backendData, RenderPassCache& cache, const RenderPassDescription& description);
+	void DestroyRenderPassCache(const BackendData& backendData, RenderPassCache& cache);
+	CacheStatistics GetRenderPassCacheStatistics(RenderPassCache& cache);
+
+	// =================== Dynamic Rendering ===================
+
+#ifdef VK_KHR_dynamic_rendering
+	VkRenderingAttachmentInfoKHR GetRenderingAttachmentInfo(VkImageView imageView, VkImageLayout layout, VkAttachmentLoadOp loadOp,
+		VkAttachmentStoreOp storeOp, VkClearValue clearValue = {});
+	// Resolves the (multisampled) attachment into the resolve view at the end of the rendering.
+	VkRenderingAttachmentInfoKHR GetRenderingAttachmentInfo(VkImageView imageView, VkImageLayout layout, VkAttachmentLoadOp loadOp,
+		VkAttachmentStoreOp storeOp, VkClearValue clearValue, VkImageView resolveImageView, VkImageLayout resolveLayout,
+		VkResolveModeFlagBits resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT_KHR);
+
+	// Replaces the render pass and framebuffer objects, the attachments have to be transitioned into their layouts beforehand.
+	void BeginRendering(const BackendData& backendData, VkCommandBuffer commandBuffer, VkRect2D renderArea,
+		const std::vector<VkRenderingAttachmentInfoKHR>& colorAttachments, const VkRenderingAttachmentInfoKHR* depthAttachment = nullptr,
+		const VkRenderingAttachmentInfoKHR* stencilAttachment = nullptr, uint32_t layerCount = 1);
+	void EndRendering(const BackendData& backendData, VkCommandBuffer commandBuffer);
+#endif
+
+	// ===================== Dynamic State =====================
+
+	// Core dynamic states are always supported, the extended ones depend on the enabled extensions and features.
+	bool IsDynamicStateSupported(const BackendData& backendData, VkDynamicState state);
+
+	// The setters must only be used for states that are supported and dynamic in the bound pipeline.
+	void SetCullMode(const BackendData& backendData, VkCommandBuffer commandBuffer, VkCullModeFlags cullMode);
+	void SetFrontFace(const BackendData& backendData, VkCommandBuffer commandBuffer, VkFrontFace frontFace);
+	void SetPrimitiveTopology(const BackendData& backendData, VkCommandBuffer commandBuffer, VkPrimitiveTopology topology);
+	void SetDepthTestEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable);
+	void SetDepthWriteEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable);
+	void SetDepthCompareOp(const BackendData& backendData, VkCommandBuffer commandBuffer, VkCompareOp compareOp);
+	void SetStencilTestEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable);
+#ifdef VK_EXT_extended_dynamic_state2
+	void SetRasterizerDiscardEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable);
+	void SetDepthBiasEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable);
+	void SetPrimitiveRestartEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable);
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+	void SetPolygonMode(const BackendData& backendData, VkCommandBuffer commandBuffer, VkPolygonMode polygonMode);
+	void SetRasterizationSamples(const BackendData& backendData, VkCommandBuffer commandBuffer, VkSampleCountFlagBits samples);
+	void SetColorBlendEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, uint32_t firstAttachment,
+		const std::vector<VkBool32>& enables);
+	void SetColorWriteMask(const BackendData& backendData, VkCommandBuffer commandBuffer, uint32_t firstAttachment,
+		const std::vector<VkColorComponentFlags>& writeMasks);
+#endif
+
+	// ==================== Specialization =====================
+
+	// Packed constant values with their map entries, the source of a VkSpecializationInfo.
+	struct SpecializationConstants
+	{
+		std::vector<VkSpecializationMapEntry> entries;
+		std::vector<uint8_t> data;
+	};
+
+	// Sets or replaces the value of a constant.
+	void SetSpecializationConstant(SpecializationConstants& constants, uint32_t constantId, const void* value, size_t size);
+	// SPIR-V booleans are 32 bits wide.
+	void SetSpecializationConstant(SpecializationConstants& constants, uint32_t constantId, bool value);
+	template<typename T>
+	void SetSpecializationConstant(SpecializationConstants& constants, uint32_t constantId, const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Specialization constants must be trivially copyable.");
+		SetSpecializationConstant(constants, constantId, &value, sizeof(T));
+	}
+
+	// Sorts the constants by id and repacks their data, so that equal values set in any order compare equal.
+	SpecializationConstants SortSpecializationConstants(const SpecializationConstants& constants);
+	// The info points into the constants, which have to outlive it.
+	VkSpecializationInfo GetSpecializationInfo(const SpecializationConstants& constants);
+
+	// ================== Pipeline Collection ==================
+
+	struct PipelineShaderStage
+	{
+		VkShaderStageFlagBits stage;
+		VkShaderModule module;
+		std::string entryPoint = "main";
+		SpecializationConstants specialization;
+	};
+
+	// The complete state of a graphics pipeline, usable as a deduplication key.
+	struct GraphicsPipelineDescription
+	{
+		std::vector<PipelineShaderStage> shaderStages;
+		std::vector<VkVertexInputBindingDescription> vertexBindings;
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+		VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkBool32 primitiveRestartEnable = VK_FALSE;
+		VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+		VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+		VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		VkBool32 rasterizerDiscardEnable = VK_FALSE;
+		VkBool32 depthBiasEnable = VK_FALSE;
+		VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT;
+		VkBool32 depthTestEnable = VK_FALSE;
+		VkBool32 depthWriteEnable = VK_FALSE;
+		VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		VkBool32 stencilTestEnable = VK_FALSE;
+		// One per color attachment.
+		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
+		std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		uint32_t subpass = 0;
+		// Attachment formats for dynamic rendering, used when there is no render pass.
+		std::vector<VkFormat> colorFormats;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+		VkFormat stencilFormat = VK_FORMAT_UNDEFINED;
+	};
+
+	VkPipelineColorBlendAttachmentState GetColorBlendAttachmentState(VkBool32 blendEnable,
+		VkColorComponentFlags colorComponents = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
+
+	// Drops the dynamic states the device does not support (they are baked instead) and resets the state covered by
+	// the remaining ones, so that descriptions differing only in dynamic state compare equal.
+	GraphicsPipelineDescription NormalizeGraphicsPipelineDescription(const BackendData& backendData, const GraphicsPipelineDescription& description);
+	VkPipeline CreateGraphicsPipeline(const BackendData& backendData, const GraphicsPipelineDescription& description,
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+	struct ComputePipelineDescription
+	{
+		PipelineShaderStage shaderStage;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+	};
+
+	VkPipeline CreateComputePipeline(const BackendData& backendData, const ComputePipelineDescription& description,
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+	// The comparisons the collection deduplicates with, the specialization constants have to be sorted for equal ones to match.
+	size_t HashGraphicsPipelineDescription(const GraphicsPipelineDescription& description);
+	bool GraphicsPipelineDescriptionsEqual(const GraphicsPipelineDescription& a, const GraphicsPipelineDescription& b);
+	size_t HashComputePipelineDescription(const ComputePipelineDescription& description);
+	bool ComputePipelineDescriptionsEqual(const ComputePipelineDescription& a, const ComputePipelineDescription& b);
+
+	struct ComputePipelineCollectionEntry
+	{
+		ComputePipelineDescription description;
+		VkPipeline pipeline;
+	};
+
+	struct GraphicsPipelineCollectionEntry
+	{
+		GraphicsPipelineDescription description;
+		VkPipeline pipeline;
+		// Linked from libraries without link time optimization, until the optimized pipeline replaces it.
+		bool linked;
+	};
+
+	// One part (VkGraphicsPipelineLibraryFlagBitsEXT) of a graphics pipeline, the description only holds the state of that part.
+	struct GraphicsPipelineLibraryEntry
+	{
+		uint32_t part;
+		GraphicsPipelineDescription description;
+		VkPipeline library;
+	};
+
+	struct PipelineOptimization
+	{
+		size_t hash;
+		GraphicsPipelineDescription description;
+		DeletionQueue* deletionQueue;
+	};
+
+	struct PipelineRecorder;
+
+	// Deduplicates pipelines by their normalized descriptions, the pipelines are owned by the collection.
+	struct PipelineCollection
+	{
+		std::mutex mutex;
+		std::unordered_multimap<size_t, GraphicsPipelineCollectionEntry> graphicsPipelines;
+		std::unordered_multimap<size_t, GraphicsPipelineLibraryEntry> libraries;
+		std::unordered_multimap<size_t, ComputePipelineCollectionEntry> computePipelines;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		CacheStatistics statistics;
+		// Optional, receives the description of every pipeline compiled by the collection.
+		PipelineRecorder* recorder = nullptr;
+
+		// Background worker compiling the optimized versions of linked pipelines, started on first use.
+		std::thread optimizer;
+		std::condition_variable optimizerCondition;
+		std::deque<PipelineOptimization> pendingOptimizations;
+		bool optimizerRunning = false;
+	};
+
+	// Thread-safe, the compilation of a missing pipeline does not block the lookups of other threads.
+	VkPipeline AcquireGraphicsPipeline(const BackendData& backendData, PipelineCollection& collection, const GraphicsPipelineDescription& description);
+	// Links a missing pipeline from cached vertex input, pre-rasterization, fragment shader and fragment output libraries
+	// (VK_EXT_graphics_pipeline_library), falling back to a full compile without the extension. With a deletion queue,
+	// an optimized pipeline is compiled in the background and returned by later acquires, the linked one is then deferred
+	// to the queue, so callers should acquire again every frame instead of keeping the pipeline.
+	VkPipeline AcquireLinkedGraphicsPipeline(const BackendData& backendData, PipelineCollection& collection,
+		const GraphicsPipelineDescription& description, DeletionQueue* deletionQueue = nullptr);
+	// Each distinct set of specialization constants gets its own fully optimized pipeline from the same shader module.
+	VkPipeline AcquireComputePipeline(const BackendData& backendData, PipelineCollection& collection, const ComputePipelineDescription& description);
+	// Finishes the queued background optimizations before stopping the worker, so their deletion queues must still exist.
+	// The device must not be using any of the pipelines anymore.
+	void DestroyPipelineCollection(const BackendData& backendData, PipelineCollection& collection);
+	CacheStatistics GetPipelineCollectionStatistics(PipelineCollection& collection);
+
+	// ================ Asynchronous Pipelines =================
+
+	struct AsyncPipelineHandle
+	{
+		uint32_t value = 0;
+		// Entries are recycled, handles of an earlier use of the entry do not match its current generation.
+		uint32_t generation = 0;
+	};
+
+	struct AsyncPipelineEntry
+	{
+		bool compute;
+		GraphicsPipelineDescription graphicsDescription;
+		ComputePipelineDescription computeDescription;
+		size_t hash;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkPipeline fallback = VK_NULL_HANDLE;
+		bool ready = false;
+		uint64_t requestTime;
+		// Requests sharing the entry, it is recycled once all of them have been released.
+		uint32_t references = 0;
+		uint32_t generation = 0;
+		// Where the pipeline goes when it is released before its compilation has finished.
+		DeletionQueue* deletionQueue = nullptr;
+	};
+
+	struct AsyncPipelineStatistics
+	{
+		uint64_t requested = 0;
+		// Requests answered with the handle of an identical earlier request.
+		uint64_t deduplicated = 0;
+		uint64_t completed = 0;
+		// Time from the request to the pipeline being ready, including the time spent in the queue.
+		double averageLatencyMilliseconds = 0.0;
+		double maxLatencyMilliseconds = 0.0;
+		double averageCompileMilliseconds = 0.0;
+		// Lookups of pending pipelines answered with the fallback or with a null handle.
+		uint64_t fallbackUses = 0;
+		uint64_t skippedLookups = 0;
+	};
+
+	struct AsyncPipelineCompiler
+	{
+		const BackendData* backendData = nullptr;
+		// Optional, the pipelines are deduplicated and owned by the collection when set.
+		PipelineCollection* collection = nullptr;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::condition_variable completedCondition;
+		std::vector<std::thread> workers;
+		bool running = false;
+		std::deque<uint32_t> pendingEntries;
+		// Handles are the entry indices plus one, released entries are reused by later requests.
+		std::deque<AsyncPipelineEntry> entries;
+		std::vector<uint32_t> freeEntries;
+		// Live entries by the hash of their description, identical requests share one entry.
+		std::unordered_multimap<size_t, uint32_t> entryIndices;
+		AsyncPipelineStatistics statistics;
+	};
+
+	void CreateAsyncPipelineCompiler(const BackendData& backendData, AsyncPipelineCompiler& compiler, uint32_t threadCount,
+		PipelineCollection* collection = nullptr, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+	// Finishes the queued compilations, the device must not be using any of the owned pipelines anymore.
+	void DestroyAsyncPipelineCompiler(AsyncPipelineCompiler& compiler);
+
+	// The fallback is used while the pipeline is pending, a null fallback means the draws should be skipped in the meantime.
+	// A request identical to a live one shares its entry (and keeps its fallback), every request needs its own release.
+	AsyncPipelineHandle RequestGraphicsPipeline(AsyncPipelineCompiler& compiler, const GraphicsPipelineDescription& description,
+		VkPipeline fallback = VK_NULL_HANDLE);
+	AsyncPipelineHandle RequestComputePipeline(AsyncPipelineCompiler& compiler, const ComputePipelineDescription& description,
+		VkPipeline fallback = VK_NULL_HANDLE);
+	// Once the last request of an entry is released, its pipeline is destroyed (deferred to the queue when one is given, left to
+	// the collection when attached) and the entry is reused. A pending compilation is skipped or its result discarded.
+	void ReleaseAsyncPipeline(AsyncPipelineCompiler& compiler, AsyncPipelineHandle& handle, DeletionQueue* deletionQueue = nullptr);
+	bool IsAsyncPipelineReady(AsyncPipelineCompiler& compiler, AsyncPipelineHandle handle);
+	// Returns the pipeline once it is ready and the fallback (possibly null) until then, never blocks.
+	VkPipeline GetAsyncPipeline(AsyncPipelineCompiler& compiler, AsyncPipelineHandle handle);
+	// Blocks until the pipeline is ready, e.g. for loading screens. Returns null if the handle is released in the meantime.
+	VkPipeline WaitForAsyncPipeline(AsyncPipelineCompiler& compiler, AsyncPipelineHandle handle);
+	AsyncPipelineStatistics GetAsyncPipelineStatistics(AsyncPipelineCompiler& compiler);
+
+	// =================== Pipeline Manifest ===================
+
+	// Handles differ between runs, so the manifest refers to the shader modules, layouts and render passes by stable keys
+	// (e.g. hashes of the shader code or asset ids). The same keys resolve them back to handles when replaying.
+	struct PipelineRecorder
+	{
+		std::mutex mutex;
+		std::unordered_map<uint64_t, uint64_t> objectKeys;
+		std::unordered_map<uint64_t, uint64_t> keyObjects;
+		// Serialized pipeline records without the file header.
+		std::vector<uint8_t> manifest;
+		uint32_t recordedPipelines = 0;
+		// Pipelines referencing objects without a key cannot be replayed and are left out.
+		uint32_t skippedPipelines = 0;
+	};
+
+	// The handle of a shader module, pipeline layout or render pass cast to uint64_t.
+	void SetPipelineObjectKey(PipelineRecorder& recorder, uint64_t handle, uint64_t key);
+	void RecordGraphicsPipeline(PipelineRecorder& recorder, const GraphicsPipelineDescription& description);
+	void RecordComputePipeline(PipelineRecorder& recorder, const ComputePipelineDescription& description);
+
+	bool SavePipelineManifest(PipelineRecorder& recorder, const std::string& path);
+	bool LoadPipelineManifest(const std::string& path, std::vector<uint8_t>& manifest);
+	// Requests every pipeline of the manifest whose objects have been given keys, on the worker threads of the compiler.
+	// With a collection set on the compiler, the later acquires of the same pipelines are hits. Records failing their checksum
+	// or holding values that are out of range for the device are dropped.
+	std::vector<AsyncPipelineHandle> ReplayPipelineManifest(AsyncPipelineCompiler& compiler, PipelineRecorder& recorder,
+		const std::vector<uint8_t>& manifest);
+
 	// ========================= Shader ========================
 
 	VkDescriptorPool CreateDescriptorPool(const BackendData& backendData, const std::vector<VkDescriptorPoolSize> poolSizes, uint32_t maxSets);
@@ -200,4 +1317,200 @@ namespace VulkanBackend
 		const std::vector<VkDescriptorImageInfo>& imageDescriptors,
 		const std::vector<VkDescriptorImageInfo>& storageBufferDescriptors,
 		const std::vector<VkDescriptorImageInfo>& uniformBufferDescriptors);
+
+	// ================= Descriptor Allocator ==================
+
+	struct DescriptorTypeRatio
+	{
+		VkDescriptorType type;
+		float descriptorsPerSet;
+	};
+
+	struct DescriptorAllocatorStatistics
+	{
+		uint64_t allocatedSets = 0;
+		uint32_t livePools = 0;
+		// Pools that ran out of space and had to be chained.
+		uint64_t overflows = 0;
+	};
+
+	// Sets are bump-allocated from pools without the free bit and released all at once by resetting the allocator,
+	// one allocator per frame in flight (and per recording thread). Not thread-safe.
+	struct DescriptorAllocator
+	{
+		uint32_t setsPerPool = 0;
+		std::vector<DescriptorTypeRatio> ratios;
+		VkDescriptorPool currentPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorPool> fullPools;
+		std::vector<VkDescriptorPool> freePools;
+
+		// Allocations since the last reset, they adapt the ratios of the pools created afterwards.
+		std::vector<VkDescriptorPoolSize> observedDescriptors;
+		uint32_t observedSets = 0;
+		uint32_t poolsUsed = 0;
+		DescriptorAllocatorStatistics statistics;
+	};
+
+	// Empty ratios start from a general mix of buffers and images.
+	void CreateDescriptorAllocator(DescriptorAllocator& allocator, uint32_t setsPerPool = 256,
+		const std::vector<DescriptorTypeRatio>& ratios = {});
+	void DestroyDescriptorAllocator(const BackendData& backendData, DescriptorAllocator& allocator);
+	// The description of the layout feeds the observed type ratios and guarantees that a new pool can hold the set.
+	// Returns a null handle if the set cannot be allocated even from a new pool.
+	VkDescriptorSet AllocateDescriptorSet(const BackendData& backendData, DescriptorAllocator& allocator, VkDescriptorSetLayout descriptorSetLayout,
+		const DescriptorSetLayoutDescription& description);
+	// Releases all the sets, the device must have finished using them (e.g. after the fence of the frame was waited on).
+	void ResetDescriptorAllocator(const BackendData& backendData, DescriptorAllocator& allocator);
+	DescriptorAllocatorStatistics GetDescriptorAllocatorStatistics(const DescriptorAllocator& allocator);
+
+	// ================= Descriptor Set Cache ==================
+
+	// A single descriptor, the unused fields stay zero. The 32-bit fields come first, so the structure has no padding.
+	struct DescriptorBinding
+	{
+		uint32_t binding;
+		uint32_t arrayElement;
+		VkDescriptorType type;
+		VkImageLayout imageLayout;
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		VkDeviceSize range;
+		VkImageView imageView;
+		VkSampler sampler;
+	};
+
+	struct DescriptorSetContents
+	{
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		std::vector<DescriptorBinding> bindings;
+	};
+
+	void BindDescriptorBuffer(DescriptorSetContents& contents, uint32_t binding, VkDescriptorType type, VkBuffer buffer,
+		VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE, uint32_t arrayElement = 0);
+	void BindDescriptorImage(DescriptorSetContents& contents, uint32_t binding, VkDescriptorType type, VkImageView imageView,
+		VkImageLayout imageLayout, VkSampler sampler = VK_NULL_HANDLE, uint32_t arrayElement = 0);
+	void WriteDescriptorSet(const BackendData& backendData, VkDescriptorSet descriptorSet, const DescriptorSetContents& contents);
+
+	struct DescriptorSetCacheEntry
+	{
+		DescriptorSetContents contents;
+		VkDescriptorSet descriptorSet;
+	};
+
+	// Sets are written once per distinct contents and reused for as long as all of their resources live.
+	struct DescriptorSetCache
+	{
+		std::mutex mutex;
+		DescriptorAllocator allocator;
+		std::unordered_multimap<size_t, DescriptorSetCacheEntry> entries;
+		// The hashes and sets of the entries referencing each buffer, image view and sampler.
+		std::unordered_map<uint64_t, std::vector<std::pair<size_t, VkDescriptorSet>>> resourceEntries;
+		// Sets of invalidated entries, rewritten by later misses with the same layout.
+		std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> recycledSets;
+		CacheStatistics statistics;
+	};
+
+	void CreateDescriptorSetCache(DescriptorSetCache& cache, uint32_t setsPerPool = 256);
+	void DestroyDescriptorSetCache(const BackendData& backendData, DescriptorSetCache& cache);
+	// Once registered, DestroyBuffer, DestroyImageView, DestroyImageSampler (and so the sampler cache) and the deletion queues
+	// created afterwards invalidate through the cache. Registering a null cache stops that, before the registered one is destroyed.
+	void RegisterDescriptorSetCache(BackendData& backendData, DescriptorSetCache* cache);
+	// The description of the contents' layout sizes the pools of the cache. Returns a null handle if no set could be allocated.
+	VkDescriptorSet AcquireDescriptorSet(const BackendData& backendData, DescriptorSetCache& cache, const DescriptorSetContents& contents,
+		const DescriptorSetLayoutDescription& layoutDescription);
+	// Called by the destroy paths of a registered cache. The resource has to be actually destroyed, the device is done with
+	// the sets referencing it by then, so they can be recycled.
+	void InvalidateDescriptorSets(DescriptorSetCache& cache, VkBuffer buffer);
+	void InvalidateDescriptorSets(DescriptorSetCache& cache, VkImageView imageView);
+	void InvalidateDescriptorSets(DescriptorSetCache& cache, VkSampler sampler);
+	CacheStatistics GetDescriptorSetCacheStatistics(DescriptorSetCache& cache);
+
+	// ===================== Bindless Heap =====================
+
+	// The bindings of the heap set in order. Shaders declare them as unsized arrays and index them with the handed out indices.
+	enum class BindlessType : uint8_t
+	{
+		StorageBuffer,
+		Sampler,
+		StorageImage,
+		// The last binding, allocated with a variable count.
+		SampledImage,
+		Count
+	};
+
+	struct BindlessSlots
+	{
+		uint32_t capacity = 0;
+		uint32_t nextIndex = 0;
+		// Set while the index is handed out, only those indices can be removed.
+		std::vector<bool> live;
+		std::vector<uint32_t> freeIndices;
+		// Removed indices tagged with the frame, reused once the frames in flight are done with them.
+		std::deque<std::pair<uint64_t, uint32_t>> pendingIndices;
+	};
+
+	// A single update after bind set holding all resources, bound once and written as resources are added.
+	struct BindlessHeap
+	{
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+		std::mutex mutex;
+		BindlessSlots slots[(size_t)BindlessType::Count];
+		uint64_t currentFrame = 0;
+		uint32_t framesInFlight = 0;
+	};
+
+	// Needs the "descriptor indexing" device feature. The capacities are clamped to the update after bind limits of the device,
+	// every binding keeps at least one descriptor and the creation fails if the limits do not allow even that.
+	bool CreateBindlessHeap(const BackendData& backendData, BindlessHeap& heap, uint32_t framesInFlight, uint32_t storageBufferCapacity = 65536,
+		uint32_t samplerCapacity = 1024, uint32_t storageImageCapacity = 16384, uint32_t sampledImageCapacity = 262144);
+	void DestroyBindlessHeap(const BackendData& backendData, BindlessHeap& heap);
+
+	// Return the index of the resource within its binding or UINT32_MAX if the binding is full.
+	uint32_t AddBindlessStorageBuffer(const BackendData& backendData, BindlessHeap& heap, VkBuffer buffer,
+		VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	uint32_t AddBindlessSampler(const BackendData& backendData, BindlessHeap& heap, VkSampler sampler);
+	uint32_t AddBindlessStorageImage(const BackendData& backendData, BindlessHeap& heap, VkImageView imageView);
+	uint32_t AddBindlessSampledImage(const BackendData& backendData, BindlessHeap& heap, VkImageView imageView,
+		VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	// The descriptor is left in place (the binding is partially bound), the index is handed out again frames in flight later.
+	// Returns false for indices that are not in use, e.g. already removed ones.
+	bool RemoveBindlessResource(BindlessHeap& heap, BindlessType type, uint32_t index);
+	// Starts a new frame after its fence was waited on, like AdvanceDeletionFrame.
+	void AdvanceBindlessFrame(BindlessHeap& heap);
+
+	// =================== Shader Reflection ===================
+
+	struct ShaderVertexInput
+	{
+		uint32_t location;
+		VkFormat format;
+		uint32_t size;
+	};
+
+	struct ShaderReflection
+	{
+		VkShaderStageFlagBits stage;
+		std::string entryPoint;
+		// Runtime arrays are reported with a zero descriptor count, the caller decides their size.
+		PipelineLayoutDescription layout;
+		// Vertex stage only, sorted by location.
+		std::vector<ShaderVertexInput> vertexInputs;
+		// Compute, task and mesh stages only.
+		uint32_t workgroupSize[3];
+	};
+
+	// Parses the SPIR-V code passed to CreateShaderModule, the first entry point of the module is reflected.
+	// Only the global declarations are read, the function bodies are skipped.
+	bool ReflectShaderModule(const std::vector<uint32_t>& code, ShaderReflection& reflection);
+	// Merges the layouts of the pipeline stages, bindings shared by several stages get the union of their stage flags.
+	PipelineLayoutDescription MergeShaderLayouts(const std::vector<ShaderReflection>& reflections);
+	// Tightly packed attributes of a single per-vertex binding, in the order of their locations.
+	void GetVertexInputDescriptions(const ShaderReflection& reflection, uint32_t binding,
+		std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes);
+
+	// Reflects a generated module with the given number of uniform buffer bindings and reports the average time.
+	double BenchmarkShaderReflection(uint32_t bindingCount, uint32_t iterations);
 }
@@ -0,0 +1,334 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <chrono>
+
+static uint64_t GetTimeNanoseconds()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void AccumulateMean(double& average, double sample, uint64_t sampleCount)
+{
+	average += (sample - average) / sampleCount;
+}
+
+static VkPipeline CompileAsyncPipeline(VulkanBackend::AsyncPipelineCompiler& compiler, const VulkanBackend::AsyncPipelineEntry& entry)
+{
+	const VulkanBackend::BackendData& backendData = *compiler.backendData;
+	if (compiler.collection)
+	{
+		return entry.compute ?
+			VulkanBackend::AcquireComputePipeline(backendData, *compiler.collection, entry.computeDescription) :
+			VulkanBackend::AcquireGraphicsPipeline(backendData, *compiler.collection, entry.graphicsDescription);
+	}
+	return entry.compute ?
+		VulkanBackend::CreateComputePipeline(backendData, entry.computeDescription, compiler.pipelineCache) :
+		VulkanBackend::CreateGraphicsPipeline(backendData, entry.graphicsDescription, compiler.pipelineCache);
+}
+
+// Expects the compiler to be locked and the entry to be unreferenced.
+static void RecycleAsyncPipelineEntry(VulkanBackend::AsyncPipelineCompiler& compiler, uint32_t index)
+{
+	VulkanBackend::AsyncPipelineEntry& entry = compiler.entries[index];
+
+	// Pipelines acquired from a collection stay owned by it.
+	if (entry.pipeline && !compiler.collection)
+	{
+		if (entry.deletionQueue)
+		{
+			VulkanBackend::DeferDestroyPipeline(*entry.deletionQueue, entry.pipeline);
+		}
+		else
+		{
+			VulkanBackend::DestroyPipeline(*compiler.backendData, entry.pipeline);
+		}
+	}
+
+	const uint32_t generation = entry.generation + 1;
+	entry = {};
+	entry.generation = generation;
+	compiler.freeEntries.push_back(index);
+}
+
+static void CompilerWorker(VulkanBackend::AsyncPipelineCompiler* compiler)
+{
+	while (true)
+	{
+		uint32_t index;
+		VulkanBackend::AsyncPipelineEntry entry;
+		{
+			std::unique_lock<std::mutex> lock(compiler->mutex);
+			compiler->condition.wait(lock, [compiler]()
+			{
+				return !compiler->running || !compiler->pendingEntries.empty();
+			});
+
+			// The queue is drained before stopping, so that waiting for a handle never hangs.
+			if (compiler->pendingEntries.empty())
+			{
+				return;
+			}
+
+			index = compiler->pendingEntries.front();
+			compiler->pendingEntries.pop_front();
+
+			// Released before the compilation started, there is nothing to compile anymore.
+			if (compiler->entries[index].references == 0)
+			{
+				RecycleAsyncPipelineEntry(*compiler, index);
+				continue;
+			}
+			entry = compiler->entries[index];
+		}
+
+		const uint64_t compileStart = GetTimeNanoseconds();
+		VkPipeline pipeline = CompileAsyncPipeline(*compiler, entry);
+		const uint64_t compileEnd = GetTimeNanoseconds();
+
+		{
+			std::lock_guard<std::mutex> lock(compiler->mutex);
+			compiler->entries[index].pipeline = pipeline;
+			compiler->entries[index].ready = true;
+
+			auto& statistics = compiler->statistics;
+			++statistics.completed;
+			const double latency = (compileEnd - entry.requestTime) / 1000000.0;
+			AccumulateMean(statistics.averageLatencyMilliseconds, latency, statistics.completed);
+			AccumulateMean(statistics.averageCompileMilliseconds, (compileEnd - compileStart) / 1000000.0, statistics.completed);
+			statistics.maxLatencyMilliseconds = (std::max)(statistics.maxLatencyMilliseconds, latency);
+
+			if (compiler->entries[index].references == 0)
+			{
+				RecycleAsyncPipelineEntry(*compiler, index);
+			}
+		}
+		compiler->completedCondition.notify_all();
+	}
+}
+
+static bool AsyncPipelineEntriesEqual(const VulkanBackend::AsyncPipelineEntry& a, const VulkanBackend::AsyncPipelineEntry& b)
+{
+	if (a.compute != b.compute)
+	{
+		return false;
+	}
+	return a.compute ?
+		VulkanBackend::ComputePipelineDescriptionsEqual(a.computeDescription, b.computeDescription) :
+		VulkanBackend::GraphicsPipelineDescriptionsEqual(a.graphicsDescription, b.graphicsDescription);
+}
+
+static VulkanBackend::AsyncPipelineHandle EnqueueAsyncPipeline(VulkanBackend::AsyncPipelineCompiler& compiler,
+	VulkanBackend::AsyncPipelineEntry&& entry)
+{
+	entry.requestTime = GetTimeNanoseconds();
+
+	VulkanBackend::AsyncPipelineHandle handle;
+	{
+		std::lock_guard<std::mutex> lock(compiler.mutex);
+		++compiler.statistics.requested;
+
+		auto range = compiler.entryIndices.equal_range(entry.hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			auto& existing = compiler.entries[it->second];
+			if (AsyncPipelineEntriesEqual(existing, entry))
+			{
+				++existing.references;
+				++compiler.statistics.deduplicated;
+				return { it->second + 1, existing.generation };
+			}
+		}
+
+		uint32_t index;
+		if (!compiler.freeEntries.empty())
+		{
+			index = compiler.freeEntries.back();
+			compiler.freeEntries.pop_back();
+			entry.generation = compiler.entries[index].generation;
+			compiler.entries[index] = std::move(entry);
+		}
+		else
+		{
+			index = (uint32_t)compiler.entries.size();
+			compiler.entries.push_back(std::move(entry));
+		}
+		compiler.entries[index].references = 1;
+		compiler.entryIndices.emplace(compiler.entries[index].hash, index);
+		compiler.pendingEntries.push_back(index);
+		handle = { index + 1, compiler.entries[index].generation };
+	}
+	compiler.condition.notify_one();
+
+	return handle;
+}
+
+// Expects the compiler to be locked.
+static VulkanBackend::AsyncPipelineEntry* GetAsyncPipelineEntry(VulkanBackend::AsyncPipelineCompiler& compiler,
+	VulkanBackend::AsyncPipelineHandle handle)
+{
+	if (handle.value == 0 || handle.value > compiler.entries.size() ||
+		compiler.entries[handle.value - 1].generation != handle.generation || compiler.entries[handle.value - 1].references == 0)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Invalid asynchronous pipeline handle.");
+		return nullptr;
+	}
+	return &compiler.entries[handle.value - 1];
+}
+
+void VulkanBackend::CreateAsyncPipelineCompiler(const BackendData& backendData, AsyncPipelineCompiler& compiler, uint32_t threadCount,
+	PipelineCollection* collection, VkPipelineCache pipelineCache)
+{
+	compiler.backendData = &backendData;
+	compiler.collection = collection;
+	compiler.pipelineCache = pipelineCache;
+	compiler.running = true;
+
+	threadCount = (std::max)(threadCount, 1u);
+	for (uint32_t t = 0; t < threadCount; ++t)
+	{
+		compiler.workers.emplace_back(CompilerWorker, &compiler);
+	}
+}
+
+void VulkanBackend::DestroyAsyncPipelineCompiler(AsyncPipelineCompiler& compiler)
+{
+	{
+		std::lock_guard<std::mutex> lock(compiler.mutex);
+		compiler.running = false;
+	}
+	compiler.condition.notify_all();
+	for (auto& worker : compiler.workers)
+	{
+		worker.join();
+	}
+	compiler.workers.clear();
+
+	// Pipelines acquired from a collection are destroyed together with it.
+	if (!compiler.collection)
+	{
+		for (auto& entry : compiler.entries)
+		{
+			if (entry.pipeline)
+			{
+				DestroyPipeline(*compiler.backendData, entry.pipeline);
+			}
+		}
+	}
+	compiler.entries.clear();
+	compiler.freeEntries.clear();
+	compiler.entryIndices.clear();
+	compiler.statistics = {};
+}
+
+VulkanBackend::AsyncPipelineHandle VulkanBackend::RequestGraphicsPipeline(AsyncPipelineCompiler& compiler,
+	const GraphicsPipelineDescription& description, VkPipeline fallback)
+{
+	AsyncPipelineEntry entry{};
+	entry.compute = false;
+	entry.graphicsDescription = description;
+	for (auto& stage : entry.graphicsDescription.shaderStages)
+	{
+		stage.specialization = SortSpecializationConstants(stage.specialization);
+	}
+	entry.hash = HashGraphicsPipelineDescription(entry.graphicsDescription);
+	entry.fallback = fallback;
+	return EnqueueAsyncPipeline(compiler, std::move(entry));
+}
+
+VulkanBackend::AsyncPipelineHandle VulkanBackend::RequestComputePipeline(AsyncPipelineCompiler& compiler,
+	const ComputePipelineDescription& description, VkPipeline fallback)
+{
+	AsyncPipelineEntry entry{};
+	entry.compute = true;
+	entry.computeDescription = description;
+	entry.computeDescription.shaderStage.specialization = SortSpecializationConstants(description.shaderStage.specialization);
+	entry.hash = HashComputePipelineDescription(entry.computeDescription);
+	entry.fallback = fallback;
+	return EnqueueAsyncPipeline(compiler, std::move(entry));
+}
+
+void VulkanBackend::ReleaseAsyncPipeline(AsyncPipelineCompiler& compiler, AsyncPipelineHandle& handle, DeletionQueue* deletionQueue)
+{
+	std::lock_guard<std::mutex> lock(compiler.mutex);
+	AsyncPipelineEntry* entry = GetAsyncPipelineEntry(compiler, handle);
+	const uint32_t index = handle.value - 1;
+	handle = {};
+	if (!entry || --entry->references > 0)
+	{
+		return;
+	}
+
+	// Later identical requests get a new entry, this one only waits for its compilation to finish if it is still pending.
+	auto range = compiler.entryIndices.equal_range(entry->hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == index)
+		{
+			compiler.entryIndices.erase(it);
+			break;
+		}
+	}
+
+	// Otherwise the worker recycles the entry once it gets to it.
+	entry->deletionQueue = deletionQueue;
+	if (entry->ready)
+	{
+		RecycleAsyncPipelineEntry(compiler, index);
+	}
+}
+
+bool VulkanBackend::IsAsyncPipelineReady(AsyncPipelineCompiler& compiler, AsyncPipelineHandle handle)
+{
+	std::lock_guard<std::mutex> lock(compiler.mutex);
+	AsyncPipelineEntry* entry = GetAsyncPipelineEntry(compiler, handle);
+	return entry && entry->ready;
+}
+
+VkPipeline VulkanBackend::GetAsyncPipeline(AsyncPipelineCompiler& compiler, AsyncPipelineHandle handle)
+{
+	std::lock_guard<std::mutex> lock(compiler.mutex);
+	AsyncPipelineEntry* entry = GetAsyncPipelineEntry(compiler, handle);
+	if (!entry)
+	{
+		return VK_NULL_HANDLE;
+	}
+	if (entry->ready)
+	{
+		return entry->pipeline;
+	}
+
+	if (entry->fallback)
+	{
+		++compiler.statistics.fallbackUses;
+	}
+	else
+	{
+		++compiler.statistics.skippedLookups;
+	}
+	return entry->fallback;
+}
+
+VkPipeline VulkanBackend::WaitForAsyncPipeline(AsyncPipelineCompiler& compiler, AsyncPipelineHandle handle)
+{
+	std::unique_lock<std::mutex> lock(compiler.mutex);
+	if (!GetAsyncPipelineEntry(compiler, handle))
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	// The entries are never removed while the compiler is alive, the index stays valid while waiting.
+	const uint32_t index = handle.value - 1;
+	compiler.completedCondition.wait(lock, [&compiler, index, handle]()
+		{
+			return compiler.entries[index].ready || compiler.entries[index].generation != handle.generation;
+		});
+	return compiler.entries[index].generation == handle.generation ? compiler.entries[index].pipeline : VK_NULL_HANDLE;
+}
+
+VulkanBackend::AsyncPipelineStatistics VulkanBackend::GetAsyncPipelineStatistics(AsyncPipelineCompiler& compiler)
+{
+	std::lock_guard<std::mutex> lock(compiler.mutex);
+	return compiler.statistics;
+}
@@ -0,0 +1,287 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <iterator>
+
+static constexpr uint32_t bindlessIndexInvalid = UINT32_MAX;
+
+static const VkDescriptorType bindlessDescriptorTypes[] =
+{
+	VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	VK_DESCRIPTOR_TYPE_SAMPLER,
+	VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+	VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+};
+
+static bool IsDescriptorIndexingEnabled(const VkPhysicalDeviceVulkan12Features& features)
+{
+	return features.descriptorIndexing && features.runtimeDescriptorArray && features.descriptorBindingPartiallyBound &&
+		features.descriptorBindingVariableDescriptorCount && features.descriptorBindingUpdateUnusedWhilePending &&
+		features.descriptorBindingSampledImageUpdateAfterBind && features.descriptorBindingStorageImageUpdateAfterBind &&
+		features.descriptorBindingStorageBufferUpdateAfterBind;
+}
+
+// The capacities are indexed by BindlessType.
+// Every binding gets at least one descriptor, returns false if the device limits cannot cover that.
+static bool ClampBindlessCapacities(const VulkanBackend::BackendData& backendData, uint32_t* capacities)
+{
+	VkPhysicalDeviceVulkan12Properties properties12{};
+	properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties2{};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &properties12;
+	vkGetPhysicalDeviceProperties2(backendData.physicalDevice, &properties2);
+
+	const uint32_t limits[] =
+	{
+		(std::min)(properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers, properties12.maxDescriptorSetUpdateAfterBindStorageBuffers),
+		(std::min)(properties12.maxPerStageDescriptorUpdateAfterBindSamplers, properties12.maxDescriptorSetUpdateAfterBindSamplers),
+		(std::min)(properties12.maxPerStageDescriptorUpdateAfterBindStorageImages, properties12.maxDescriptorSetUpdateAfterBindStorageImages),
+		(std::min)(properties12.maxPerStageDescriptorUpdateAfterBindSampledImages, properties12.maxDescriptorSetUpdateAfterBindSampledImages)
+	};
+
+	// The heap is visible to all stages, so all of its descriptors count against the per stage resource limit.
+	// One descriptor per binding is reserved up front, the rest of the budget is split in binding order.
+	const uint32_t typeCount = (uint32_t)VulkanBackend::BindlessType::Count;
+	uint32_t remainingResources = properties12.maxPerStageUpdateAfterBindResources;
+	if (remainingResources < typeCount || *std::min_element(std::begin(limits), std::end(limits)) == 0)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: The device limits do not allow a descriptor in every bindless heap binding.");
+		return false;
+	}
+	remainingResources -= typeCount;
+
+	for (uint32_t t = 0; t < typeCount; ++t)
+	{
+		const uint32_t requested = (std::max)(capacities[t], 1u);
+		const uint32_t capacity = 1 + (std::min)({ requested - 1, limits[t] - 1, remainingResources });
+		if (capacity < capacities[t])
+		{
+			CoreLogWarn(DefaultLogger, "Vulkan backend: Bindless heap binding %u clamped from %u to %u descriptors.", t, capacities[t], capacity);
+		}
+		capacities[t] = capacity;
+		remainingResources -= capacity - 1;
+	}
+	return true;
+}
+
+static void InitializeBindlessSlots(VulkanBackend::BindlessSlots& slots, uint32_t capacity)
+{
+	slots.capacity = capacity;
+	slots.nextIndex = 0;
+	slots.live.assign(capacity, false);
+	slots.freeIndices.clear();
+	slots.pendingIndices.clear();
+}
+
+// Expects the heap to be locked.
+static uint32_t AllocateBindlessIndex(VulkanBackend::BindlessSlots& slots)
+{
+	uint32_t index = bindlessIndexInvalid;
+	if (!slots.freeIndices.empty())
+	{
+		index = slots.freeIndices.back();
+		slots.freeIndices.pop_back();
+	}
+	else if (slots.nextIndex < slots.capacity)
+	{
+		index = slots.nextIndex++;
+	}
+
+	if (index != bindlessIndexInvalid)
+	{
+		slots.live[index] = true;
+	}
+	return index;
+}
+
+// Expects the heap to be locked.
+static void WriteBindlessDescriptor(const VulkanBackend::BackendData& backendData, VulkanBackend::BindlessHeap& heap, VulkanBackend::BindlessType type,
+	uint32_t index, const VkDescriptorBufferInfo* bufferInfo, const VkDescriptorImageInfo* imageInfo)
+{
+	VkWriteDescriptorSet writeDescriptorSet{};
+	writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeDescriptorSet.dstSet = heap.descriptorSet;
+	writeDescriptorSet.dstBinding = (uint32_t)type;
+	writeDescriptorSet.dstArrayElement = index;
+	writeDescriptorSet.descriptorType = bindlessDescriptorTypes[(size_t)type];
+	writeDescriptorSet.descriptorCount = 1;
+	writeDescriptorSet.pBufferInfo = bufferInfo;
+	writeDescriptorSet.pImageInfo = imageInfo;
+
+	vkUpdateDescriptorSets(backendData.logicalDevice, 1, &writeDescriptorSet, 0, nullptr);
+}
+
+static uint32_t AddBindlessDescriptor(const VulkanBackend::BackendData& backendData, VulkanBackend::BindlessHeap& heap, VulkanBackend::BindlessType type,
+	const VkDescriptorBufferInfo* bufferInfo, const VkDescriptorImageInfo* imageInfo)
+{
+	// The set is externally synchronized, so the write happens under the lock as well.
+	std::lock_guard<std::mutex> lock(heap.mutex);
+
+	const uint32_t index = AllocateBindlessIndex(heap.slots[(size_t)type]);
+	if (index == bindlessIndexInvalid)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Bindless heap binding %u is full.", (uint32_t)type);
+		return bindlessIndexInvalid;
+	}
+
+	WriteBindlessDescriptor(backendData, heap, type, index, bufferInfo, imageInfo);
+	return index;
+}
+
+bool VulkanBackend::CreateBindlessHeap(const BackendData& backendData, BindlessHeap& heap, uint32_t framesInFlight, uint32_t storageBufferCapacity,
+	uint32_t samplerCapacity, uint32_t storageImageCapacity, uint32_t sampledImageCapacity)
+{
+	if (!IsDescriptorIndexingEnabled(backendData.enabledFeatures12))
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: The bindless heap needs the \"descriptor indexing\" device feature.");
+		return false;
+	}
+
+	uint32_t capacities[] = { storageBufferCapacity, samplerCapacity, storageImageCapacity, sampledImageCapacity };
+	if (!ClampBindlessCapacities(backendData, capacities))
+	{
+		return false;
+	}
+
+	// Every binding may be updated while the set is bound and used with holes, the last one has a variable count.
+	VkDescriptorSetLayoutBinding layoutBindings[(size_t)BindlessType::Count]{};
+	VkDescriptorBindingFlags bindingFlags[(size_t)BindlessType::Count]{};
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	for (uint32_t t = 0; t < (uint32_t)BindlessType::Count; ++t)
+	{
+		layoutBindings[t].binding = t;
+		layoutBindings[t].descriptorType = bindlessDescriptorTypes[t];
+		layoutBindings[t].descriptorCount = capacities[t];
+		layoutBindings[t].stageFlags = VK_SHADER_STAGE_ALL;
+		bindingFlags[t] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		poolSizes.push_back({ bindlessDescriptorTypes[t], layoutBindings[t].descriptorCount });
+	}
+	bindingFlags[(size_t)BindlessType::SampledImage] |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo{};
+	bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsCreateInfo.bindingCount = (uint32_t)BindlessType::Count;
+	bindingFlagsCreateInfo.pBindingFlags = bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptorSetLayoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+	descriptorSetLayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	descriptorSetLayoutCreateInfo.bindingCount = (uint32_t)BindlessType::Count;
+	descriptorSetLayoutCreateInfo.pBindings = layoutBindings;
+	VulkanCheck(vkCreateDescriptorSetLayout(backendData.logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &heap.layout));
+
+	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	descriptorPoolCreateInfo.poolSizeCount = (uint32_t)poolSizes.size();
+	descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
+	descriptorPoolCreateInfo.maxSets = 1;
+	VulkanCheck(vkCreateDescriptorPool(backendData.logicalDevice, &descriptorPoolCreateInfo, nullptr, &heap.pool));
+
+	const uint32_t variableDescriptorCount = layoutBindings[(size_t)BindlessType::SampledImage].descriptorCount;
+	VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountAllocateInfo{};
+	variableCountAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+	variableCountAllocateInfo.descriptorSetCount = 1;
+	variableCountAllocateInfo.pDescriptorCounts = &variableDescriptorCount;
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.pNext = &variableCountAllocateInfo;
+	descriptorSetAllocateInfo.descriptorPool = heap.pool;
+	descriptorSetAllocateInfo.pSetLayouts = &heap.layout;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	VulkanCheck(vkAllocateDescriptorSets(backendData.logicalDevice, &descriptorSetAllocateInfo, &heap.descriptorSet));
+
+	std::lock_guard<std::mutex> lock(heap.mutex);
+	for (uint32_t t = 0; t < (uint32_t)BindlessType::Count; ++t)
+	{
+		InitializeBindlessSlots(heap.slots[t], capacities[t]);
+	}
+	heap.currentFrame = 0;
+	heap.framesInFlight = framesInFlight;
+
+	return true;
+}
+
+void VulkanBackend::DestroyBindlessHeap(const BackendData& backendData, BindlessHeap& heap)
+{
+	std::lock_guard<std::mutex> lock(heap.mutex);
+
+	// The set is released together with the pool.
+	if (heap.pool)
+	{
+		DestroyDescriptorPool(backendData, heap.pool);
+	}
+	if (heap.layout)
+	{
+		DestroyDescriptorSetLayout(backendData, heap.layout);
+	}
+	heap.descriptorSet = VK_NULL_HANDLE;
+	for (auto& slots : heap.slots)
+	{
+		InitializeBindlessSlots(slots, 0);
+	}
+}
+
+uint32_t VulkanBackend::AddBindlessStorageBuffer(const BackendData& backendData, BindlessHeap& heap, VkBuffer buffer,
+	VkDeviceSize offset, VkDeviceSize range)
+{
+	const VkDescriptorBufferInfo bufferInfo{ buffer, offset, range };
+	return AddBindlessDescriptor(backendData, heap, BindlessType::StorageBuffer, &bufferInfo, nullptr);
+}
+
+uint32_t VulkanBackend::AddBindlessSampler(const BackendData& backendData, BindlessHeap& heap, VkSampler sampler)
+{
+	const VkDescriptorImageInfo imageInfo{ sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
+	return AddBindlessDescriptor(backendData, heap, BindlessType::Sampler, nullptr, &imageInfo);
+}
+
+uint32_t VulkanBackend::AddBindlessStorageImage(const BackendData& backendData, BindlessHeap& heap, VkImageView imageView)
+{
+	const VkDescriptorImageInfo imageInfo{ VK_NULL_HANDLE, imageView, VK_IMAGE_LAYOUT_GENERAL };
+	return AddBindlessDescriptor(backendData, heap, BindlessType::StorageImage, nullptr, &imageInfo);
+}
+
+uint32_t VulkanBackend::AddBindlessSampledImage(const BackendData& backendData, BindlessHeap& heap, VkImageView imageView,
+	VkImageLayout imageLayout)
+{
+	const VkDescriptorImageInfo imageInfo{ VK_NULL_HANDLE, imageView, imageLayout };
+	return AddBindlessDescriptor(backendData, heap, BindlessType::SampledImage, nullptr, &imageInfo);
+}
+
+bool VulkanBackend::RemoveBindlessResource(BindlessHeap& heap, BindlessType type, uint32_t index)
+{
+	std::lock_guard<std::mutex> lock(heap.mutex);
+
+	// Pending and free indices are not live, queueing them again would hand them out twice.
+	BindlessSlots& slots = heap.slots[(size_t)type];
+	if (index >= slots.nextIndex || !slots.live[index])
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Bindless index %u of binding %u is not in use.", index, (uint32_t)type);
+		return false;
+	}
+	slots.live[index] = false;
+	slots.pendingIndices.push_back({ heap.currentFrame, index });
+	return true;
+}
+
+void VulkanBackend::AdvanceBindlessFrame(BindlessHeap& heap)
+{
+	std::lock_guard<std::mutex> lock(heap.mutex);
+
+	++heap.currentFrame;
+	for (auto& slots : heap.slots)
+	{
+		// The indices are removed in frame order, so the reusable ones are at the front.
+		while (!slots.pendingIndices.empty() && slots.pendingIndices.front().first + heap.framesInFlight <= heap.currentFrame)
+		{
+			slots.freeIndices.push_back(slots.pendingIndices.front().second);
+			slots.pendingIndices.pop_front();
+		}
+	}
+}
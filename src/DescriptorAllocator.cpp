@@ -0,0 +1,243 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <iterator>
+
+static constexpr uint32_t maxSetsPerPool = 4096;
+// Weight of the last frame when adapting the ratios, the rest is kept from the previous ones.
+static constexpr float adaptationWeight = 0.5f;
+
+static const VulkanBackend::DescriptorTypeRatio defaultRatios[] =
+{
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+	{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+	{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+	{ VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f }
+};
+
+static void AddDescriptorCount(std::vector<VkDescriptorPoolSize>& sizes, VkDescriptorType type, uint32_t count)
+{
+	for (auto& size : sizes)
+	{
+		if (size.type == type)
+		{
+			size.descriptorCount += count;
+			return;
+		}
+	}
+	sizes.push_back({ type, count });
+}
+
+// The pool holds the ratios for all of its sets and at least the given set itself, so that allocating it cannot fail.
+static VkDescriptorPool CreateAllocatorPool(const VulkanBackend::BackendData& backendData, VulkanBackend::DescriptorAllocator& allocator,
+	const VulkanBackend::DescriptorSetLayoutDescription& description)
+{
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	for (const auto& ratio : allocator.ratios)
+	{
+		const uint32_t count = (uint32_t)(ratio.descriptorsPerSet * allocator.setsPerPool);
+		if (count > 0)
+		{
+			AddDescriptorCount(poolSizes, ratio.type, count);
+		}
+	}
+
+	std::vector<VkDescriptorPoolSize> setSizes;
+	for (const auto& binding : description.bindings)
+	{
+		AddDescriptorCount(setSizes, binding.descriptorType, binding.descriptorCount);
+	}
+	for (const auto& setSize : setSizes)
+	{
+		auto it = std::find_if(poolSizes.begin(), poolSizes.end(), [&setSize](const VkDescriptorPoolSize& size) { return size.type == setSize.type; });
+		if (it == poolSizes.end())
+		{
+			poolSizes.push_back(setSize);
+		}
+		else
+		{
+			it->descriptorCount = (std::max)(it->descriptorCount, setSize.descriptorCount);
+		}
+	}
+
+	VkDescriptorPool pool = VulkanBackend::CreateDescriptorPool(backendData, poolSizes, allocator.setsPerPool);
+	if (pool)
+	{
+		++allocator.statistics.livePools;
+	}
+	return pool;
+}
+
+static VkDescriptorPool GetAllocatorPool(const VulkanBackend::BackendData& backendData, VulkanBackend::DescriptorAllocator& allocator,
+	const VulkanBackend::DescriptorSetLayoutDescription& description)
+{
+	++allocator.poolsUsed;
+	if (!allocator.freePools.empty())
+	{
+		VkDescriptorPool pool = allocator.freePools.back();
+		allocator.freePools.pop_back();
+		return pool;
+	}
+	return CreateAllocatorPool(backendData, allocator, description);
+}
+
+static VkResult TryAllocateDescriptorSet(const VulkanBackend::BackendData& backendData, VkDescriptorPool pool,
+	VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptorSet)
+{
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorPool = pool;
+	descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	return vkAllocateDescriptorSets(backendData.logicalDevice, &descriptorSetAllocateInfo, &descriptorSet);
+}
+
+static void AdaptRatios(VulkanBackend::DescriptorAllocator& allocator)
+{
+	if (allocator.observedSets == 0)
+	{
+		return;
+	}
+
+	for (auto& ratio : allocator.ratios)
+	{
+		ratio.descriptorsPerSet *= 1.0f - adaptationWeight;
+	}
+	for (const auto& observed : allocator.observedDescriptors)
+	{
+		const float descriptorsPerSet = adaptationWeight * observed.descriptorCount / allocator.observedSets;
+		auto it = std::find_if(allocator.ratios.begin(), allocator.ratios.end(),
+			[&observed](const VulkanBackend::DescriptorTypeRatio& ratio) { return ratio.type == observed.type; });
+		if (it == allocator.ratios.end())
+		{
+			allocator.ratios.push_back({ observed.type, descriptorsPerSet });
+		}
+		else
+		{
+			it->descriptorsPerSet += descriptorsPerSet;
+		}
+	}
+}
+
+void VulkanBackend::CreateDescriptorAllocator(DescriptorAllocator& allocator, uint32_t setsPerPool, const std::vector<DescriptorTypeRatio>& ratios)
+{
+	allocator.setsPerPool = (std::max)(setsPerPool, 1u);
+	if (ratios.empty())
+	{
+		allocator.ratios.assign(std::begin(defaultRatios), std::end(defaultRatios));
+	}
+	else
+	{
+		allocator.ratios = ratios;
+	}
+}
+
+void VulkanBackend::DestroyDescriptorAllocator(const BackendData& backendData, DescriptorAllocator& allocator)
+{
+	if (allocator.currentPool)
+	{
+		DestroyDescriptorPool(backendData, allocator.currentPool);
+	}
+	for (auto& pool : allocator.fullPools)
+	{
+		DestroyDescriptorPool(backendData, pool);
+	}
+	for (auto& pool : allocator.freePools)
+	{
+		DestroyDescriptorPool(backendData, pool);
+	}
+	allocator.fullPools.clear();
+	allocator.freePools.clear();
+	allocator.observedDescriptors.clear();
+	allocator.observedSets = 0;
+	allocator.poolsUsed = 0;
+	allocator.statistics = {};
+}
+
+VkDescriptorSet VulkanBackend::AllocateDescriptorSet(const BackendData& backendData, DescriptorAllocator& allocator,
+	VkDescriptorSetLayout descriptorSetLayout, const DescriptorSetLayoutDescription& description)
+{
+	for (const auto& binding : description.bindings)
+	{
+		AddDescriptorCount(allocator.observedDescriptors, binding.descriptorType, binding.descriptorCount);
+	}
+	++allocator.observedSets;
+
+	if (!allocator.currentPool)
+	{
+		allocator.currentPool = GetAllocatorPool(backendData, allocator, description);
+	}
+
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	VkResult result = TryAllocateDescriptorSet(backendData, allocator.currentPool, descriptorSetLayout, descriptorSet);
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+	{
+		// The full pool is chained and kept until the next reset, the sets allocated from it stay valid.
+		++allocator.statistics.overflows;
+		allocator.fullPools.push_back(allocator.currentPool);
+
+		// The free pools were sized with earlier ratios and may not hold the set either, the retry gets a pool sized for it.
+		++allocator.poolsUsed;
+		allocator.currentPool = CreateAllocatorPool(backendData, allocator, description);
+		result = allocator.currentPool ? TryAllocateDescriptorSet(backendData, allocator.currentPool, descriptorSetLayout, descriptorSet) :
+			VK_ERROR_OUT_OF_POOL_MEMORY;
+	}
+	if (result != VK_SUCCESS)
+	{
+		VulkanCheck(result);
+		CoreLogError(DefaultLogger, "Vulkan backend: Could not allocate a descriptor set, not even from a new pool.");
+		return VK_NULL_HANDLE;
+	}
+
+	++allocator.statistics.allocatedSets;
+	return descriptorSet;
+}
+
+void VulkanBackend::ResetDescriptorAllocator(const BackendData& backendData, DescriptorAllocator& allocator)
+{
+	if (allocator.currentPool)
+	{
+		allocator.fullPools.push_back(allocator.currentPool);
+		allocator.currentPool = VK_NULL_HANDLE;
+	}
+
+	AdaptRatios(allocator);
+
+	// A frame needing several pools is served by a single larger pool with the adapted ratios from now on.
+	if (allocator.poolsUsed > 1 && allocator.setsPerPool < maxSetsPerPool)
+	{
+		allocator.setsPerPool = (std::min)(allocator.setsPerPool * allocator.poolsUsed, maxSetsPerPool);
+		for (auto& pool : allocator.fullPools)
+		{
+			DestroyDescriptorPool(backendData, pool);
+			--allocator.statistics.livePools;
+		}
+		for (auto& pool : allocator.freePools)
+		{
+			DestroyDescriptorPool(backendData, pool);
+			--allocator.statistics.livePools;
+		}
+		allocator.fullPools.clear();
+		allocator.freePools.clear();
+	}
+
+	for (auto pool : allocator.fullPools)
+	{
+		VulkanCheck(vkResetDescriptorPool(backendData.logicalDevice, pool, 0));
+		allocator.freePools.push_back(pool);
+	}
+	allocator.fullPools.clear();
+
+	allocator.observedDescriptors.clear();
+	allocator.observedSets = 0;
+	allocator.poolsUsed = 0;
+}
+
+VulkanBackend::DescriptorAllocatorStatistics VulkanBackend::GetDescriptorAllocatorStatistics(const DescriptorAllocator& allocator)
+{
+	return allocator.statistics;
+}
@@ -0,0 +1,259 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "Hashing.hpp"
+#include <algorithm>
+#include <cstring>
+
+static bool IsBufferDescriptor(VkDescriptorType type)
+{
+	return type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER || type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+		type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+}
+
+static VulkanBackend::DescriptorSetContents NormalizeDescriptorSetContents(const VulkanBackend::DescriptorSetContents& contents)
+{
+	VulkanBackend::DescriptorSetContents normalized = contents;
+	std::sort(normalized.bindings.begin(), normalized.bindings.end(), [](const VulkanBackend::DescriptorBinding& a, const VulkanBackend::DescriptorBinding& b)
+		{
+			return a.binding != b.binding ? a.binding < b.binding : a.arrayElement < b.arrayElement;
+		});
+	return normalized;
+}
+
+static size_t HashDescriptorSetContents(const VulkanBackend::DescriptorSetContents& contents)
+{
+	uint64_t hash = Hashing::Bytes(&contents.layout, sizeof(contents.layout));
+	hash = Hashing::Bytes(contents.bindings.data(), contents.bindings.size() * sizeof(VulkanBackend::DescriptorBinding), hash);
+	return (size_t)hash;
+}
+
+static bool DescriptorSetContentsEqual(const VulkanBackend::DescriptorSetContents& a, const VulkanBackend::DescriptorSetContents& b)
+{
+	return a.layout == b.layout && a.bindings.size() == b.bindings.size() &&
+		(a.bindings.empty() || memcmp(a.bindings.data(), b.bindings.data(), a.bindings.size() * sizeof(VulkanBackend::DescriptorBinding)) == 0);
+}
+
+template<typename Function>
+static void ForEachResource(const VulkanBackend::DescriptorSetContents& contents, Function function)
+{
+	for (const auto& binding : contents.bindings)
+	{
+		if (binding.buffer)
+		{
+			function((uint64_t)binding.buffer);
+		}
+		if (binding.imageView)
+		{
+			function((uint64_t)binding.imageView);
+		}
+		if (binding.sampler)
+		{
+			function((uint64_t)binding.sampler);
+		}
+	}
+}
+
+static void InvalidateResource(VulkanBackend::DescriptorSetCache& cache, uint64_t resource)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto resourceIt = cache.resourceEntries.find(resource);
+	if (resourceIt == cache.resourceEntries.end())
+	{
+		return;
+	}
+	std::vector<std::pair<size_t, VkDescriptorSet>> invalidated = std::move(resourceIt->second);
+	cache.resourceEntries.erase(resourceIt);
+
+	for (const auto& reference : invalidated)
+	{
+		auto range = cache.entries.equal_range(reference.first);
+		auto entryIt = std::find_if(range.first, range.second, [&reference](const std::pair<const size_t, VulkanBackend::DescriptorSetCacheEntry>& entry)
+			{
+				return entry.second.descriptorSet == reference.second;
+			});
+		if (entryIt == range.second)
+		{
+			continue;
+		}
+
+		// The other resources of the entry must not invalidate the recycled set later.
+		ForEachResource(entryIt->second.contents, [&cache, &reference](uint64_t other)
+			{
+				auto otherIt = cache.resourceEntries.find(other);
+				if (otherIt != cache.resourceEntries.end())
+				{
+					auto& references = otherIt->second;
+					references.erase(std::remove(references.begin(), references.end(), reference), references.end());
+					if (references.empty())
+					{
+						cache.resourceEntries.erase(otherIt);
+					}
+				}
+			});
+
+		cache.recycledSets[entryIt->second.contents.layout].push_back(entryIt->second.descriptorSet);
+		cache.entries.erase(entryIt);
+		--cache.statistics.liveObjects;
+	}
+}
+
+void VulkanBackend::BindDescriptorBuffer(DescriptorSetContents& contents, uint32_t binding, VkDescriptorType type, VkBuffer buffer,
+	VkDeviceSize offset, VkDeviceSize range, uint32_t arrayElement)
+{
+	DescriptorBinding descriptor{};
+	descriptor.binding = binding;
+	descriptor.arrayElement = arrayElement;
+	descriptor.type = type;
+	descriptor.buffer = buffer;
+	descriptor.offset = offset;
+	descriptor.range = range;
+	contents.bindings.push_back(descriptor);
+}
+
+void VulkanBackend::BindDescriptorImage(DescriptorSetContents& contents, uint32_t binding, VkDescriptorType type, VkImageView imageView,
+	VkImageLayout imageLayout, VkSampler sampler, uint32_t arrayElement)
+{
+	DescriptorBinding descriptor{};
+	descriptor.binding = binding;
+	descriptor.arrayElement = arrayElement;
+	descriptor.type = type;
+	descriptor.imageLayout = imageLayout;
+	descriptor.imageView = imageView;
+	descriptor.sampler = sampler;
+	contents.bindings.push_back(descriptor);
+}
+
+void VulkanBackend::WriteDescriptorSet(const BackendData& backendData, VkDescriptorSet descriptorSet, const DescriptorSetContents& contents)
+{
+	// Reserved up front, the writes point into the info arrays.
+	std::vector<VkDescriptorBufferInfo> bufferInfos;
+	std::vector<VkDescriptorImageInfo> imageInfos;
+	bufferInfos.reserve(contents.bindings.size());
+	imageInfos.reserve(contents.bindings.size());
+
+	std::vector<VkWriteDescriptorSet> writeDescriptorSets(contents.bindings.size());
+	for (size_t b = 0; b < contents.bindings.size(); ++b)
+	{
+		const DescriptorBinding& binding = contents.bindings[b];
+		VkWriteDescriptorSet& write = writeDescriptorSets[b];
+		write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = binding.binding;
+		write.dstArrayElement = binding.arrayElement;
+		write.descriptorType = binding.type;
+		write.descriptorCount = 1;
+
+		if (IsBufferDescriptor(binding.type))
+		{
+			bufferInfos.push_back({ binding.buffer, binding.offset, binding.range });
+			write.pBufferInfo = &bufferInfos.back();
+		}
+		else
+		{
+			imageInfos.push_back({ binding.sampler, binding.imageView, binding.imageLayout });
+			write.pImageInfo = &imageInfos.back();
+		}
+	}
+
+	vkUpdateDescriptorSets(backendData.logicalDevice, (uint32_t)writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+}
+
+void VulkanBackend::CreateDescriptorSetCache(DescriptorSetCache& cache, uint32_t setsPerPool)
+{
+	CreateDescriptorAllocator(cache.allocator, setsPerPool);
+}
+
+void VulkanBackend::DestroyDescriptorSetCache(const BackendData& backendData, DescriptorSetCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	// The sets are released together with the pools of the allocator.
+	DestroyDescriptorAllocator(backendData, cache.allocator);
+	cache.entries.clear();
+	cache.resourceEntries.clear();
+	cache.recycledSets.clear();
+	cache.statistics = {};
+}
+
+void VulkanBackend::RegisterDescriptorSetCache(BackendData& backendData, DescriptorSetCache* cache)
+{
+	backendData.descriptorSetCache = cache;
+}
+
+VkDescriptorSet VulkanBackend::AcquireDescriptorSet(const BackendData& backendData, DescriptorSetCache& cache, const DescriptorSetContents& contents,
+	const DescriptorSetLayoutDescription& layoutDescription)
+{
+	DescriptorSetContents normalized = NormalizeDescriptorSetContents(contents);
+	const size_t hash = HashDescriptorSetContents(normalized);
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto range = cache.entries.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (DescriptorSetContentsEqual(it->second.contents, normalized))
+		{
+			++cache.statistics.hits;
+			return it->second.descriptorSet;
+		}
+	}
+
+	++cache.statistics.misses;
+
+	VkDescriptorSet descriptorSet;
+	auto& recycled = cache.recycledSets[normalized.layout];
+	if (!recycled.empty())
+	{
+		descriptorSet = recycled.back();
+		recycled.pop_back();
+	}
+	else
+	{
+		descriptorSet = AllocateDescriptorSet(backendData, cache.allocator, normalized.layout, layoutDescription);
+		if (!descriptorSet)
+		{
+			return VK_NULL_HANDLE;
+		}
+	}
+	WriteDescriptorSet(backendData, descriptorSet, normalized);
+
+	ForEachResource(normalized, [&cache, hash, descriptorSet](uint64_t resource)
+		{
+			auto& references = cache.resourceEntries[resource];
+			// A resource bound several times is referenced once.
+			if (references.empty() || references.back().second != descriptorSet)
+			{
+				references.push_back({ hash, descriptorSet });
+			}
+		});
+
+	DescriptorSetCacheEntry entry{};
+	entry.contents = std::move(normalized);
+	entry.descriptorSet = descriptorSet;
+	cache.entries.emplace(hash, std::move(entry));
+	++cache.statistics.liveObjects;
+
+	return descriptorSet;
+}
+
+void VulkanBackend::InvalidateDescriptorSets(DescriptorSetCache& cache, VkBuffer buffer)
+{
+	InvalidateResource(cache, (uint64_t)buffer);
+}
+
+void VulkanBackend::InvalidateDescriptorSets(DescriptorSetCache& cache, VkImageView imageView)
+{
+	InvalidateResource(cache, (uint64_t)imageView);
+}
+
+void VulkanBackend::InvalidateDescriptorSets(DescriptorSetCache& cache, VkSampler sampler)
+{
+	InvalidateResource(cache, (uint64_t)sampler);
+}
+
+VulkanBackend::CacheStatistics VulkanBackend::GetDescriptorSetCacheStatistics(DescriptorSetCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	return cache.statistics;
+}
@@ -0,0 +1,323 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+
+static void DestroyDeferred(VulkanBackend::DeletionQueue& deletionQueue, const VulkanBackend::DeferredDestruction& entry)
+{
+	const VkDevice device = deletionQueue.logicalDevice;
+
+	// The frame of the entry has completed, the recycled sets are no longer in use either.
+	if (deletionQueue.descriptorSetCache)
+	{
+		switch (entry.type)
+		{
+		case VK_OBJECT_TYPE_BUFFER:
+			VulkanBackend::InvalidateDescriptorSets(*deletionQueue.descriptorSetCache, (VkBuffer)entry.handle);
+			break;
+		case VK_OBJECT_TYPE_IMAGE_VIEW:
+			VulkanBackend::InvalidateDescriptorSets(*deletionQueue.descriptorSetCache, (VkImageView)entry.handle);
+			break;
+		case VK_OBJECT_TYPE_SAMPLER:
+			VulkanBackend::InvalidateDescriptorSets(*deletionQueue.descriptorSetCache, (VkSampler)entry.handle);
+			break;
+		default:
+			break;
+		}
+	}
+
+	switch (entry.type)
+	{
+	case VK_OBJECT_TYPE_BUFFER:
+		vmaDestroyBuffer(deletionQueue.allocator, (VkBuffer)entry.handle, entry.allocation);
+		break;
+	case VK_OBJECT_TYPE_IMAGE:
+		vmaDestroyImage(deletionQueue.allocator, (VkImage)entry.handle, entry.allocation);
+		break;
+	case VK_OBJECT_TYPE_IMAGE_VIEW:
+		vkDestroyImageView(device, (VkImageView)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_SAMPLER:
+		vkDestroySampler(device, (VkSampler)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_FRAMEBUFFER:
+		vkDestroyFramebuffer(device, (VkFramebuffer)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_RENDER_PASS:
+		vkDestroyRenderPass(device, (VkRenderPass)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_PIPELINE:
+		vkDestroyPipeline(device, (VkPipeline)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_PIPELINE_LAYOUT:
+		vkDestroyPipelineLayout(device, (VkPipelineLayout)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+		vkDestroyDescriptorPool(device, (VkDescriptorPool)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT:
+		vkDestroyDescriptorSetLayout(device, (VkDescriptorSetLayout)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_SHADER_MODULE:
+		vkDestroyShaderModule(device, (VkShaderModule)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_SEMAPHORE:
+		vkDestroySemaphore(device, (VkSemaphore)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_FENCE:
+		vkDestroyFence(device, (VkFence)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+		vkDestroySwapchainKHR(device, (VkSwapchainKHR)entry.handle, nullptr);
+		break;
+	case VK_OBJECT_TYPE_DEVICE_MEMORY:
+		vkFreeMemory(device, (VkDeviceMemory)entry.handle, nullptr);
+		break;
+	default:
+		CoreLogError(DefaultLogger, "Vulkan backend: Deferred destruction of an unsupported object type.");
+		break;
+	}
+}
+
+static void TakeCompletedDeletions(VulkanBackend::DeletionQueue& deletionQueue, std::vector<VulkanBackend::DeferredDestruction>& batch)
+{
+	// Entries are tagged in a non-decreasing order, so the completed ones are always at the front.
+	while (!deletionQueue.entries.empty() && deletionQueue.entries.front().frame <= deletionQueue.completedFrame)
+	{
+		batch.push_back(deletionQueue.entries.front());
+		deletionQueue.entries.pop_front();
+	}
+}
+
+static void DeletionWorker(VulkanBackend::DeletionQueue* deletionQueue)
+{
+	std::vector<VulkanBackend::DeferredDestruction> batch;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(deletionQueue->mutex);
+			deletionQueue->condition.wait(lock, [deletionQueue]()
+			{
+				return !deletionQueue->running ||
+					(!deletionQueue->entries.empty() && deletionQueue->entries.front().frame <= deletionQueue->completedFrame);
+			});
+
+			if (!deletionQueue->running)
+			{
+				return;
+			}
+
+			TakeCompletedDeletions(*deletionQueue, batch);
+		}
+
+		// The destruction itself happens outside of the lock, so that deferring never waits for it.
+		for (auto& entry : batch)
+		{
+			DestroyDeferred(*deletionQueue, entry);
+		}
+		batch.clear();
+	}
+}
+
+void VulkanBackend::CreateDeletionQueue(const BackendData& backendData, DeletionQueue& deletionQueue, uint32_t framesInFlight,
+	bool backgroundThread)
+{
+	deletionQueue.logicalDevice = backendData.logicalDevice;
+	deletionQueue.allocator = backendData.allocator;
+	deletionQueue.framebufferCache = backendData.framebufferCache;
+	deletionQueue.descriptorSetCache = backendData.descriptorSetCache;
+	deletionQueue.framesInFlight = framesInFlight;
+	deletionQueue.currentFrame = framesInFlight;
+	deletionQueue.completedFrame = 0;
+
+	if (backgroundThread)
+	{
+		deletionQueue.running = true;
+		deletionQueue.worker = std::thread(DeletionWorker, &deletionQueue);
+	}
+}
+
+void VulkanBackend::DestroyDeletionQueue(DeletionQueue& deletionQueue)
+{
+	if (deletionQueue.worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(deletionQueue.mutex);
+			deletionQueue.running = false;
+		}
+		deletionQueue.condition.notify_one();
+		deletionQueue.worker.join();
+	}
+
+	FlushDeletionQueue(deletionQueue);
+}
+
+void VulkanBackend::AdvanceDeletionFrame(DeletionQueue& deletionQueue)
+{
+	uint64_t completedFrame;
+	{
+		std::lock_guard<std::mutex> lock(deletionQueue.mutex);
+		// The frame tags start at frames in flight, so this never underflows.
+		++deletionQueue.currentFrame;
+		completedFrame = deletionQueue.currentFrame - deletionQueue.framesInFlight;
+	}
+	ReleaseDeletions(deletionQueue, completedFrame);
+}
+
+void VulkanBackend::SetDeletionTimelineValue(DeletionQueue& deletionQueue, uint64_t value)
+{
+	std::lock_guard<std::mutex> lock(deletionQueue.mutex);
+	deletionQueue.currentFrame = value;
+}
+
+void VulkanBackend::ReleaseDeletions(DeletionQueue& deletionQueue, uint64_t completedValue)
+{
+	std::vector<DeferredDestruction> batch;
+	{
+		std::lock_guard<std::mutex> lock(deletionQueue.mutex);
+		deletionQueue.completedFrame = (std::max)(deletionQueue.completedFrame, completedValue);
+
+		if (deletionQueue.running)
+		{
+			deletionQueue.condition.notify_one();
+			return;
+		}
+
+		TakeCompletedDeletions(deletionQueue, batch);
+	}
+
+	for (auto& entry : batch)
+	{
+		DestroyDeferred(deletionQueue, entry);
+	}
+}
+
+void VulkanBackend::FlushDeletionQueue(DeletionQueue& deletionQueue)
+{
+	std::deque<DeferredDestruction> entries;
+	{
+		std::lock_guard<std::mutex> lock(deletionQueue.mutex);
+		entries.swap(deletionQueue.entries);
+	}
+
+	for (auto& entry : entries)
+	{
+		DestroyDeferred(deletionQueue, entry);
+	}
+}
+
+void VulkanBackend::DeferDestroy(DeletionQueue& deletionQueue, VkObjectType type, uint64_t handle, VmaAllocation allocation)
+{
+	if (handle == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(deletionQueue.mutex);
+	deletionQueue.entries.push_back({ deletionQueue.currentFrame, type, handle, allocation });
+}
+
+void VulkanBackend::DeferDestroyBuffer(DeletionQueue& deletionQueue, Buffer& buffer)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_BUFFER, (uint64_t)buffer.buffer, buffer.allocation);
+	// The entries are released in order, so the memory is freed after the buffer.
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_DEVICE_MEMORY, (uint64_t)buffer.importedMemory);
+	buffer.buffer = VK_NULL_HANDLE;
+	buffer.allocation = VK_NULL_HANDLE;
+	buffer.importedMemory = VK_NULL_HANDLE;
+	buffer.deviceAddress = 0;
+}
+
+void VulkanBackend::DeferDestroyImage(DeletionQueue& deletionQueue, Image& image)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_IMAGE, (uint64_t)image.image, image.allocation);
+	image.image = VK_NULL_HANDLE;
+	image.allocation = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyImageView(DeletionQueue& deletionQueue, VkImageView& imageView)
+{
+	// The framebuffers leave the cache now, so nothing acquires them again, and are destroyed together with the view.
+	if (deletionQueue.framebufferCache)
+	{
+		for (auto& framebuffer : DetachFramebuffers(*deletionQueue.framebufferCache, imageView))
+		{
+			DeferDestroyFramebuffer(deletionQueue, framebuffer);
+		}
+	}
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)imageView);
+	imageView = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyImageSampler(DeletionQueue& deletionQueue, VkSampler& sampler)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_SAMPLER, (uint64_t)sampler);
+	sampler = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyFramebuffer(DeletionQueue& deletionQueue, VkFramebuffer& framebuffer)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_FRAMEBUFFER, (uint64_t)framebuffer);
+	framebuffer = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyRenderPass(DeletionQueue& deletionQueue, VkRenderPass& renderPass)
+{
+	if (deletionQueue.framebufferCache)
+	{
+		for (auto& framebuffer : DetachFramebuffers(*deletionQueue.framebufferCache, renderPass))
+		{
+			DeferDestroyFramebuffer(deletionQueue, framebuffer);
+		}
+	}
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_RENDER_PASS, (uint64_t)renderPass);
+	renderPass = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyPipeline(DeletionQueue& deletionQueue, VkPipeline& pipeline)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_PIPELINE, (uint64_t)pipeline);
+	pipeline = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyPipelineLayout(DeletionQueue& deletionQueue, VkPipelineLayout& pipelineLayout)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_PIPELINE_LAYOUT, (uint64_t)pipelineLayout);
+	pipelineLayout = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyDescriptorPool(DeletionQueue& deletionQueue, VkDescriptorPool& descriptorPool)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_DESCRIPTOR_POOL, (uint64_t)descriptorPool);
+	descriptorPool = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyDescriptorSetLayout(DeletionQueue& deletionQueue, VkDescriptorSetLayout& descriptorSetLayout)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, (uint64_t)descriptorSetLayout);
+	descriptorSetLayout = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyShaderModule(DeletionQueue& deletionQueue, VkShaderModule& shaderModule)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_SHADER_MODULE, (uint64_t)shaderModule);
+	shaderModule = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroySemaphore(DeletionQueue& deletionQueue, VkSemaphore& semaphore)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_SEMAPHORE, (uint64_t)semaphore);
+	semaphore = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroyFence(DeletionQueue& deletionQueue, VkFence& fence)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_FENCE, (uint64_t)fence);
+	fence = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DeferDestroySwapchain(DeletionQueue& deletionQueue, VkSwapchainKHR& swapchain)
+{
+	DeferDestroy(deletionQueue, VK_OBJECT_TYPE_SWAPCHAIN_KHR, (uint64_t)swapchain);
+	swapchain = VK_NULL_HANDLE;
+}
@@ -0,0 +1,62 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+
+#ifdef VK_KHR_dynamic_rendering
+
+VkRenderingAttachmentInfoKHR VulkanBackend::GetRenderingAttachmentInfo(VkImageView imageView, VkImageLayout layout, VkAttachmentLoadOp loadOp,
+	VkAttachmentStoreOp storeOp, VkClearValue clearValue)
+{
+	VkRenderingAttachmentInfoKHR attachmentInfo{};
+	attachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+	attachmentInfo.imageView = imageView;
+	attachmentInfo.imageLayout = layout;
+	attachmentInfo.resolveMode = VK_RESOLVE_MODE_NONE_KHR;
+	attachmentInfo.loadOp = loadOp;
+	attachmentInfo.storeOp = storeOp;
+	attachmentInfo.clearValue = clearValue;
+	return attachmentInfo;
+}
+
+VkRenderingAttachmentInfoKHR VulkanBackend::GetRenderingAttachmentInfo(VkImageView imageView, VkImageLayout layout, VkAttachmentLoadOp loadOp,
+	VkAttachmentStoreOp storeOp, VkClearValue clearValue, VkImageView resolveImageView, VkImageLayout resolveLayout,
+	VkResolveModeFlagBits resolveMode)
+{
+	VkRenderingAttachmentInfoKHR attachmentInfo = GetRenderingAttachmentInfo(imageView, layout, loadOp, storeOp, clearValue);
+	attachmentInfo.resolveMode = resolveMode;
+	attachmentInfo.resolveImageView = resolveImageView;
+	attachmentInfo.resolveImageLayout = resolveLayout;
+	return attachmentInfo;
+}
+
+void VulkanBackend::BeginRendering(const BackendData& backendData, VkCommandBuffer commandBuffer, VkRect2D renderArea,
+	const std::vector<VkRenderingAttachmentInfoKHR>& colorAttachments, const VkRenderingAttachmentInfoKHR* depthAttachment,
+	const VkRenderingAttachmentInfoKHR* stencilAttachment, uint32_t layerCount)
+{
+	if (!backendData.cmdBeginRendering)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Dynamic rendering requires the \"VK_KHR_dynamic_rendering\" device extension.");
+		return;
+	}
+
+	VkRenderingInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+	renderingInfo.renderArea = renderArea;
+	renderingInfo.layerCount = layerCount;
+	renderingInfo.colorAttachmentCount = (uint32_t)colorAttachments.size();
+	renderingInfo.pColorAttachments = colorAttachments.data();
+	renderingInfo.pDepthAttachment = depthAttachment;
+	renderingInfo.pStencilAttachment = stencilAttachment;
+
+	backendData.cmdBeginRendering(commandBuffer, &renderingInfo);
+}
+
+void VulkanBackend::EndRendering(const BackendData& backendData, VkCommandBuffer commandBuffer)
+{
+	if (backendData.cmdEndRendering)
+	{
+		backendData.cmdEndRendering(commandBuffer);
+	}
+}
+
+#endif
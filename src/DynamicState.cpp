@@ -0,0 +1,88 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include <algorithm>
+
+bool VulkanBackend::IsDynamicStateSupported(const BackendData& backendData, VkDynamicState state)
+{
+	if (state <= VK_DYNAMIC_STATE_STENCIL_REFERENCE)
+	{
+		return true;
+	}
+	return std::find(backendData.extendedDynamicStates.begin(), backendData.extendedDynamicStates.end(), state) !=
+		backendData.extendedDynamicStates.end();
+}
+
+void VulkanBackend::SetCullMode(const BackendData& backendData, VkCommandBuffer commandBuffer, VkCullModeFlags cullMode)
+{
+	backendData.extendedDynamicStateFunctions.setCullMode(commandBuffer, cullMode);
+}
+
+void VulkanBackend::SetFrontFace(const BackendData& backendData, VkCommandBuffer commandBuffer, VkFrontFace frontFace)
+{
+	backendData.extendedDynamicStateFunctions.setFrontFace(commandBuffer, frontFace);
+}
+
+void VulkanBackend::SetPrimitiveTopology(const BackendData& backendData, VkCommandBuffer commandBuffer, VkPrimitiveTopology topology)
+{
+	backendData.extendedDynamicStateFunctions.setPrimitiveTopology(commandBuffer, topology);
+}
+
+void VulkanBackend::SetDepthTestEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable)
+{
+	backendData.extendedDynamicStateFunctions.setDepthTestEnable(commandBuffer, enable);
+}
+
+void VulkanBackend::SetDepthWriteEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable)
+{
+	backendData.extendedDynamicStateFunctions.setDepthWriteEnable(commandBuffer, enable);
+}
+
+void VulkanBackend::SetDepthCompareOp(const BackendData& backendData, VkCommandBuffer commandBuffer, VkCompareOp compareOp)
+{
+	backendData.extendedDynamicStateFunctions.setDepthCompareOp(commandBuffer, compareOp);
+}
+
+void VulkanBackend::SetStencilTestEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable)
+{
+	backendData.extendedDynamicStateFunctions.setStencilTestEnable(commandBuffer, enable);
+}
+
+#ifdef VK_EXT_extended_dynamic_state2
+void VulkanBackend::SetRasterizerDiscardEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable)
+{
+	backendData.extendedDynamicStateFunctions.setRasterizerDiscardEnable(commandBuffer, enable);
+}
+
+void VulkanBackend::SetDepthBiasEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable)
+{
+	backendData.extendedDynamicStateFunctions.setDepthBiasEnable(commandBuffer, enable);
+}
+
+void VulkanBackend::SetPrimitiveRestartEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBool32 enable)
+{
+	backendData.extendedDynamicStateFunctions.setPrimitiveRestartEnable(commandBuffer, enable);
+}
+#endif
+
+#ifdef VK_EXT_extended_dynamic_state3
+void VulkanBackend::SetPolygonMode(const BackendData& backendData, VkCommandBuffer commandBuffer, VkPolygonMode polygonMode)
+{
+	backendData.extendedDynamicStateFunctions.setPolygonMode(commandBuffer, polygonMode);
+}
+
+void VulkanBackend::SetRasterizationSamples(const BackendData& backendData, VkCommandBuffer commandBuffer, VkSampleCountFlagBits samples)
+{
+	backendData.extendedDynamicStateFunctions.setRasterizationSamples(commandBuffer, samples);
+}
+
+void VulkanBackend::SetColorBlendEnable(const BackendData& backendData, VkCommandBuffer commandBuffer, uint32_t firstAttachment,
+	const std::vector<VkBool32>& enables)
+{
+	backendData.extendedDynamicStateFunctions.setColorBlendEnable(commandBuffer, firstAttachment, (uint32_t)enables.size(), enables.data());
+}
+
+void VulkanBackend::SetColorWriteMask(const BackendData& backendData, VkCommandBuffer commandBuffer, uint32_t firstAttachment,
+	const std::vector<VkColorComponentFlags>& writeMasks)
+{
+	backendData.extendedDynamicStateFunctions.setColorWriteMask(commandBuffer, firstAttachment, (uint32_t)writeMasks.size(), writeMasks.data());
+}
+#endif
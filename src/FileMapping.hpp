@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace FileMapping
+{
+	// Read-only view of a whole file, the pages are loaded lazily by the OS on first access.
+	struct MappedFile
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+	};
+
+	bool Map(const char* path, MappedFile& file);
+	void Unmap(MappedFile& file);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <cstdint>
+
+namespace Formats
+{
+	// Texel block extent and size, 1x1 for uncompressed formats.
+	struct FormatBlock
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t bytes;
+	};
+
+	inline bool GetFormatBlock(VkFormat format, FormatBlock& block)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8_UNORM:
+		case VK_FORMAT_R8_SRGB:
+			block = { 1, 1, 1 };
+			return true;
+		case VK_FORMAT_R8G8_UNORM:
+		case VK_FORMAT_R16_SFLOAT:
+			block = { 1, 1, 2 };
+			return true;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+		case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+		case VK_FORMAT_R16G16_SFLOAT:
+		case VK_FORMAT_R32_SFLOAT:
+			block = { 1, 1, 4 };
+			return true;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+		case VK_FORMAT_R32G32_SFLOAT:
+			block = { 1, 1, 8 };
+			return true;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			block = { 1, 1, 16 };
+			return true;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			block = { 4, 4, 8 };
+			return true;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			block = { 4, 4, 16 };
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Size of tightly packed blocks covering the region, partial blocks at the edges count as whole ones.
+	inline VkDeviceSize GetRegionSize(const FormatBlock& block, uint32_t width, uint32_t height)
+	{
+		const VkDeviceSize blocksWide = (width + block.width - 1) / block.width;
+		const VkDeviceSize blocksHigh = (height + block.height - 1) / block.height;
+		return blocksWide * blocksHigh * block.bytes;
+	}
+}
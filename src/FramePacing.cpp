@@ -0,0 +1,200 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+static constexpr uint64_t presentWaitTimeout = 100000000;
+static constexpr size_t maxPendingInputs = 16;
+static constexpr size_t maxLatencySamples = 256;
+
+static uint64_t GetTimeNanoseconds()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void RecordLatency(VulkanBackend::FramePacer& pacer, uint64_t presentId, uint64_t inputTime, uint64_t presentTime)
+{
+	auto& statistics = pacer.statistics;
+	statistics.lastLatencyMilliseconds = (presentTime - inputTime) / 1000000.0;
+	++statistics.latencySamples;
+
+	statistics.latencies.push_back({ presentId, statistics.lastLatencyMilliseconds });
+	if (statistics.latencies.size() > maxLatencySamples)
+	{
+		statistics.latencies.pop_front();
+	}
+}
+
+static void DropPendingInputs(VulkanBackend::FramePacer& pacer, uint64_t presentId)
+{
+	while (!pacer.pendingInputs.empty() && pacer.pendingInputs.front().first <= presentId)
+	{
+		pacer.pendingInputs.pop_front();
+	}
+}
+
+#ifdef VK_KHR_present_wait
+// Waits for the present of every marked frame up to the given id in turn, so each one is timestamped when its own present completes.
+static void WaitForMarkedPresents(const VulkanBackend::BackendData& backendData, VulkanBackend::FramePacer& pacer,
+	const VulkanBackend::SwapchainManager& manager, uint64_t waitId)
+{
+	while (!pacer.pendingInputs.empty() && pacer.pendingInputs.front().first <= waitId)
+	{
+		const auto input = pacer.pendingInputs.front();
+		pacer.pendingInputs.pop_front();
+		if (input.first < manager.swapchainFirstPresentId)
+		{
+			continue;
+		}
+
+		// A present that has already completed is timestamped when that is observed, an upper bound of its latency.
+		VkResult result = pacer.waitForPresent(backendData.logicalDevice, manager.swapchain, input.first, 0);
+		if (result == VK_TIMEOUT)
+		{
+			result = pacer.waitForPresent(backendData.logicalDevice, manager.swapchain, input.first, presentWaitTimeout);
+		}
+		if (result == VK_SUCCESS)
+		{
+			RecordLatency(pacer, input.first, input.second, GetTimeNanoseconds());
+		}
+		if (result != VK_SUCCESS && result != VK_TIMEOUT && result != VK_ERROR_OUT_OF_DATE_KHR && result != VK_SUBOPTIMAL_KHR)
+		{
+			VulkanCheck(result);
+		}
+	}
+}
+#endif
+
+static void WaitForQueuedFrames(const VulkanBackend::BackendData& backendData, VulkanBackend::FramePacer& pacer,
+	const VulkanBackend::SwapchainManager& manager)
+{
+	// The upcoming frame gets the next id, at most the configured number of frames may be queued in front of it.
+	if (manager.presentId + 1 <= pacer.maxQueuedFrames)
+	{
+		return;
+	}
+	const uint64_t waitId = manager.presentId + 1 - pacer.maxQueuedFrames;
+	if (waitId <= pacer.waitedPresentId)
+	{
+		return;
+	}
+
+#ifdef VK_KHR_present_wait
+	if (pacer.waitForPresent)
+	{
+		WaitForMarkedPresents(backendData, pacer, manager, waitId);
+
+		// Presents to a retired swapchain cannot be waited on through the current one.
+		if (waitId >= manager.swapchainFirstPresentId)
+		{
+			VkResult result = pacer.waitForPresent(backendData.logicalDevice, manager.swapchain, waitId, presentWaitTimeout);
+			if (result != VK_SUCCESS && result != VK_TIMEOUT && result != VK_ERROR_OUT_OF_DATE_KHR && result != VK_SUBOPTIMAL_KHR)
+			{
+				VulkanCheck(result);
+			}
+		}
+		pacer.waitedPresentId = waitId;
+		return;
+	}
+#endif
+
+	// Frame slots are used round robin, so the slot of a frame is known from its distance to the upcoming one.
+	const uint32_t frameCount = (uint32_t)manager.frames.size();
+	if (pacer.maxQueuedFrames < frameCount)
+	{
+		const uint32_t slot = (manager.currentFrame + frameCount - pacer.maxQueuedFrames) % frameCount;
+		const VkFence fence = manager.frames[slot].inFlight;
+		VulkanCheck(vkWaitForFences(backendData.logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX));
+		// Frames finish in submission order, every marked frame up to the waited one is done. As with present wait,
+		// frames that had already finished are timestamped when that is observed.
+		const uint64_t finishTime = GetTimeNanoseconds();
+		for (const auto& input : pacer.pendingInputs)
+		{
+			if (input.first <= waitId)
+			{
+				RecordLatency(pacer, input.first, input.second, finishTime);
+			}
+		}
+	}
+	DropPendingInputs(pacer, waitId);
+	pacer.waitedPresentId = waitId;
+}
+
+VulkanBackend::FramePacer VulkanBackend::CreateFramePacer(const BackendData& backendData, FramePacingMode mode, double targetFrameTimeMilliseconds,
+	uint32_t maxQueuedFrames)
+{
+	FramePacer pacer{};
+	pacer.mode = mode;
+	pacer.targetFrameTimeMilliseconds = targetFrameTimeMilliseconds;
+	pacer.maxQueuedFrames = (std::max)(1u, maxQueuedFrames);
+
+#ifdef VK_KHR_present_wait
+	if (IsDeviceExtensionEnabled(backendData, VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+	{
+		pacer.waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkWaitForPresentKHR"));
+		pacer.presentWaitAvailable = pacer.waitForPresent != nullptr;
+	}
+#endif
+
+	if (!pacer.presentWaitAvailable && mode != FramePacingMode::Unthrottled)
+	{
+		CoreLogInfo(DefaultLogger, "Vulkan backend: Present wait unavailable, frame pacing falls back to GPU completion.");
+	}
+
+	return pacer;
+}
+
+void VulkanBackend::SetFramePacingMode(FramePacer& pacer, FramePacingMode mode, double targetFrameTimeMilliseconds)
+{
+	pacer.mode = mode;
+	pacer.targetFrameTimeMilliseconds = targetFrameTimeMilliseconds;
+}
+
+void VulkanBackend::PaceFrame(const BackendData& backendData, FramePacer& pacer, const SwapchainManager& manager)
+{
+	if (pacer.mode != FramePacingMode::Unthrottled)
+	{
+		WaitForQueuedFrames(backendData, pacer, manager);
+	}
+
+	if (pacer.mode == FramePacingMode::TargetFrameTime && pacer.lastFrameStart != 0)
+	{
+		const uint64_t frameStart = pacer.lastFrameStart + (uint64_t)(pacer.targetFrameTimeMilliseconds * 1000000.0);
+		uint64_t now = GetTimeNanoseconds();
+
+		// Sleeping is too coarse for the last millisecond, the rest is spun.
+		if (frameStart > now + 1000000)
+		{
+			std::this_thread::sleep_for(std::chrono::nanoseconds(frameStart - now - 1000000));
+		}
+		while (GetTimeNanoseconds() < frameStart)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	const uint64_t now = GetTimeNanoseconds();
+	if (pacer.lastFrameStart != 0)
+	{
+		pacer.statistics.lastFrameTimeMilliseconds = (now - pacer.lastFrameStart) / 1000000.0;
+	}
+	pacer.lastFrameStart = now;
+}
+
+void VulkanBackend::MarkFrameInput(FramePacer& pacer, const SwapchainManager& manager)
+{
+	pacer.pendingInputs.emplace_back(manager.presentId + 1, GetTimeNanoseconds());
+	// Frames that never get presented (e.g. skipped ones) would otherwise accumulate.
+	if (pacer.pendingInputs.size() > maxPendingInputs)
+	{
+		pacer.pendingInputs.pop_front();
+	}
+}
+
+VulkanBackend::FramePacingStatistics VulkanBackend::GetFramePacingStatistics(const FramePacer& pacer)
+{
+	return pacer.statistics;
+}
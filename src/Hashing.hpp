@@ -0,0 +1,54 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace Hashing
+{
+	inline void Combine(size_t& seed, size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	template<typename T>
+	inline void CombineValue(size_t& seed, const T& value)
+	{
+		Combine(seed, std::hash<T>()(value));
+	}
+
+	// FNV-1a over raw bytes, used for blobs such as shader code and packed constant data.
+	inline uint64_t Bytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		uint64_t hash = seed;
+		for (size_t b = 0; b < size; ++b)
+		{
+			hash ^= bytes[b];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// Hashes and compares arrays of plain structures as bytes, the element types must not contain padding or pointers.
+	template<typename T>
+	inline void HashArray(uint64_t& hash, const std::vector<T>& values)
+	{
+		const uint64_t count = values.size();
+		hash = Bytes(&count, sizeof(count), hash);
+		hash = Bytes(values.data(), values.size() * sizeof(T), hash);
+	}
+
+	template<typename T>
+	inline void CombineArray(size_t& seed, const std::vector<T>& values)
+	{
+		Combine(seed, (size_t)Bytes(values.data(), values.size() * sizeof(T)));
+	}
+
+	template<typename T>
+	inline bool ArraysEqual(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+}
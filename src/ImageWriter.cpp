@@ -0,0 +1,123 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+// Deflate stored blocks cannot exceed this size.
+static constexpr uint32_t maxStoredBlockSize = 65535;
+
+static uint32_t UpdateCRC(uint32_t crc, const uint8_t* data, size_t size)
+{
+	static uint32_t table[256] = {};
+	static bool tableReady = false;
+	if (!tableReady)
+	{
+		for (uint32_t n = 0; n < 256; ++n)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+			{
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+		tableReady = true;
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+static void PushBigEndian(std::vector<uint8_t>& output, uint32_t value)
+{
+	output.push_back((uint8_t)(value >> 24));
+	output.push_back((uint8_t)(value >> 16));
+	output.push_back((uint8_t)(value >> 8));
+	output.push_back((uint8_t)value);
+}
+
+static void PushChunk(std::vector<uint8_t>& output, const char* type, const std::vector<uint8_t>& data)
+{
+	PushBigEndian(output, (uint32_t)data.size());
+	const size_t typeStart = output.size();
+	output.insert(output.end(), type, type + 4);
+	output.insert(output.end(), data.begin(), data.end());
+
+	// The checksum covers the type and the data, but not the length.
+	const uint32_t crc = UpdateCRC(0xFFFFFFFFu, output.data() + typeStart, output.size() - typeStart) ^ 0xFFFFFFFFu;
+	PushBigEndian(output, crc);
+}
+
+bool VulkanBackend::WriteImagePNG(const char* path, uint32_t width, uint32_t height, const void* pixels, bool bgra)
+{
+	// Each scanline is prefixed by its filter type (none).
+	const size_t rowSize = (size_t)width * 4;
+	std::vector<uint8_t> scanlines((rowSize + 1) * height);
+	const uint8_t* source = (const uint8_t*)pixels;
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		uint8_t* row = scanlines.data() + (rowSize + 1) * y;
+		row[0] = 0;
+		memcpy(row + 1, source + rowSize * y, rowSize);
+		if (bgra)
+		{
+			for (size_t x = 1; x < rowSize + 1; x += 4)
+			{
+				std::swap(row[x], row[x + 2]);
+			}
+		}
+	}
+
+	// The zlib stream uses stored (uncompressed) blocks, the dumps favour speed over size.
+	std::vector<uint8_t> imageData;
+	imageData.reserve(scanlines.size() + scanlines.size() / maxStoredBlockSize * 5 + 11);
+	imageData.push_back(0x78);
+	imageData.push_back(0x01);
+
+	size_t position = 0;
+	do
+	{
+		const uint32_t blockSize = (uint32_t)(std::min)((size_t)maxStoredBlockSize, scanlines.size() - position);
+		const bool finalBlock = position + blockSize == scanlines.size();
+		imageData.push_back(finalBlock ? 1 : 0);
+		imageData.push_back((uint8_t)blockSize);
+		imageData.push_back((uint8_t)(blockSize >> 8));
+		imageData.push_back((uint8_t)~blockSize);
+		imageData.push_back((uint8_t)(~blockSize >> 8));
+		imageData.insert(imageData.end(), scanlines.begin() + position, scanlines.begin() + position + blockSize);
+		position += blockSize;
+	} while (position < scanlines.size());
+
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	for (uint8_t value : scanlines)
+	{
+		adlerA = (adlerA + value) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	PushBigEndian(imageData, (adlerB << 16) | adlerA);
+
+	std::vector<uint8_t> header;
+	PushBigEndian(header, width);
+	PushBigEndian(header, height);
+	// 8-bit depth, RGBA color, default compression, filtering and no interlacing.
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });
+
+	std::vector<uint8_t> output = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	PushChunk(output, "IHDR", header);
+	PushChunk(output, "IDAT", imageData);
+	PushChunk(output, "IEND", {});
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Failed to open %s for writing.", path);
+		return false;
+	}
+	file.write((const char*)output.data(), output.size());
+	return (bool)file;
+}
@@ -1,5 +1,6 @@
 #include "VulkanBackend/VulkanBackendAPI.hpp"
 #include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
 
 VkRenderPass VulkanBackend::CreateRenderPass(const BackendData& backendData, const SurfaceData& surfaceData, bool depth,
 	VkImageLayout colorInitialLayout, VkImageLayout colorFinalLayout)
@@ -92,6 +93,10 @@ VkRenderPass VulkanBackend::CreateRenderPass(const BackendData& backendData, con
 
 void VulkanBackend::DestroyRenderPass(const BackendData& backendData, VkRenderPass& renderPass)
 {
+	if (backendData.framebufferCache)
+	{
+		EvictFramebuffers(backendData, *backendData.framebufferCache, renderPass);
+	}
 	vkDestroyRenderPass(backendData.logicalDevice, renderPass, nullptr);
 	renderPass = VK_NULL_HANDLE;
 }
@@ -133,11 +138,12 @@ void VulkanBackend::DestroyPipelineLayout(const BackendData& backendData, VkPipe
 	pipelineLayout = VK_NULL_HANDLE;
 }
 
-VkPipeline VulkanBackend::CreateGraphicsPipeline(const BackendData& backendData, VkPrimitiveTopology primitiveTopology, VkPolygonMode polygonMode,
-	VkCullModeFlags cullMode, VkFrontFace frontFace, VkColorComponentFlags colorComponents, VkBool32 depthTestEnable,
+// Render pass pipelines have a single color attachment, dynamic rendering ones pass their attachment formats through the chain.
+static VkPipeline BuildGraphicsPipeline(const VulkanBackend::BackendData& backendData, VkPrimitiveTopology primitiveTopology,
+	VkPolygonMode polygonMode, VkCullModeFlags cullMode, VkFrontFace frontFace, VkColorComponentFlags colorComponents, VkBool32 depthTestEnable,
 	VkBool32 depthWriteEnable, VkCompareOp compareOp, VkSampleCountFlagBits sampleCount, const std::vector<VkDynamicState>& dynamicStates,
-	VkPipelineVertexInputStateCreateInfo& vertexInputState, VkRenderPass renderPass, VkPipelineLayout pipelineLayout,
-	const std::vector<VkPipelineShaderStageCreateInfo>& shaderStages, VkPipelineCache pipelineCache)
+	VkPipelineVertexInputStateCreateInfo& vertexInputState, VkRenderPass renderPass, uint32_t colorAttachmentCount, const void* next,
+	VkPipelineLayout pipelineLayout, const std::vector<VkPipelineShaderStageCreateInfo>& shaderStages, VkPipelineCache pipelineCache)
 {
 	VkPipelineInputAssemblyStateCreateInfo assemblyCreateInfo{};
 	assemblyCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -162,10 +168,12 @@ VkPipeline VulkanBackend::CreateGraphicsPipeline(const BackendData& backendData,
 	colorBlendAttachmentCreateInfo.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
 	colorBlendAttachmentCreateInfo.alphaBlendOp = VK_BLEND_OP_ADD;
 
+	std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(colorAttachmentCount, colorBlendAttachmentCreateInfo);
+
 	VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo{};
 	colorBlendCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlendCreateInfo.pAttachments = &colorBlendAttachmentCreateInfo;
-	colorBlendCreateInfo.attachmentCount = 1;
+	colorBlendCreateInfo.pAttachments = colorBlendAttachments.data();
+	colorBlendCreateInfo.attachmentCount = colorAttachmentCount;
 
 	VkPipelineMultisampleStateCreateInfo multisampleCreateInfo{};
 	multisampleCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
@@ -192,6 +200,7 @@ VkPipeline VulkanBackend::CreateGraphicsPipeline(const BackendData& backendData,
 
 	VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
 	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.pNext = next;
 	pipelineCreateInfo.renderPass = renderPass;
 	pipelineCreateInfo.layout = pipelineLayout;
 	pipelineCreateInfo.pVertexInputState = &vertexInputState;
@@ -211,6 +220,44 @@ VkPipeline VulkanBackend::CreateGraphicsPipeline(const BackendData& backendData,
 	return pipeline;
 }
 
+VkPipeline VulkanBackend::CreateGraphicsPipeline(const BackendData& backendData, VkPrimitiveTopology primitiveTopology, VkPolygonMode polygonMode,
+	VkCullModeFlags cullMode, VkFrontFace frontFace, VkColorComponentFlags colorComponents, VkBool32 depthTestEnable,
+	VkBool32 depthWriteEnable, VkCompareOp compareOp, VkSampleCountFlagBits sampleCount, const std::vector<VkDynamicState>& dynamicStates,
+	VkPipelineVertexInputStateCreateInfo& vertexInputState, VkRenderPass renderPass, VkPipelineLayout pipelineLayout,
+	const std::vector<VkPipelineShaderStageCreateInfo>& shaderStages, VkPipelineCache pipelineCache)
+{
+	return BuildGraphicsPipeline(backendData, primitiveTopology, polygonMode, cullMode, frontFace, colorComponents, depthTestEnable,
+		depthWriteEnable, compareOp, sampleCount, dynamicStates, vertexInputState, renderPass, 1, nullptr, pipelineLayout, shaderStages,
+		pipelineCache);
+}
+
+#ifdef VK_KHR_dynamic_rendering
+VkPipeline VulkanBackend::CreateGraphicsPipeline(const BackendData& backendData, VkPrimitiveTopology primitiveTopology, VkPolygonMode polygonMode,
+	VkCullModeFlags cullMode, VkFrontFace frontFace, VkColorComponentFlags colorComponents, VkBool32 depthTestEnable,
+	VkBool32 depthWriteEnable, VkCompareOp compareOp, VkSampleCountFlagBits sampleCount, const std::vector<VkDynamicState>& dynamicStates,
+	VkPipelineVertexInputStateCreateInfo& vertexInputState, const std::vector<VkFormat>& colorFormats, VkFormat depthFormat,
+	VkFormat stencilFormat, VkPipelineLayout pipelineLayout, const std::vector<VkPipelineShaderStageCreateInfo>& shaderStages,
+	VkPipelineCache pipelineCache)
+{
+	if (!backendData.cmdBeginRendering)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Dynamic rendering pipelines require the \"VK_KHR_dynamic_rendering\" device extension.");
+		return VK_NULL_HANDLE;
+	}
+
+	VkPipelineRenderingCreateInfoKHR renderingCreateInfo{};
+	renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	renderingCreateInfo.colorAttachmentCount = (uint32_t)colorFormats.size();
+	renderingCreateInfo.pColorAttachmentFormats = colorFormats.data();
+	renderingCreateInfo.depthAttachmentFormat = depthFormat;
+	renderingCreateInfo.stencilAttachmentFormat = stencilFormat;
+
+	return BuildGraphicsPipeline(backendData, primitiveTopology, polygonMode, cullMode, frontFace, colorComponents, depthTestEnable,
+		depthWriteEnable, compareOp, sampleCount, dynamicStates, vertexInputState, VK_NULL_HANDLE, (uint32_t)colorFormats.size(),
+		&renderingCreateInfo, pipelineLayout, shaderStages, pipelineCache);
+}
+#endif
+
 VkPipeline VulkanBackend::CreateComputePipeline(const BackendData& backendData, VkPipelineLayout pipelineLayout,
 	const VkPipelineShaderStageCreateInfo& shaderStage, VkPipelineCache pipelineCache)
 {
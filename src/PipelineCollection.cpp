@@ -0,0 +1,782 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include "Hashing.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+
+// The create info structures of a description, they point into the description and into each other.
+struct GraphicsPipelineState
+{
+	std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+	std::vector<VkSpecializationInfo> specializationInfos;
+	VkPipelineVertexInputStateCreateInfo vertexInput;
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+	VkPipelineViewportStateCreateInfo viewport;
+	VkPipelineRasterizationStateCreateInfo rasterization;
+	VkPipelineMultisampleStateCreateInfo multisample;
+	VkPipelineDepthStencilStateCreateInfo depthStencil;
+	VkPipelineColorBlendStateCreateInfo colorBlend;
+	VkPipelineDynamicStateCreateInfo dynamic;
+#ifdef VK_KHR_dynamic_rendering
+	VkPipelineRenderingCreateInfoKHR rendering;
+#endif
+};
+
+static bool HasDynamicState(const VulkanBackend::GraphicsPipelineDescription& description, VkDynamicState state)
+{
+	return std::find(description.dynamicStates.begin(), description.dynamicStates.end(), state) != description.dynamicStates.end();
+}
+
+static VkPipelineShaderStageCreateInfo GetShaderStageCreateInfo(const VulkanBackend::PipelineShaderStage& stage,
+	VkSpecializationInfo& specializationInfo)
+{
+	VkPipelineShaderStageCreateInfo shaderStage{};
+	shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStage.stage = stage.stage;
+	shaderStage.module = stage.module;
+	shaderStage.pName = stage.entryPoint.c_str();
+	if (!stage.specialization.entries.empty())
+	{
+		specializationInfo = VulkanBackend::GetSpecializationInfo(stage.specialization);
+		shaderStage.pSpecializationInfo = &specializationInfo;
+	}
+	return shaderStage;
+}
+
+static void FillGraphicsPipelineState(const VulkanBackend::GraphicsPipelineDescription& description, GraphicsPipelineState& state)
+{
+	state.shaderStages.resize(description.shaderStages.size());
+	state.specializationInfos.resize(description.shaderStages.size());
+	for (size_t s = 0; s < description.shaderStages.size(); ++s)
+	{
+		state.shaderStages[s] = GetShaderStageCreateInfo(description.shaderStages[s], state.specializationInfos[s]);
+	}
+
+	state.vertexInput = {};
+	state.vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	state.vertexInput.vertexBindingDescriptionCount = (uint32_t)description.vertexBindings.size();
+	state.vertexInput.pVertexBindingDescriptions = description.vertexBindings.data();
+	state.vertexInput.vertexAttributeDescriptionCount = (uint32_t)description.vertexAttributes.size();
+	state.vertexInput.pVertexAttributeDescriptions = description.vertexAttributes.data();
+
+	state.inputAssembly = {};
+	state.inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	state.inputAssembly.topology = description.topology;
+	state.inputAssembly.primitiveRestartEnable = description.primitiveRestartEnable;
+
+	// The counts have to be zero when they are dynamic as well.
+	state.viewport = {};
+	state.viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	state.viewport.viewportCount = HasDynamicState(description, VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT_EXT) ? 0 : 1;
+	state.viewport.scissorCount = HasDynamicState(description, VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT_EXT) ? 0 : 1;
+
+	state.rasterization = {};
+	state.rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	state.rasterization.polygonMode = description.polygonMode;
+	state.rasterization.cullMode = description.cullMode;
+	state.rasterization.frontFace = description.frontFace;
+	state.rasterization.rasterizerDiscardEnable = description.rasterizerDiscardEnable;
+	state.rasterization.depthBiasEnable = description.depthBiasEnable;
+	state.rasterization.lineWidth = 1.0f;
+
+	state.multisample = {};
+	state.multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	state.multisample.rasterizationSamples = description.sampleCount;
+
+	state.depthStencil = {};
+	state.depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	state.depthStencil.depthTestEnable = description.depthTestEnable;
+	state.depthStencil.depthWriteEnable = description.depthWriteEnable;
+	state.depthStencil.depthCompareOp = description.depthCompareOp;
+	state.depthStencil.stencilTestEnable = description.stencilTestEnable;
+
+	state.colorBlend = {};
+	state.colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	state.colorBlend.attachmentCount = (uint32_t)description.colorBlendAttachments.size();
+	state.colorBlend.pAttachments = description.colorBlendAttachments.data();
+
+	state.dynamic = {};
+	state.dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	state.dynamic.dynamicStateCount = (uint32_t)description.dynamicStates.size();
+	state.dynamic.pDynamicStates = description.dynamicStates.data();
+
+#ifdef VK_KHR_dynamic_rendering
+	state.rendering = {};
+	state.rendering.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	state.rendering.colorAttachmentCount = (uint32_t)description.colorFormats.size();
+	state.rendering.pColorAttachmentFormats = description.colorFormats.data();
+	state.rendering.depthAttachmentFormat = description.depthFormat;
+	state.rendering.stencilAttachmentFormat = description.stencilFormat;
+#endif
+}
+
+static VkGraphicsPipelineCreateInfo GetGraphicsPipelineCreateInfo(const VulkanBackend::GraphicsPipelineDescription& description,
+	GraphicsPipelineState& state)
+{
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stageCount = (uint32_t)state.shaderStages.size();
+	pipelineCreateInfo.pStages = state.shaderStages.data();
+	pipelineCreateInfo.pVertexInputState = &state.vertexInput;
+	pipelineCreateInfo.pInputAssemblyState = &state.inputAssembly;
+	pipelineCreateInfo.pViewportState = &state.viewport;
+	pipelineCreateInfo.pRasterizationState = &state.rasterization;
+	pipelineCreateInfo.pMultisampleState = &state.multisample;
+	pipelineCreateInfo.pDepthStencilState = &state.depthStencil;
+	pipelineCreateInfo.pColorBlendState = &state.colorBlend;
+	pipelineCreateInfo.pDynamicState = &state.dynamic;
+	pipelineCreateInfo.layout = description.layout;
+	pipelineCreateInfo.renderPass = description.renderPass;
+	pipelineCreateInfo.subpass = description.subpass;
+#ifdef VK_KHR_dynamic_rendering
+	if (!description.renderPass)
+	{
+		pipelineCreateInfo.pNext = &state.rendering;
+	}
+#endif
+	return pipelineCreateInfo;
+}
+
+// Dynamic topologies still have to stay within the topology class the pipeline was created with.
+static VkPrimitiveTopology GetTopologyClass(VkPrimitiveTopology topology)
+{
+	switch (topology)
+	{
+	case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+		return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+		return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+	case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+		return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+	default:
+		return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	}
+}
+
+static void CombineShaderStage(size_t& hash, const VulkanBackend::PipelineShaderStage& stage)
+{
+	Hashing::CombineValue(hash, stage.stage);
+	Hashing::CombineValue(hash, stage.module);
+	Hashing::CombineValue(hash, stage.entryPoint);
+	Hashing::CombineArray(hash, stage.specialization.entries);
+	Hashing::CombineArray(hash, stage.specialization.data);
+}
+
+// The specialization constants are expected in the sorted order, with the same id, size and value giving the same bytes.
+static bool ShaderStagesEqual(const VulkanBackend::PipelineShaderStage& a, const VulkanBackend::PipelineShaderStage& b)
+{
+	return a.stage == b.stage && a.module == b.module && a.entryPoint == b.entryPoint &&
+		Hashing::ArraysEqual(a.specialization.entries, b.specialization.entries) &&
+		Hashing::ArraysEqual(a.specialization.data, b.specialization.data);
+}
+
+size_t VulkanBackend::HashGraphicsPipelineDescription(const GraphicsPipelineDescription& description)
+{
+	size_t hash = 0;
+	for (const auto& stage : description.shaderStages)
+	{
+		CombineShaderStage(hash, stage);
+	}
+	Hashing::CombineArray(hash, description.vertexBindings);
+	Hashing::CombineArray(hash, description.vertexAttributes);
+	Hashing::CombineValue(hash, description.topology);
+	Hashing::CombineValue(hash, description.primitiveRestartEnable);
+	Hashing::CombineValue(hash, description.polygonMode);
+	Hashing::CombineValue(hash, description.cullMode);
+	Hashing::CombineValue(hash, description.frontFace);
+	Hashing::CombineValue(hash, description.rasterizerDiscardEnable);
+	Hashing::CombineValue(hash, description.depthBiasEnable);
+	Hashing::CombineValue(hash, description.sampleCount);
+	Hashing::CombineValue(hash, description.depthTestEnable);
+	Hashing::CombineValue(hash, description.depthWriteEnable);
+	Hashing::CombineValue(hash, description.depthCompareOp);
+	Hashing::CombineValue(hash, description.stencilTestEnable);
+	Hashing::CombineArray(hash, description.colorBlendAttachments);
+	Hashing::CombineArray(hash, description.dynamicStates);
+	Hashing::CombineValue(hash, description.layout);
+	Hashing::CombineValue(hash, description.renderPass);
+	Hashing::CombineValue(hash, description.subpass);
+	Hashing::CombineArray(hash, description.colorFormats);
+	Hashing::CombineValue(hash, description.depthFormat);
+	Hashing::CombineValue(hash, description.stencilFormat);
+	return hash;
+}
+
+bool VulkanBackend::GraphicsPipelineDescriptionsEqual(const GraphicsPipelineDescription& a, const GraphicsPipelineDescription& b)
+{
+	if (a.shaderStages.size() != b.shaderStages.size())
+	{
+		return false;
+	}
+	for (size_t s = 0; s < a.shaderStages.size(); ++s)
+	{
+		if (!ShaderStagesEqual(a.shaderStages[s], b.shaderStages[s]))
+		{
+			return false;
+		}
+	}
+
+	return Hashing::ArraysEqual(a.vertexBindings, b.vertexBindings) && Hashing::ArraysEqual(a.vertexAttributes, b.vertexAttributes) &&
+		a.topology == b.topology && a.primitiveRestartEnable == b.primitiveRestartEnable && a.polygonMode == b.polygonMode &&
+		a.cullMode == b.cullMode && a.frontFace == b.frontFace && a.rasterizerDiscardEnable == b.rasterizerDiscardEnable &&
+		a.depthBiasEnable == b.depthBiasEnable && a.sampleCount == b.sampleCount && a.depthTestEnable == b.depthTestEnable &&
+		a.depthWriteEnable == b.depthWriteEnable && a.depthCompareOp == b.depthCompareOp && a.stencilTestEnable == b.stencilTestEnable &&
+		Hashing::ArraysEqual(a.colorBlendAttachments, b.colorBlendAttachments) && Hashing::ArraysEqual(a.dynamicStates, b.dynamicStates) &&
+		a.layout == b.layout && a.renderPass == b.renderPass && a.subpass == b.subpass &&
+		Hashing::ArraysEqual(a.colorFormats, b.colorFormats) && a.depthFormat == b.depthFormat && a.stencilFormat == b.stencilFormat;
+}
+
+size_t VulkanBackend::HashComputePipelineDescription(const ComputePipelineDescription& description)
+{
+	size_t hash = 0;
+	CombineShaderStage(hash, description.shaderStage);
+	Hashing::CombineValue(hash, description.layout);
+	return hash;
+}
+
+bool VulkanBackend::ComputePipelineDescriptionsEqual(const ComputePipelineDescription& a, const ComputePipelineDescription& b)
+{
+	return a.layout == b.layout && ShaderStagesEqual(a.shaderStage, b.shaderStage);
+}
+
+VkPipelineColorBlendAttachmentState VulkanBackend::GetColorBlendAttachmentState(VkBool32 blendEnable, VkColorComponentFlags colorComponents)
+{
+	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+	colorBlendAttachment.colorWriteMask = colorComponents;
+	colorBlendAttachment.blendEnable = blendEnable;
+	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	return colorBlendAttachment;
+}
+
+VulkanBackend::GraphicsPipelineDescription VulkanBackend::NormalizeGraphicsPipelineDescription(const BackendData& backendData,
+	const GraphicsPipelineDescription& description)
+{
+	GraphicsPipelineDescription normalized = description;
+
+	for (auto& stage : normalized.shaderStages)
+	{
+		stage.specialization = SortSpecializationConstants(stage.specialization);
+	}
+
+	// The order of the dynamic states does not matter.
+	auto& dynamicStates = normalized.dynamicStates;
+	dynamicStates.erase(std::remove_if(dynamicStates.begin(), dynamicStates.end(),
+		[&](VkDynamicState state) { return !IsDynamicStateSupported(backendData, state); }), dynamicStates.end());
+	std::sort(dynamicStates.begin(), dynamicStates.end());
+	dynamicStates.erase(std::unique(dynamicStates.begin(), dynamicStates.end()), dynamicStates.end());
+
+	for (VkDynamicState state : dynamicStates)
+	{
+		switch (state)
+		{
+		case VK_DYNAMIC_STATE_CULL_MODE_EXT:
+			normalized.cullMode = VK_CULL_MODE_NONE;
+			break;
+		case VK_DYNAMIC_STATE_FRONT_FACE_EXT:
+			normalized.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+			break;
+		case VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT:
+			normalized.topology = GetTopologyClass(normalized.topology);
+			break;
+		case VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT:
+			normalized.depthTestEnable = VK_FALSE;
+			break;
+		case VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT:
+			normalized.depthWriteEnable = VK_FALSE;
+			break;
+		case VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT:
+			normalized.depthCompareOp = VK_COMPARE_OP_NEVER;
+			break;
+		case VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT:
+			normalized.stencilTestEnable = VK_FALSE;
+			break;
+#ifdef VK_EXT_extended_dynamic_state2
+		case VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE_EXT:
+			normalized.rasterizerDiscardEnable = VK_FALSE;
+			break;
+		case VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT:
+			normalized.depthBiasEnable = VK_FALSE;
+			break;
+		case VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT:
+			normalized.primitiveRestartEnable = VK_FALSE;
+			break;
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+		case VK_DYNAMIC_STATE_POLYGON_MODE_EXT:
+			normalized.polygonMode = VK_POLYGON_MODE_FILL;
+			break;
+		case VK_DYNAMIC_STATE_RASTERIZATION_SAMPLES_EXT:
+			normalized.sampleCount = VK_SAMPLE_COUNT_1_BIT;
+			break;
+		case VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT:
+			for (auto& attachment : normalized.colorBlendAttachments)
+			{
+				attachment.blendEnable = VK_FALSE;
+			}
+			break;
+		case VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT:
+			for (auto& attachment : normalized.colorBlendAttachments)
+			{
+				attachment.colorWriteMask = 0;
+			}
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+
+	return normalized;
+}
+
+VkPipeline VulkanBackend::CreateGraphicsPipeline(const BackendData& backendData, const GraphicsPipelineDescription& description,
+	VkPipelineCache pipelineCache)
+{
+	GraphicsPipelineState state;
+	FillGraphicsPipelineState(description, state);
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo = GetGraphicsPipelineCreateInfo(description, state);
+
+	VkPipeline pipeline;
+	VulkanCheck(vkCreateGraphicsPipelines(backendData.logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline));
+	return pipeline;
+}
+
+VkPipeline VulkanBackend::AcquireGraphicsPipeline(const BackendData& backendData, PipelineCollection& collection,
+	const GraphicsPipelineDescription& description)
+{
+	GraphicsPipelineDescription normalized = NormalizeGraphicsPipelineDescription(backendData, description);
+	const size_t hash = HashGraphicsPipelineDescription(normalized);
+
+	{
+		std::lock_guard<std::mutex> lock(collection.mutex);
+
+		auto range = collection.graphicsPipelines.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (GraphicsPipelineDescriptionsEqual(it->second.description, normalized))
+			{
+				++collection.statistics.hits;
+				return it->second.pipeline;
+			}
+		}
+		++collection.statistics.misses;
+	}
+
+	// Compiling outside of the lock, another thread might finish the same pipeline in the meantime.
+	VkPipeline pipeline = CreateGraphicsPipeline(backendData, normalized, collection.pipelineCache);
+
+	std::lock_guard<std::mutex> lock(collection.mutex);
+
+	auto range = collection.graphicsPipelines.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (GraphicsPipelineDescriptionsEqual(it->second.description, normalized))
+		{
+			DestroyPipeline(backendData, pipeline);
+			return it->second.pipeline;
+		}
+	}
+
+	if (collection.recorder)
+	{
+		RecordGraphicsPipeline(*collection.recorder, normalized);
+	}
+
+	GraphicsPipelineCollectionEntry entry{};
+	entry.description = std::move(normalized);
+	entry.pipeline = pipeline;
+	collection.graphicsPipelines.emplace(hash, std::move(entry));
+	++collection.statistics.liveObjects;
+
+	return pipeline;
+}
+
+VkPipeline VulkanBackend::CreateComputePipeline(const BackendData& backendData, const ComputePipelineDescription& description,
+	VkPipelineCache pipelineCache)
+{
+	VkSpecializationInfo specializationInfo;
+	VkPipelineShaderStageCreateInfo shaderStage = GetShaderStageCreateInfo(description.shaderStage, specializationInfo);
+	return CreateComputePipeline(backendData, description.layout, shaderStage, pipelineCache);
+}
+
+VkPipeline VulkanBackend::AcquireComputePipeline(const BackendData& backendData, PipelineCollection& collection,
+	const ComputePipelineDescription& description)
+{
+	ComputePipelineDescription normalized = description;
+	normalized.shaderStage.specialization = SortSpecializationConstants(description.shaderStage.specialization);
+
+	const size_t hash = HashComputePipelineDescription(normalized);
+
+	auto findPipeline = [&]() -> VkPipeline
+	{
+		auto range = collection.computePipelines.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (ComputePipelineDescriptionsEqual(it->second.description, normalized))
+			{
+				return it->second.pipeline;
+			}
+		}
+		return VK_NULL_HANDLE;
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(collection.mutex);
+		if (VkPipeline existing = findPipeline())
+		{
+			++collection.statistics.hits;
+			return existing;
+		}
+		++collection.statistics.misses;
+	}
+
+	VkPipeline pipeline = CreateComputePipeline(backendData, normalized, collection.pipelineCache);
+
+	std::lock_guard<std::mutex> lock(collection.mutex);
+	if (VkPipeline existing = findPipeline())
+	{
+		DestroyPipeline(backendData, pipeline);
+		return existing;
+	}
+
+	if (collection.recorder)
+	{
+		RecordComputePipeline(*collection.recorder, normalized);
+	}
+
+	ComputePipelineCollectionEntry entry{};
+	entry.description = std::move(normalized);
+	entry.pipeline = pipeline;
+	collection.computePipelines.emplace(hash, std::move(entry));
+	++collection.statistics.liveObjects;
+
+	return pipeline;
+}
+
+#ifdef VK_EXT_graphics_pipeline_library
+static constexpr VkGraphicsPipelineLibraryFlagBitsEXT libraryParts[] =
+{
+	VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+	VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+	VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+	VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT
+};
+
+// Keeps only the state belonging to the part, so that pipelines sharing it share the library as well.
+static VulkanBackend::GraphicsPipelineDescription GetLibraryDescription(const VulkanBackend::GraphicsPipelineDescription& description,
+	VkGraphicsPipelineLibraryFlagBitsEXT part)
+{
+	VulkanBackend::GraphicsPipelineDescription library{};
+	library.dynamicStates = description.dynamicStates;
+
+	switch (part)
+	{
+	case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+		library.vertexBindings = description.vertexBindings;
+		library.vertexAttributes = description.vertexAttributes;
+		library.topology = description.topology;
+		library.primitiveRestartEnable = description.primitiveRestartEnable;
+		// The vertex input does not depend on the layout or the render targets.
+		return library;
+	case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+		for (const auto& stage : description.shaderStages)
+		{
+			if (stage.stage != VK_SHADER_STAGE_FRAGMENT_BIT)
+			{
+				library.shaderStages.push_back(stage);
+			}
+		}
+		library.polygonMode = description.polygonMode;
+		library.cullMode = description.cullMode;
+		library.frontFace = description.frontFace;
+		library.rasterizerDiscardEnable = description.rasterizerDiscardEnable;
+		library.depthBiasEnable = description.depthBiasEnable;
+		library.layout = description.layout;
+		break;
+	case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+		for (const auto& stage : description.shaderStages)
+		{
+			if (stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+			{
+				library.shaderStages.push_back(stage);
+			}
+		}
+		library.sampleCount = description.sampleCount;
+		library.depthTestEnable = description.depthTestEnable;
+		library.depthWriteEnable = description.depthWriteEnable;
+		library.depthCompareOp = description.depthCompareOp;
+		library.stencilTestEnable = description.stencilTestEnable;
+		library.layout = description.layout;
+		break;
+	default:
+		library.colorBlendAttachments = description.colorBlendAttachments;
+		library.sampleCount = description.sampleCount;
+		break;
+	}
+
+	library.renderPass = description.renderPass;
+	library.subpass = description.subpass;
+	library.colorFormats = description.colorFormats;
+	library.depthFormat = description.depthFormat;
+	library.stencilFormat = description.stencilFormat;
+	return library;
+}
+
+static VkPipeline CreateGraphicsPipelineLibrary(const VulkanBackend::BackendData& backendData, const VulkanBackend::GraphicsPipelineDescription& library,
+	VkGraphicsPipelineLibraryFlagBitsEXT part, VkPipelineCache pipelineCache)
+{
+	GraphicsPipelineState state;
+	FillGraphicsPipelineState(library, state);
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo = GetGraphicsPipelineCreateInfo(library, state);
+
+	VkGraphicsPipelineLibraryCreateInfoEXT libraryCreateInfo{};
+	libraryCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+	libraryCreateInfo.flags = part;
+	libraryCreateInfo.pNext = part == VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT ? nullptr : pipelineCreateInfo.pNext;
+	pipelineCreateInfo.pNext = &libraryCreateInfo;
+	// Retaining the link time optimization info allows the optimized pipeline to be linked from the same libraries.
+	pipelineCreateInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+	VkPipeline pipeline;
+	VulkanCheck(vkCreateGraphicsPipelines(backendData.logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline));
+	return pipeline;
+}
+
+static VkPipeline AcquireGraphicsPipelineLibrary(const VulkanBackend::BackendData& backendData, VulkanBackend::PipelineCollection& collection,
+	const VulkanBackend::GraphicsPipelineDescription& description, VkGraphicsPipelineLibraryFlagBitsEXT part)
+{
+	VulkanBackend::GraphicsPipelineDescription library = GetLibraryDescription(description, part);
+	size_t hash = VulkanBackend::HashGraphicsPipelineDescription(library);
+	Hashing::CombineValue(hash, (uint32_t)part);
+
+	auto findLibrary = [&]() -> VkPipeline
+	{
+		auto range = collection.libraries.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (it->second.part == (uint32_t)part && VulkanBackend::GraphicsPipelineDescriptionsEqual(it->second.description, library))
+			{
+				return it->second.library;
+			}
+		}
+		return VK_NULL_HANDLE;
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(collection.mutex);
+		if (VkPipeline existing = findLibrary())
+		{
+			return existing;
+		}
+	}
+
+	VkPipeline pipeline = CreateGraphicsPipelineLibrary(backendData, library, part, collection.pipelineCache);
+
+	std::lock_guard<std::mutex> lock(collection.mutex);
+	if (VkPipeline existing = findLibrary())
+	{
+		VulkanBackend::DestroyPipeline(backendData, pipeline);
+		return existing;
+	}
+
+	VulkanBackend::GraphicsPipelineLibraryEntry entry{};
+	entry.part = (uint32_t)part;
+	entry.description = std::move(library);
+	entry.library = pipeline;
+	collection.libraries.emplace(hash, std::move(entry));
+	return pipeline;
+}
+
+static VkPipeline LinkGraphicsPipeline(const VulkanBackend::BackendData& backendData, VulkanBackend::PipelineCollection& collection,
+	const VulkanBackend::GraphicsPipelineDescription& description, bool optimize)
+{
+	VkPipeline libraries[4];
+	for (int p = 0; p < 4; ++p)
+	{
+		libraries[p] = AcquireGraphicsPipelineLibrary(backendData, collection, description, libraryParts[p]);
+	}
+
+	VkPipelineLibraryCreateInfoKHR libraryCreateInfo{};
+	libraryCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+	libraryCreateInfo.libraryCount = 4;
+	libraryCreateInfo.pLibraries = libraries;
+
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.pNext = &libraryCreateInfo;
+	pipelineCreateInfo.layout = description.layout;
+	pipelineCreateInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+
+	VkPipeline pipeline;
+	VulkanCheck(vkCreateGraphicsPipelines(backendData.logicalDevice, collection.pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline));
+	return pipeline;
+}
+
+static void OptimizerWorker(const VulkanBackend::BackendData* backendData, VulkanBackend::PipelineCollection* collection)
+{
+	while (true)
+	{
+		VulkanBackend::PipelineOptimization optimization;
+		{
+			std::unique_lock<std::mutex> lock(collection->mutex);
+			collection->optimizerCondition.wait(lock, [collection]()
+			{
+				return !collection->optimizerRunning || !collection->pendingOptimizations.empty();
+			});
+
+			// Queued optimizations are still finished after the collection asks the worker to stop.
+			if (collection->pendingOptimizations.empty())
+			{
+				return;
+			}
+
+			optimization = std::move(collection->pendingOptimizations.front());
+			collection->pendingOptimizations.pop_front();
+		}
+
+		VkPipeline optimized = LinkGraphicsPipeline(*backendData, *collection, optimization.description, true);
+
+		// Frames might still be using the linked pipeline, it goes through the deletion queue.
+		VkPipeline linked = VK_NULL_HANDLE;
+		{
+			std::lock_guard<std::mutex> lock(collection->mutex);
+			auto range = collection->graphicsPipelines.equal_range(optimization.hash);
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				if (it->second.linked && VulkanBackend::GraphicsPipelineDescriptionsEqual(it->second.description, optimization.description))
+				{
+					linked = it->second.pipeline;
+					it->second.pipeline = optimized;
+					it->second.linked = false;
+					break;
+				}
+			}
+		}
+
+		if (linked)
+		{
+			VulkanBackend::DeferDestroyPipeline(*optimization.deletionQueue, linked);
+		}
+		else
+		{
+			VulkanBackend::DestroyPipeline(*backendData, optimized);
+		}
+	}
+}
+#endif
+
+VkPipeline VulkanBackend::AcquireLinkedGraphicsPipeline(const BackendData& backendData, PipelineCollection& collection,
+	const GraphicsPipelineDescription& description, DeletionQueue* deletionQueue)
+{
+#ifdef VK_EXT_graphics_pipeline_library
+	if (!IsDeviceExtensionEnabled(backendData, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+	{
+		return AcquireGraphicsPipeline(backendData, collection, description);
+	}
+
+	GraphicsPipelineDescription normalized = NormalizeGraphicsPipelineDescription(backendData, description);
+	const size_t hash = HashGraphicsPipelineDescription(normalized);
+
+	{
+		std::lock_guard<std::mutex> lock(collection.mutex);
+
+		auto range = collection.graphicsPipelines.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (GraphicsPipelineDescriptionsEqual(it->second.description, normalized))
+			{
+				++collection.statistics.hits;
+				return it->second.pipeline;
+			}
+		}
+		++collection.statistics.misses;
+	}
+
+	VkPipeline pipeline = LinkGraphicsPipeline(backendData, collection, normalized, false);
+
+	std::lock_guard<std::mutex> lock(collection.mutex);
+
+	auto range = collection.graphicsPipelines.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (GraphicsPipelineDescriptionsEqual(it->second.description, normalized))
+		{
+			DestroyPipeline(backendData, pipeline);
+			return it->second.pipeline;
+		}
+	}
+
+	if (deletionQueue)
+	{
+		if (!collection.optimizerRunning)
+		{
+			collection.optimizerRunning = true;
+			collection.optimizer = std::thread(OptimizerWorker, &backendData, &collection);
+		}
+		collection.pendingOptimizations.push_back({ hash, normalized, deletionQueue });
+		collection.optimizerCondition.notify_one();
+	}
+
+	if (collection.recorder)
+	{
+		RecordGraphicsPipeline(*collection.recorder, normalized);
+	}
+
+	GraphicsPipelineCollectionEntry entry{};
+	entry.description = std::move(normalized);
+	entry.pipeline = pipeline;
+	entry.linked = true;
+	collection.graphicsPipelines.emplace(hash, std::move(entry));
+	++collection.statistics.liveObjects;
+
+	return pipeline;
+#else
+	return AcquireGraphicsPipeline(backendData, collection, description);
+#endif
+}
+
+void VulkanBackend::DestroyPipelineCollection(const BackendData& backendData, PipelineCollection& collection)
+{
+	if (collection.optimizer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(collection.mutex);
+			collection.optimizerRunning = false;
+		}
+		collection.optimizerCondition.notify_one();
+		collection.optimizer.join();
+	}
+
+	std::lock_guard<std::mutex> lock(collection.mutex);
+
+	for (auto& entry : collection.graphicsPipelines)
+	{
+		DestroyPipeline(backendData, entry.second.pipeline);
+	}
+	collection.graphicsPipelines.clear();
+	for (auto& entry : collection.libraries)
+	{
+		DestroyPipeline(backendData, entry.second.library);
+	}
+	collection.libraries.clear();
+	for (auto& entry : collection.computePipelines)
+	{
+		DestroyPipeline(backendData, entry.second.pipeline);
+	}
+	collection.computePipelines.clear();
+	collection.statistics = {};
+}
+
+VulkanBackend::CacheStatistics VulkanBackend::GetPipelineCollectionStatistics(PipelineCollection& collection)
+{
+	std::lock_guard<std::mutex> lock(collection.mutex);
+	return collection.statistics;
+}
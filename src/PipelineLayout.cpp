@@ -0,0 +1,337 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include "Hashing.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+// The order in which the bindings and ranges were added does not matter.
+static VulkanBackend::DescriptorSetLayoutDescription NormalizeDescriptorSetLayoutDescription(
+	const VulkanBackend::DescriptorSetLayoutDescription& description)
+{
+	VulkanBackend::DescriptorSetLayoutDescription normalized = description;
+	std::sort(normalized.bindings.begin(), normalized.bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+		{
+			return a.binding < b.binding;
+		});
+	return normalized;
+}
+
+static VulkanBackend::PipelineLayoutDescription NormalizePipelineLayoutDescription(const VulkanBackend::PipelineLayoutDescription& description)
+{
+	VulkanBackend::PipelineLayoutDescription normalized;
+	for (const auto& set : description.sets)
+	{
+		normalized.sets.push_back(NormalizeDescriptorSetLayoutDescription(set));
+	}
+	normalized.pushConstantRanges = description.pushConstantRanges;
+	std::sort(normalized.pushConstantRanges.begin(), normalized.pushConstantRanges.end(), [](const VkPushConstantRange& a, const VkPushConstantRange& b)
+		{
+			return a.offset != b.offset ? a.offset < b.offset : a.stageFlags < b.stageFlags;
+		});
+	return normalized;
+}
+
+// The sampler array is only read for sampler bindings, for any other type the pointer is ignored.
+static uint32_t GetImmutableSamplerCount(const VkDescriptorSetLayoutBinding& binding)
+{
+	const bool samplerType = binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+		binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	return samplerType && binding.pImmutableSamplers ? binding.descriptorCount : 0;
+}
+
+// The cached descriptions outlive the sampler arrays of the caller, so the handles are copied into the given storage.
+// The storage has to be filled for all the sets of an entry in one go, it must not reallocate afterwards.
+static void CopyImmutableSamplers(std::vector<VulkanBackend::DescriptorSetLayoutDescription>& sets, std::vector<VkSampler>& storage)
+{
+	size_t samplerCount = 0;
+	for (const auto& set : sets)
+	{
+		for (const auto& binding : set.bindings)
+		{
+			samplerCount += GetImmutableSamplerCount(binding);
+		}
+	}
+	storage.reserve(storage.size() + samplerCount);
+
+	for (auto& set : sets)
+	{
+		for (auto& binding : set.bindings)
+		{
+			const uint32_t count = GetImmutableSamplerCount(binding);
+			if (count == 0)
+			{
+				binding.pImmutableSamplers = nullptr;
+				continue;
+			}
+			const size_t first = storage.size();
+			storage.insert(storage.end(), binding.pImmutableSamplers, binding.pImmutableSamplers + count);
+			binding.pImmutableSamplers = storage.data() + first;
+		}
+	}
+}
+
+// The binding structure ends with the sampler pointer, the fields in front of it are hashed as bytes and the handles it
+// points to are hashed instead of the pointer itself.
+static uint64_t HashDescriptorSetLayoutDescription(const VulkanBackend::DescriptorSetLayoutDescription& description,
+	uint64_t hash = Hashing::Bytes(nullptr, 0))
+{
+	const uint64_t count = description.bindings.size();
+	hash = Hashing::Bytes(&count, sizeof(count), hash);
+	for (const auto& binding : description.bindings)
+	{
+		hash = Hashing::Bytes(&binding, offsetof(VkDescriptorSetLayoutBinding, pImmutableSamplers), hash);
+		hash = Hashing::Bytes(binding.pImmutableSamplers, GetImmutableSamplerCount(binding) * sizeof(VkSampler), hash);
+	}
+	return Hashing::Bytes(&description.flags, sizeof(description.flags), hash);
+}
+
+static bool DescriptorSetLayoutBindingsEqual(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+{
+	const uint32_t samplerCount = GetImmutableSamplerCount(a);
+	return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount &&
+		a.stageFlags == b.stageFlags && samplerCount == GetImmutableSamplerCount(b) &&
+		(samplerCount == 0 || memcmp(a.pImmutableSamplers, b.pImmutableSamplers, samplerCount * sizeof(VkSampler)) == 0);
+}
+
+static bool DescriptorSetLayoutDescriptionsEqual(const VulkanBackend::DescriptorSetLayoutDescription& a,
+	const VulkanBackend::DescriptorSetLayoutDescription& b)
+{
+	if (a.flags != b.flags || a.bindings.size() != b.bindings.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.bindings.size(); ++i)
+	{
+		if (!DescriptorSetLayoutBindingsEqual(a.bindings[i], b.bindings[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static size_t HashPipelineLayoutDescription(const VulkanBackend::PipelineLayoutDescription& description)
+{
+	uint64_t hash = Hashing::Bytes(nullptr, 0);
+	for (const auto& set : description.sets)
+	{
+		hash = HashDescriptorSetLayoutDescription(set, hash);
+	}
+	Hashing::HashArray(hash, description.pushConstantRanges);
+	return (size_t)hash;
+}
+
+static bool PipelineLayoutDescriptionsEqual(const VulkanBackend::PipelineLayoutDescription& a, const VulkanBackend::PipelineLayoutDescription& b)
+{
+	if (a.sets.size() != b.sets.size() || !Hashing::ArraysEqual(a.pushConstantRanges, b.pushConstantRanges))
+	{
+		return false;
+	}
+	for (size_t s = 0; s < a.sets.size(); ++s)
+	{
+		if (!DescriptorSetLayoutDescriptionsEqual(a.sets[s], b.sets[s]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool IsPipelineLayoutSupported(const VulkanBackend::BackendData& backendData, const VulkanBackend::PipelineLayoutDescription& description)
+{
+	const VkPhysicalDeviceLimits& limits = backendData.deviceProperties.limits;
+	if (description.sets.size() > limits.maxBoundDescriptorSets)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Pipeline layout uses %u descriptor sets, the device supports %u.",
+			(uint32_t)description.sets.size(), limits.maxBoundDescriptorSets);
+		return false;
+	}
+
+	// Each shader stage may appear in one push constant range only.
+	VkShaderStageFlags usedStages = 0;
+	for (const auto& range : description.pushConstantRanges)
+	{
+		if (range.offset + range.size > limits.maxPushConstantsSize)
+		{
+			CoreLogError(DefaultLogger, "Vulkan backend: Push constant range ends at %u bytes, the device supports %u.",
+				range.offset + range.size, limits.maxPushConstantsSize);
+			return false;
+		}
+		if (usedStages & range.stageFlags)
+		{
+			CoreLogError(DefaultLogger, "Vulkan backend: A shader stage appears in more than one push constant range.");
+			return false;
+		}
+		usedStages |= range.stageFlags;
+	}
+
+	return true;
+}
+
+void VulkanBackend::AddDescriptorBinding(PipelineLayoutDescription& description, uint32_t set, uint32_t binding, VkDescriptorType type,
+	VkShaderStageFlags stages, uint32_t descriptorCount)
+{
+	if (set >= description.sets.size())
+	{
+		description.sets.resize(set + 1);
+	}
+
+	VkDescriptorSetLayoutBinding layoutBinding{};
+	layoutBinding.binding = binding;
+	layoutBinding.descriptorType = type;
+	layoutBinding.descriptorCount = descriptorCount;
+	layoutBinding.stageFlags = stages;
+
+	auto& bindings = description.sets[set].bindings;
+	auto it = std::find_if(bindings.begin(), bindings.end(), [binding](const VkDescriptorSetLayoutBinding& b) { return b.binding == binding; });
+	if (it != bindings.end())
+	{
+		// Stages sharing a binding have to agree on its type and size.
+		if (it->descriptorType != type || it->descriptorCount != descriptorCount)
+		{
+			CoreLogError(DefaultLogger, "Vulkan backend: Conflicting declarations of the binding %u in the descriptor set %u.", binding, set);
+		}
+		it->stageFlags |= stages;
+		return;
+	}
+	bindings.push_back(layoutBinding);
+}
+
+void VulkanBackend::AddPushConstantRange(PipelineLayoutDescription& description, VkShaderStageFlags stages, uint32_t offset, uint32_t size)
+{
+	description.pushConstantRanges.push_back({ stages, offset, size });
+}
+
+VkDescriptorSetLayout VulkanBackend::CreateDescriptorSetLayout(const BackendData& backendData, const DescriptorSetLayoutDescription& description)
+{
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptorSetLayoutCreateInfo.flags = description.flags;
+	descriptorSetLayoutCreateInfo.bindingCount = (uint32_t)description.bindings.size();
+	descriptorSetLayoutCreateInfo.pBindings = description.bindings.data();
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VulkanCheck(vkCreateDescriptorSetLayout(backendData.logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout));
+	return descriptorSetLayout;
+}
+
+VkPipelineLayout VulkanBackend::CreatePipelineLayout(const BackendData& backendData, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+	const std::vector<VkPushConstantRange>& pushConstantRanges)
+{
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = (uint32_t)descriptorSetLayouts.size();
+	pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
+	pipelineLayoutCreateInfo.pushConstantRangeCount = (uint32_t)pushConstantRanges.size();
+	pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+
+	VkPipelineLayout pipelineLayout;
+	VulkanCheck(vkCreatePipelineLayout(backendData.logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout));
+	return pipelineLayout;
+}
+
+// Expects the cache to be locked and the description to be normalized.
+static VkDescriptorSetLayout AcquireNormalizedDescriptorSetLayout(const VulkanBackend::BackendData& backendData, VulkanBackend::LayoutCache& cache,
+	const VulkanBackend::DescriptorSetLayoutDescription& description)
+{
+	const size_t hash = (size_t)HashDescriptorSetLayoutDescription(description);
+
+	auto range = cache.descriptorSetLayouts.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (DescriptorSetLayoutDescriptionsEqual(it->second.description, description))
+		{
+			++cache.statistics.hits;
+			return it->second.descriptorSetLayout;
+		}
+	}
+
+	++cache.statistics.misses;
+
+	VulkanBackend::DescriptorSetLayoutCacheEntry entry{};
+	std::vector<VulkanBackend::DescriptorSetLayoutDescription> sets(1, description);
+	CopyImmutableSamplers(sets, entry.immutableSamplers);
+	entry.description = std::move(sets[0]);
+	entry.descriptorSetLayout = VulkanBackend::CreateDescriptorSetLayout(backendData, description);
+
+	VkDescriptorSetLayout descriptorSetLayout = entry.descriptorSetLayout;
+	cache.descriptorSetLayouts.emplace(hash, std::move(entry));
+	++cache.statistics.liveObjects;
+
+	return descriptorSetLayout;
+}
+
+VkDescriptorSetLayout VulkanBackend::AcquireDescriptorSetLayout(const BackendData& backendData, LayoutCache& cache,
+	const DescriptorSetLayoutDescription& description)
+{
+	DescriptorSetLayoutDescription normalized = NormalizeDescriptorSetLayoutDescription(description);
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	return AcquireNormalizedDescriptorSetLayout(backendData, cache, normalized);
+}
+
+VkPipelineLayout VulkanBackend::AcquirePipelineLayout(const BackendData& backendData, LayoutCache& cache, const PipelineLayoutDescription& description)
+{
+	PipelineLayoutDescription normalized = NormalizePipelineLayoutDescription(description);
+	const size_t hash = HashPipelineLayoutDescription(normalized);
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto range = cache.pipelineLayouts.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (PipelineLayoutDescriptionsEqual(it->second.description, normalized))
+		{
+			++cache.statistics.hits;
+			return it->second.pipelineLayout;
+		}
+	}
+
+	if (!IsPipelineLayoutSupported(backendData, normalized))
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	++cache.statistics.misses;
+
+	PipelineLayoutCacheEntry entry{};
+	for (const auto& set : normalized.sets)
+	{
+		entry.descriptorSetLayouts.push_back(AcquireNormalizedDescriptorSetLayout(backendData, cache, set));
+	}
+	entry.pipelineLayout = CreatePipelineLayout(backendData, entry.descriptorSetLayouts, normalized.pushConstantRanges);
+	CopyImmutableSamplers(normalized.sets, entry.immutableSamplers);
+	entry.description = std::move(normalized);
+
+	VkPipelineLayout pipelineLayout = entry.pipelineLayout;
+	cache.pipelineLayouts.emplace(hash, std::move(entry));
+	++cache.statistics.liveObjects;
+
+	return pipelineLayout;
+}
+
+void VulkanBackend::DestroyLayoutCache(const BackendData& backendData, LayoutCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	// The pipeline layouts go first, they reference the set layouts.
+	for (auto& entry : cache.pipelineLayouts)
+	{
+		DestroyPipelineLayout(backendData, entry.second.pipelineLayout);
+	}
+	cache.pipelineLayouts.clear();
+	for (auto& entry : cache.descriptorSetLayouts)
+	{
+		DestroyDescriptorSetLayout(backendData, entry.second.descriptorSetLayout);
+	}
+	cache.descriptorSetLayouts.clear();
+	cache.statistics = {};
+}
+
+VulkanBackend::CacheStatistics VulkanBackend::GetLayoutCacheStatistics(LayoutCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	return cache.statistics;
+}
@@ -0,0 +1,636 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include "Hashing.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+static constexpr uint32_t manifestMagic = 0x4D504256; // "VBPM"
+static constexpr uint32_t manifestVersion = 2;
+// Graphics pipelines have at most a vertex, two tessellation, a geometry and a fragment stage.
+static constexpr uint32_t maxGraphicsStages = 5;
+
+enum class PipelineRecordType : uint8_t
+{
+	Graphics,
+	Compute
+};
+
+// All the serialized structures consist of fixed size fields without padding, they are written as raw bytes.
+template<typename T>
+static void WriteValue(std::vector<uint8_t>& data, const T& value)
+{
+	const uint8_t* bytes = (const uint8_t*)&value;
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+static void WriteArray(std::vector<uint8_t>& data, const std::vector<T>& values)
+{
+	WriteValue(data, (uint32_t)values.size());
+	const uint8_t* bytes = (const uint8_t*)values.data();
+	data.insert(data.end(), bytes, bytes + values.size() * sizeof(T));
+}
+
+static void WriteString(std::vector<uint8_t>& data, const std::string& value)
+{
+	WriteValue(data, (uint32_t)value.size());
+	data.insert(data.end(), value.begin(), value.end());
+}
+
+// Every record is prefixed with its size and checksum, a corrupted record is skipped without losing the following ones.
+static void WriteRecord(std::vector<uint8_t>& data, const std::vector<uint8_t>& record)
+{
+	WriteValue(data, (uint32_t)record.size());
+	WriteValue(data, Hashing::Bytes(record.data(), record.size()));
+	data.insert(data.end(), record.begin(), record.end());
+}
+
+struct ManifestReader
+{
+	const uint8_t* data;
+	size_t size;
+	size_t offset;
+	bool failed;
+};
+
+static bool ReadBytes(ManifestReader& reader, void* destination, size_t size)
+{
+	if (reader.failed || size > reader.size - reader.offset)
+	{
+		reader.failed = true;
+		return false;
+	}
+	if (size > 0)
+	{
+		memcpy(destination, reader.data + reader.offset, size);
+	}
+	reader.offset += size;
+	return true;
+}
+
+template<typename T>
+static void ReadValue(ManifestReader& reader, T& value)
+{
+	ReadBytes(reader, &value, sizeof(T));
+}
+
+template<typename T>
+static void ReadArray(ManifestReader& reader, std::vector<T>& values)
+{
+	uint32_t count = 0;
+	ReadValue(reader, count);
+	if (reader.failed || (size_t)count * sizeof(T) > reader.size - reader.offset)
+	{
+		reader.failed = true;
+		return;
+	}
+	values.resize(count);
+	ReadBytes(reader, values.data(), count * sizeof(T));
+}
+
+static void ReadString(ManifestReader& reader, std::string& value)
+{
+	std::vector<char> characters;
+	ReadArray(reader, characters);
+	value.assign(characters.begin(), characters.end());
+}
+
+// Expects the recorder to be locked. Null handles are written as the zero key.
+static bool GetObjectKey(const VulkanBackend::PipelineRecorder& recorder, uint64_t handle, uint64_t& key)
+{
+	if (!handle)
+	{
+		key = 0;
+		return true;
+	}
+	auto it = recorder.objectKeys.find(handle);
+	if (it == recorder.objectKeys.end())
+	{
+		return false;
+	}
+	key = it->second;
+	return true;
+}
+
+// Expects the recorder to be locked.
+static bool GetKeyObject(const VulkanBackend::PipelineRecorder& recorder, uint64_t key, uint64_t& handle)
+{
+	if (!key)
+	{
+		handle = 0;
+		return true;
+	}
+	auto it = recorder.keyObjects.find(key);
+	if (it == recorder.keyObjects.end())
+	{
+		return false;
+	}
+	handle = it->second;
+	return true;
+}
+
+static bool WriteShaderStage(const VulkanBackend::PipelineRecorder& recorder, std::vector<uint8_t>& data,
+	const VulkanBackend::PipelineShaderStage& stage)
+{
+	uint64_t moduleKey;
+	if (!GetObjectKey(recorder, (uint64_t)stage.module, moduleKey))
+	{
+		return false;
+	}
+	WriteValue(data, stage.stage);
+	WriteValue(data, moduleKey);
+	WriteString(data, stage.entryPoint);
+	WriteArray(data, stage.specialization.entries);
+	WriteArray(data, stage.specialization.data);
+	return true;
+}
+
+static bool ReadShaderStage(const VulkanBackend::PipelineRecorder& recorder, ManifestReader& reader, VulkanBackend::PipelineShaderStage& stage)
+{
+	uint64_t moduleKey = 0;
+	ReadValue(reader, stage.stage);
+	ReadValue(reader, moduleKey);
+	ReadString(reader, stage.entryPoint);
+	ReadArray(reader, stage.specialization.entries);
+	ReadArray(reader, stage.specialization.data);
+
+	uint64_t module;
+	if (reader.failed || !GetKeyObject(recorder, moduleKey, module))
+	{
+		return false;
+	}
+	stage.module = (VkShaderModule)module;
+	return true;
+}
+
+static bool WriteGraphicsPipeline(const VulkanBackend::PipelineRecorder& recorder, std::vector<uint8_t>& data,
+	const VulkanBackend::GraphicsPipelineDescription& description)
+{
+	uint64_t layoutKey, renderPassKey;
+	if (!GetObjectKey(recorder, (uint64_t)description.layout, layoutKey) ||
+		!GetObjectKey(recorder, (uint64_t)description.renderPass, renderPassKey))
+	{
+		return false;
+	}
+
+	WriteValue(data, PipelineRecordType::Graphics);
+	WriteValue(data, (uint32_t)description.shaderStages.size());
+	for (const auto& stage : description.shaderStages)
+	{
+		if (!WriteShaderStage(recorder, data, stage))
+		{
+			return false;
+		}
+	}
+	WriteArray(data, description.vertexBindings);
+	WriteArray(data, description.vertexAttributes);
+	WriteValue(data, description.topology);
+	WriteValue(data, description.primitiveRestartEnable);
+	WriteValue(data, description.polygonMode);
+	WriteValue(data, description.cullMode);
+	WriteValue(data, description.frontFace);
+	WriteValue(data, description.rasterizerDiscardEnable);
+	WriteValue(data, description.depthBiasEnable);
+	WriteValue(data, description.sampleCount);
+	WriteValue(data, description.depthTestEnable);
+	WriteValue(data, description.depthWriteEnable);
+	WriteValue(data, description.depthCompareOp);
+	WriteValue(data, description.stencilTestEnable);
+	WriteArray(data, description.colorBlendAttachments);
+	WriteArray(data, description.dynamicStates);
+	WriteValue(data, layoutKey);
+	WriteValue(data, renderPassKey);
+	WriteValue(data, description.subpass);
+	WriteArray(data, description.colorFormats);
+	WriteValue(data, description.depthFormat);
+	WriteValue(data, description.stencilFormat);
+	return true;
+}
+
+// Reads the whole record even when its objects cannot be resolved, so that the following records stay readable.
+static bool ReadGraphicsPipeline(const VulkanBackend::PipelineRecorder& recorder, ManifestReader& reader,
+	VulkanBackend::GraphicsPipelineDescription& description)
+{
+	bool resolved = true;
+
+	uint32_t stageCount = 0;
+	ReadValue(reader, stageCount);
+	if (stageCount > maxGraphicsStages)
+	{
+		reader.failed = true;
+	}
+	for (uint32_t s = 0; s < stageCount && !reader.failed; ++s)
+	{
+		VulkanBackend::PipelineShaderStage stage{};
+		resolved &= ReadShaderStage(recorder, reader, stage);
+		description.shaderStages.push_back(std::move(stage));
+	}
+
+	uint64_t layoutKey = 0, renderPassKey = 0;
+	ReadArray(reader, description.vertexBindings);
+	ReadArray(reader, description.vertexAttributes);
+	ReadValue(reader, description.topology);
+	ReadValue(reader, description.primitiveRestartEnable);
+	ReadValue(reader, description.polygonMode);
+	ReadValue(reader, description.cullMode);
+	ReadValue(reader, description.frontFace);
+	ReadValue(reader, description.rasterizerDiscardEnable);
+	ReadValue(reader, description.depthBiasEnable);
+	ReadValue(reader, description.sampleCount);
+	ReadValue(reader, description.depthTestEnable);
+	ReadValue(reader, description.depthWriteEnable);
+	ReadValue(reader, description.depthCompareOp);
+	ReadValue(reader, description.stencilTestEnable);
+	ReadArray(reader, description.colorBlendAttachments);
+	ReadArray(reader, description.dynamicStates);
+	ReadValue(reader, layoutKey);
+	ReadValue(reader, renderPassKey);
+	ReadValue(reader, description.subpass);
+	ReadArray(reader, description.colorFormats);
+	ReadValue(reader, description.depthFormat);
+	ReadValue(reader, description.stencilFormat);
+
+	uint64_t layout = 0, renderPass = 0;
+	resolved &= GetKeyObject(recorder, layoutKey, layout) && GetKeyObject(recorder, renderPassKey, renderPass);
+	description.layout = (VkPipelineLayout)layout;
+	description.renderPass = (VkRenderPass)renderPass;
+	return resolved && !reader.failed;
+}
+
+static bool WriteComputePipeline(const VulkanBackend::PipelineRecorder& recorder, std::vector<uint8_t>& data,
+	const VulkanBackend::ComputePipelineDescription& description)
+{
+	uint64_t layoutKey;
+	if (!GetObjectKey(recorder, (uint64_t)description.layout, layoutKey))
+	{
+		return false;
+	}
+
+	WriteValue(data, PipelineRecordType::Compute);
+	if (!WriteShaderStage(recorder, data, description.shaderStage))
+	{
+		return false;
+	}
+	WriteValue(data, layoutKey);
+	return true;
+}
+
+static bool ReadComputePipeline(const VulkanBackend::PipelineRecorder& recorder, ManifestReader& reader,
+	VulkanBackend::ComputePipelineDescription& description)
+{
+	bool resolved = ReadShaderStage(recorder, reader, description.shaderStage);
+
+	uint64_t layoutKey = 0, layout = 0;
+	ReadValue(reader, layoutKey);
+	resolved &= GetKeyObject(recorder, layoutKey, layout);
+	description.layout = (VkPipelineLayout)layout;
+	return resolved && !reader.failed;
+}
+
+static bool IsBool(VkBool32 value)
+{
+	return value == VK_FALSE || value == VK_TRUE;
+}
+
+// Core formats and formats of the extension ranges, which the device then has to support with the features.
+static bool IsFormatSupported(const VulkanBackend::BackendData& backendData, VkFormat format, VkFormatFeatureFlags features)
+{
+	if (!(format > VK_FORMAT_UNDEFINED && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) && format < 1000000000)
+	{
+		return false;
+	}
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(backendData.physicalDevice, format, &formatProperties);
+	return (formatProperties.optimalTilingFeatures & features) == features ||
+		(features == VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT && (formatProperties.bufferFeatures & features) == features);
+}
+
+static bool IsShaderStageValid(const VulkanBackend::PipelineShaderStage& stage)
+{
+	if (stage.entryPoint.empty() || stage.entryPoint.find('\0') != std::string::npos)
+	{
+		return false;
+	}
+	for (const auto& entry : stage.specialization.entries)
+	{
+		if (entry.size == 0 || entry.offset > stage.specialization.data.size() ||
+			entry.size > stage.specialization.data.size() - entry.offset)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool IsBlendAttachmentValid(const VkPipelineColorBlendAttachmentState& attachment)
+{
+	auto isFactor = [](VkBlendFactor factor) { return factor >= VK_BLEND_FACTOR_ZERO && factor <= VK_BLEND_FACTOR_ONE_MINUS_SRC1_ALPHA; };
+	auto isOp = [](VkBlendOp op) { return op >= VK_BLEND_OP_ADD && op <= VK_BLEND_OP_MAX; };
+	return IsBool(attachment.blendEnable) &&
+		isFactor(attachment.srcColorBlendFactor) && isFactor(attachment.dstColorBlendFactor) && isOp(attachment.colorBlendOp) &&
+		isFactor(attachment.srcAlphaBlendFactor) && isFactor(attachment.dstAlphaBlendFactor) && isOp(attachment.alphaBlendOp) &&
+		(attachment.colorWriteMask & ~(VkColorComponentFlags)(VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+			VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT)) == 0;
+}
+
+// The values of a replayed record go straight to the driver, anything a corrupted file could have put out of range is checked.
+static bool IsGraphicsPipelineValid(const VulkanBackend::BackendData& backendData, const VulkanBackend::GraphicsPipelineDescription& description)
+{
+	const VkPhysicalDeviceLimits& limits = backendData.deviceProperties.limits;
+
+	VkShaderStageFlags stages = 0;
+	for (const auto& stage : description.shaderStages)
+	{
+		switch (stage.stage)
+		{
+		case VK_SHADER_STAGE_VERTEX_BIT:
+		case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+		case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+		case VK_SHADER_STAGE_GEOMETRY_BIT:
+		case VK_SHADER_STAGE_FRAGMENT_BIT:
+			break;
+		default:
+			return false;
+		}
+		if ((stages & stage.stage) || !IsShaderStageValid(stage))
+		{
+			return false;
+		}
+		stages |= stage.stage;
+	}
+	if (!(stages & VK_SHADER_STAGE_VERTEX_BIT))
+	{
+		return false;
+	}
+
+	if (description.vertexBindings.size() > limits.maxVertexInputBindings ||
+		description.vertexAttributes.size() > limits.maxVertexInputAttributes)
+	{
+		return false;
+	}
+	for (size_t b = 0; b < description.vertexBindings.size(); ++b)
+	{
+		const auto& binding = description.vertexBindings[b];
+		if (binding.binding >= limits.maxVertexInputBindings || binding.stride > limits.maxVertexInputBindingStride ||
+			(binding.inputRate != VK_VERTEX_INPUT_RATE_VERTEX && binding.inputRate != VK_VERTEX_INPUT_RATE_INSTANCE))
+		{
+			return false;
+		}
+		for (size_t o = 0; o < b; ++o)
+		{
+			if (description.vertexBindings[o].binding == binding.binding)
+			{
+				return false;
+			}
+		}
+	}
+	for (const auto& attribute : description.vertexAttributes)
+	{
+		auto bindingIt = std::find_if(description.vertexBindings.begin(), description.vertexBindings.end(),
+			[&attribute](const VkVertexInputBindingDescription& binding) { return binding.binding == attribute.binding; });
+		if (attribute.location >= limits.maxVertexInputAttributes || attribute.offset > limits.maxVertexInputAttributeOffset ||
+			bindingIt == description.vertexBindings.end() ||
+			!IsFormatSupported(backendData, attribute.format, VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT))
+		{
+			return false;
+		}
+	}
+
+	const VkSampleCountFlags sampleCount = description.sampleCount;
+	if (description.topology < VK_PRIMITIVE_TOPOLOGY_POINT_LIST || description.topology > VK_PRIMITIVE_TOPOLOGY_PATCH_LIST ||
+		description.polygonMode < VK_POLYGON_MODE_FILL || description.polygonMode > VK_POLYGON_MODE_POINT ||
+		(description.cullMode & ~(VkCullModeFlags)VK_CULL_MODE_FRONT_AND_BACK) != 0 ||
+		(description.frontFace != VK_FRONT_FACE_COUNTER_CLOCKWISE && description.frontFace != VK_FRONT_FACE_CLOCKWISE) ||
+		description.depthCompareOp < VK_COMPARE_OP_NEVER || description.depthCompareOp > VK_COMPARE_OP_ALWAYS ||
+		sampleCount == 0 || (sampleCount & (sampleCount - 1)) != 0 || !(sampleCount & limits.framebufferColorSampleCounts) ||
+		!IsBool(description.primitiveRestartEnable) || !IsBool(description.rasterizerDiscardEnable) ||
+		!IsBool(description.depthBiasEnable) || !IsBool(description.depthTestEnable) || !IsBool(description.depthWriteEnable) ||
+		!IsBool(description.stencilTestEnable))
+	{
+		return false;
+	}
+
+	if (description.colorBlendAttachments.size() > limits.maxColorAttachments ||
+		description.colorFormats.size() > limits.maxColorAttachments ||
+		!std::all_of(description.colorBlendAttachments.begin(), description.colorBlendAttachments.end(), IsBlendAttachmentValid))
+	{
+		return false;
+	}
+
+	for (size_t d = 0; d < description.dynamicStates.size(); ++d)
+	{
+		const VkDynamicState state = description.dynamicStates[d];
+		if (state < VK_DYNAMIC_STATE_VIEWPORT || !VulkanBackend::IsDynamicStateSupported(backendData, state) ||
+			std::find(description.dynamicStates.begin(), description.dynamicStates.begin() + d, state) != description.dynamicStates.begin() + d)
+		{
+			return false;
+		}
+	}
+
+	for (VkFormat format : description.colorFormats)
+	{
+		if (!IsFormatSupported(backendData, format, VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT))
+		{
+			return false;
+		}
+	}
+	return (description.depthFormat == VK_FORMAT_UNDEFINED ||
+			IsFormatSupported(backendData, description.depthFormat, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)) &&
+		(description.stencilFormat == VK_FORMAT_UNDEFINED ||
+			IsFormatSupported(backendData, description.stencilFormat, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT));
+}
+
+static bool IsComputePipelineValid(const VulkanBackend::ComputePipelineDescription& description)
+{
+	return description.shaderStage.stage == VK_SHADER_STAGE_COMPUTE_BIT && IsShaderStageValid(description.shaderStage);
+}
+
+void VulkanBackend::SetPipelineObjectKey(PipelineRecorder& recorder, uint64_t handle, uint64_t key)
+{
+	std::lock_guard<std::mutex> lock(recorder.mutex);
+	recorder.objectKeys[handle] = key;
+	recorder.keyObjects[key] = handle;
+}
+
+void VulkanBackend::RecordGraphicsPipeline(PipelineRecorder& recorder, const GraphicsPipelineDescription& description)
+{
+	std::lock_guard<std::mutex> lock(recorder.mutex);
+
+	// The record is built separately, so that a missing key does not leave a partial record behind.
+	std::vector<uint8_t> record;
+	if (!WriteGraphicsPipeline(recorder, record, description))
+	{
+		++recorder.skippedPipelines;
+		return;
+	}
+	WriteRecord(recorder.manifest, record);
+	++recorder.recordedPipelines;
+}
+
+void VulkanBackend::RecordComputePipeline(PipelineRecorder& recorder, const ComputePipelineDescription& description)
+{
+	std::lock_guard<std::mutex> lock(recorder.mutex);
+
+	std::vector<uint8_t> record;
+	if (!WriteComputePipeline(recorder, record, description))
+	{
+		++recorder.skippedPipelines;
+		return;
+	}
+	WriteRecord(recorder.manifest, record);
+	++recorder.recordedPipelines;
+}
+
+bool VulkanBackend::SavePipelineManifest(PipelineRecorder& recorder, const std::string& path)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Could not open \"%s\" for writing the pipeline manifest.", path.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(recorder.mutex);
+
+	std::vector<uint8_t> header;
+	WriteValue(header, manifestMagic);
+	WriteValue(header, manifestVersion);
+	file.write((const char*)header.data(), header.size());
+	file.write((const char*)recorder.manifest.data(), recorder.manifest.size());
+	return (bool)file;
+}
+
+bool VulkanBackend::LoadPipelineManifest(const std::string& path, std::vector<uint8_t>& manifest)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		// A missing manifest is expected on the first run.
+		CoreLogInfo(DefaultLogger, "Vulkan backend: No pipeline manifest at \"%s\".", path.c_str());
+		return false;
+	}
+
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	ManifestReader reader{ data.data(), data.size(), 0, false };
+	uint32_t magic = 0, version = 0;
+	ReadValue(reader, magic);
+	ReadValue(reader, version);
+	if (reader.failed || magic != manifestMagic || version != manifestVersion)
+	{
+		CoreLogWarn(DefaultLogger, "Vulkan backend: Pipeline manifest \"%s\" is invalid or outdated.", path.c_str());
+		return false;
+	}
+
+	manifest.assign(data.begin() + reader.offset, data.end());
+	return true;
+}
+
+std::vector<VulkanBackend::AsyncPipelineHandle> VulkanBackend::ReplayPipelineManifest(AsyncPipelineCompiler& compiler,
+	PipelineRecorder& recorder, const std::vector<uint8_t>& manifest)
+{
+	std::vector<GraphicsPipelineDescription> graphicsPipelines;
+	std::vector<ComputePipelineDescription> computePipelines;
+	uint32_t unresolved = 0;
+	uint32_t invalid = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(recorder.mutex);
+
+		ManifestReader reader{ manifest.data(), manifest.size(), 0, false };
+		while (reader.offset < manifest.size())
+		{
+			uint32_t recordSize = 0;
+			uint64_t checksum = 0;
+			ReadValue(reader, recordSize);
+			ReadValue(reader, checksum);
+			if (reader.failed || recordSize > manifest.size() - reader.offset)
+			{
+				reader.failed = true;
+				break;
+			}
+
+			ManifestReader recordReader{ manifest.data() + reader.offset, recordSize, 0, false };
+			reader.offset += recordSize;
+			if (Hashing::Bytes(recordReader.data, recordReader.size) != checksum)
+			{
+				++invalid;
+				continue;
+			}
+
+			// A record is only used when it is read up to its last byte and all of its values are valid.
+			PipelineRecordType type;
+			if (!ReadBytes(recordReader, &type, sizeof(type)))
+			{
+				++invalid;
+			}
+			else if (type == PipelineRecordType::Graphics)
+			{
+				GraphicsPipelineDescription description{};
+				const bool resolved = ReadGraphicsPipeline(recorder, recordReader, description);
+				if (recordReader.failed || recordReader.offset != recordReader.size || !IsGraphicsPipelineValid(*compiler.backendData, description))
+				{
+					++invalid;
+				}
+				else if (!resolved)
+				{
+					++unresolved;
+				}
+				else
+				{
+					graphicsPipelines.push_back(std::move(description));
+				}
+			}
+			else if (type == PipelineRecordType::Compute)
+			{
+				ComputePipelineDescription description{};
+				const bool resolved = ReadComputePipeline(recorder, recordReader, description);
+				if (recordReader.failed || recordReader.offset != recordReader.size || !IsComputePipelineValid(description))
+				{
+					++invalid;
+				}
+				else if (!resolved)
+				{
+					++unresolved;
+				}
+				else
+				{
+					computePipelines.push_back(std::move(description));
+				}
+			}
+			else
+			{
+				++invalid;
+			}
+		}
+
+		if (reader.failed)
+		{
+			CoreLogWarn(DefaultLogger, "Vulkan backend: Pipeline manifest is truncated, replaying the readable part.");
+		}
+	}
+
+	if (invalid > 0)
+	{
+		CoreLogWarn(DefaultLogger, "Vulkan backend: Dropped %u corrupted or invalid records of the pipeline manifest.", invalid);
+	}
+	if (unresolved > 0)
+	{
+		CoreLogWarn(DefaultLogger, "Vulkan backend: %u pipelines of the manifest reference objects without keys.", unresolved);
+	}
+
+	// Requested outside of the recorder lock, the collection records the pipelines again as they are compiled.
+	std::vector<AsyncPipelineHandle> handles;
+	for (const auto& description : graphicsPipelines)
+	{
+		handles.push_back(RequestGraphicsPipeline(compiler, description));
+	}
+	for (const auto& description : computePipelines)
+	{
+		handles.push_back(RequestComputePipeline(compiler, description));
+	}
+	return handles;
+}
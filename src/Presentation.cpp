@@ -1,5 +1,7 @@
 #include "VulkanBackend/VulkanBackendAPI.hpp"
 #include "VulkanBackend/ErrorCheck.hpp"
+#include "Hashing.hpp"
+#include <algorithm>
 
 VkSwapchainKHR VulkanBackend::CreateSwapchain(const BackendData& backendData, const SurfaceData& surfaceData,
 	VkImageUsageFlags imageUsage, VkSharingMode sharingMode)
@@ -52,7 +54,7 @@ void VulkanBackend::GetSwapchainImages(const BackendData& backendData, VkSwapcha
 }
 
 VkFramebuffer VulkanBackend::CreateFramebuffer(const BackendData& backendData, uint32_t width, uint32_t height, VkRenderPass renderPass,
-	const std::vector<VkImageView>& attachments)
+	const std::vector<VkImageView>& attachments, uint32_t layers)
 {
 	VkFramebufferCreateInfo framebufferCreateInfo{};
 	framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -61,7 +63,7 @@ VkFramebuffer VulkanBackend::CreateFramebuffer(const BackendData& backendData, u
 	framebufferCreateInfo.pAttachments = attachments.data();
 	framebufferCreateInfo.width = width;
 	framebufferCreateInfo.height = height;
-	framebufferCreateInfo.layers = 1;
+	framebufferCreateInfo.layers = layers;
 
 	VkFramebuffer framebuffer;
 	VulkanCheck(vkCreateFramebuffer(backendData.logicalDevice, &framebufferCreateInfo, nullptr, &framebuffer));
@@ -73,3 +75,130 @@ void VulkanBackend::DestroyFramebuffer(const BackendData& backendData, VkFramebu
 	vkDestroyFramebuffer(backendData.logicalDevice, framebuffer, nullptr);
 	framebuffer = VK_NULL_HANDLE;
 }
+
+static size_t HashFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView>& attachments, uint32_t width, uint32_t height,
+	uint32_t layers)
+{
+	size_t hash = 0;
+	Hashing::CombineValue(hash, renderPass);
+	for (auto attachment : attachments)
+	{
+		Hashing::CombineValue(hash, attachment);
+	}
+	Hashing::CombineValue(hash, width);
+	Hashing::CombineValue(hash, height);
+	Hashing::CombineValue(hash, layers);
+	return hash;
+}
+
+VkFramebuffer VulkanBackend::AcquireFramebuffer(const BackendData& backendData, FramebufferCache& cache, VkRenderPass renderPass,
+	const std::vector<VkImageView>& attachments, uint32_t width, uint32_t height, uint32_t layers)
+{
+	const size_t hash = HashFramebuffer(renderPass, attachments, width, height, layers);
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto range = cache.entries.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		const auto& entry = it->second;
+		if (entry.renderPass == renderPass && entry.attachments == attachments &&
+			entry.width == width && entry.height == height && entry.layers == layers)
+		{
+			++cache.statistics.hits;
+			return entry.framebuffer;
+		}
+	}
+
+	++cache.statistics.misses;
+
+	FramebufferCacheEntry entry{};
+	entry.renderPass = renderPass;
+	entry.attachments = attachments;
+	entry.width = width;
+	entry.height = height;
+	entry.layers = layers;
+	entry.framebuffer = CreateFramebuffer(backendData, width, height, renderPass, attachments, layers);
+
+	cache.entries.emplace(hash, entry);
+	++cache.statistics.liveObjects;
+
+	return entry.framebuffer;
+}
+
+template<typename Predicate>
+static std::vector<VkFramebuffer> DetachFramebuffersIf(VulkanBackend::FramebufferCache& cache, Predicate predicate)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	std::vector<VkFramebuffer> detached;
+	for (auto it = cache.entries.begin(); it != cache.entries.end();)
+	{
+		if (predicate(it->second))
+		{
+			detached.push_back(it->second.framebuffer);
+			it = cache.entries.erase(it);
+			--cache.statistics.liveObjects;
+		}
+		else
+		{
+			++it;
+		}
+	}
+	return detached;
+}
+
+void VulkanBackend::RegisterFramebufferCache(BackendData& backendData, FramebufferCache* cache)
+{
+	backendData.framebufferCache = cache;
+}
+
+std::vector<VkFramebuffer> VulkanBackend::DetachFramebuffers(FramebufferCache& cache, VkImageView imageView)
+{
+	return DetachFramebuffersIf(cache, [imageView](const FramebufferCacheEntry& entry)
+		{
+			return std::find(entry.attachments.begin(), entry.attachments.end(), imageView) != entry.attachments.end();
+		});
+}
+
+std::vector<VkFramebuffer> VulkanBackend::DetachFramebuffers(FramebufferCache& cache, VkRenderPass renderPass)
+{
+	return DetachFramebuffersIf(cache, [renderPass](const FramebufferCacheEntry& entry)
+		{
+			return entry.renderPass == renderPass;
+		});
+}
+
+void VulkanBackend::EvictFramebuffers(const BackendData& backendData, FramebufferCache& cache, VkImageView imageView)
+{
+	for (auto& framebuffer : DetachFramebuffers(cache, imageView))
+	{
+		DestroyFramebuffer(backendData, framebuffer);
+	}
+}
+
+void VulkanBackend::EvictFramebuffers(const BackendData& backendData, FramebufferCache& cache, VkRenderPass renderPass)
+{
+	for (auto& framebuffer : DetachFramebuffers(cache, renderPass))
+	{
+		DestroyFramebuffer(backendData, framebuffer);
+	}
+}
+
+void VulkanBackend::DestroyFramebufferCache(const BackendData& backendData, FramebufferCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	for (auto& entry : cache.entries)
+	{
+		DestroyFramebuffer(backendData, entry.second.framebuffer);
+	}
+	cache.entries.clear();
+	cache.statistics = {};
+}
+
+VulkanBackend::CacheStatistics VulkanBackend::GetFramebufferCacheStatistics(FramebufferCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	return cache.statistics;
+}
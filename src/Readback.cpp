@@ -0,0 +1,174 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static void DeliverReadbacks(const VulkanBackend::BackendData& backendData, VulkanBackend::ReadbackFrame& frame)
+{
+	// Host-cached memory might not be coherent, the GPU writes have to be made visible first.
+	vmaInvalidateAllocation(backendData.allocator, frame.buffer.allocation, 0, VK_WHOLE_SIZE);
+
+	for (auto& request : frame.requests)
+	{
+		request.callback(frame.data + request.offset, request.size);
+	}
+
+	frame.requests.clear();
+	frame.used = 0;
+	frame.submitted = false;
+}
+
+static bool AllocateReadback(VulkanBackend::ReadbackRing& ring, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+	if (!ring.recording)
+	{
+		return false;
+	}
+
+	auto& frame = ring.frames[ring.currentFrame];
+	offset = AlignUp(frame.used, alignment);
+	if (offset + size > ring.frameCapacity)
+	{
+		CoreLogWarn(DefaultLogger, "Vulkan backend: Readback frame capacity exceeded, the request is dropped.");
+		return false;
+	}
+	frame.used = offset + size;
+	return true;
+}
+
+VulkanBackend::ReadbackRing VulkanBackend::CreateReadbackRing(const BackendData& backendData, uint32_t frameCount, VkDeviceSize frameCapacity)
+{
+	ReadbackRing ring{};
+	ring.frameCapacity = frameCapacity;
+	ring.frames.resize(frameCount);
+
+	for (auto& frame : ring.frames)
+	{
+		// GPU to CPU usage prefers host-cached memory, which is fast to read from on the CPU.
+		frame.buffer = CreateBuffer(backendData, VK_BUFFER_USAGE_TRANSFER_DST_BIT, frameCapacity, VMA_MEMORY_USAGE_GPU_TO_CPU);
+		VulkanCheck(vmaMapMemory(backendData.allocator, frame.buffer.allocation, (void**)&frame.data));
+	}
+
+	return ring;
+}
+
+void VulkanBackend::DestroyReadbackRing(const BackendData& backendData, ReadbackRing& ring)
+{
+	for (auto& frame : ring.frames)
+	{
+		vmaUnmapMemory(backendData.allocator, frame.buffer.allocation);
+		DestroyBuffer(backendData, frame.buffer);
+	}
+	ring.frames.clear();
+	ring.currentFrame = 0;
+	ring.recording = false;
+}
+
+void VulkanBackend::BeginReadbackFrame(const BackendData& backendData, ReadbackRing& ring, uint64_t completedValue)
+{
+	PollReadbacks(backendData, ring, completedValue);
+
+	ring.currentFrame = (ring.currentFrame + 1) % (uint32_t)ring.frames.size();
+
+	// Only happens when the ring is not deeper than the frames in flight, waiting would serialize the frame with the GPU.
+	ring.recording = !ring.frames[ring.currentFrame].submitted;
+	if (!ring.recording)
+	{
+		CoreLogWarn(DefaultLogger, "Vulkan backend: Readback ring is too shallow, the readbacks of this frame are dropped.");
+	}
+}
+
+bool VulkanBackend::RequestBufferReadback(const BackendData& backendData, ReadbackRing& ring, VkCommandBuffer commandBuffer, VkBuffer source,
+	VkDeviceSize offset, VkDeviceSize size, const ReadbackCallback& callback)
+{
+	VkDeviceSize readbackOffset;
+	if (!AllocateReadback(ring, size, 4, readbackOffset))
+	{
+		return false;
+	}
+
+	auto& frame = ring.frames[ring.currentFrame];
+	CopyBufferToBuffer(backendData, source, frame.buffer.buffer, size, commandBuffer, offset, readbackOffset);
+	frame.requests.push_back({ readbackOffset, size, callback });
+
+	return true;
+}
+
+bool VulkanBackend::RequestImageReadback(const BackendData& backendData, ReadbackRing& ring, VkCommandBuffer commandBuffer, VkImage source,
+	VkImageLayout layout, VkImageAspectFlags aspect, uint32_t bytesPerTexel, VkOffset2D offset, VkExtent2D extent,
+	const ReadbackCallback& callback, uint32_t mipLevel, uint32_t arrayLayer)
+{
+	// The rows of the sub-rectangle are tightly packed in the readback buffer.
+	const VkDeviceSize size = (VkDeviceSize)extent.width * extent.height * bytesPerTexel;
+
+	VkDeviceSize readbackOffset;
+	if (!AllocateReadback(ring, size, (VkDeviceSize)bytesPerTexel * 4, readbackOffset))
+	{
+		return false;
+	}
+
+	auto& frame = ring.frames[ring.currentFrame];
+
+	VkBufferImageCopy bufferImageCopy{};
+	bufferImageCopy.bufferOffset = readbackOffset;
+	bufferImageCopy.imageSubresource.aspectMask = aspect;
+	bufferImageCopy.imageSubresource.mipLevel = mipLevel;
+	bufferImageCopy.imageSubresource.baseArrayLayer = arrayLayer;
+	bufferImageCopy.imageSubresource.layerCount = 1;
+	bufferImageCopy.imageOffset = { offset.x, offset.y, 0 };
+	bufferImageCopy.imageExtent = { extent.width, extent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, source, layout, frame.buffer.buffer, 1, &bufferImageCopy);
+
+	frame.requests.push_back({ readbackOffset, size, callback });
+
+	return true;
+}
+
+void VulkanBackend::EndReadbackFrame(ReadbackRing& ring, VkCommandBuffer commandBuffer, uint64_t submitValue)
+{
+	if (!ring.recording)
+	{
+		return;
+	}
+	ring.recording = false;
+
+	// A buffer without copies is not tied to any submission and stays free.
+	auto& frame = ring.frames[ring.currentFrame];
+	if (frame.requests.empty())
+	{
+		return;
+	}
+
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	frame.submitValue = submitValue;
+	frame.submitted = true;
+}
+
+void VulkanBackend::PollReadbacks(const BackendData& backendData, ReadbackRing& ring, uint64_t completedValue)
+{
+	// Starting with the oldest frame, so that the callbacks arrive in submission order.
+	const uint32_t frameCount = (uint32_t)ring.frames.size();
+	for (uint32_t f = 1; f <= frameCount; ++f)
+	{
+		auto& frame = ring.frames[(ring.currentFrame + f) % frameCount];
+		if (!frame.submitted)
+		{
+			continue;
+		}
+		if (frame.submitValue >= completedValue)
+		{
+			break;
+		}
+		DeliverReadbacks(backendData, frame);
+	}
+}
@@ -0,0 +1,331 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+
+static constexpr uint32_t slotBits = 20;
+static constexpr uint32_t slotMask = (1u << slotBits) - 1;
+static constexpr uint32_t generationMask = (1u << (32 - slotBits)) - 1;
+static constexpr uint32_t invalidSlot = UINT32_MAX;
+
+static uint32_t MakeHandle(uint32_t slot, uint16_t generation)
+{
+	return ((uint32_t)generation << slotBits) | slot;
+}
+
+static uint32_t AllocateSlot(VulkanBackend::SlotTable& slots)
+{
+	uint32_t slot;
+	if (!slots.freeSlots.empty())
+	{
+		slot = slots.freeSlots.back();
+		slots.freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (uint32_t)slots.generations.size();
+		if (slot > slotMask)
+		{
+			// The slot bits would overflow into the generation and alias another handle.
+			CoreLogError(DefaultLogger, "Vulkan backend: Resource registry is out of slots.");
+			return invalidSlot;
+		}
+		// Generations start at 1, so that a zero handle is never valid.
+		slots.generations.push_back(1);
+		slots.livePositions.push_back(0);
+	}
+
+	slots.livePositions[slot] = (uint32_t)slots.liveSlots.size();
+	slots.liveSlots.push_back(slot);
+
+	return slot;
+}
+
+static void ReleaseSlot(VulkanBackend::SlotTable& slots, uint32_t slot)
+{
+	// Swapping the last live slot into the released position keeps the live list dense.
+	const uint32_t position = slots.livePositions[slot];
+	const uint32_t lastSlot = slots.liveSlots.back();
+	slots.liveSlots[position] = lastSlot;
+	slots.livePositions[lastSlot] = position;
+	slots.liveSlots.pop_back();
+
+	// Bumping the generation invalidates all the outstanding handles of the slot.
+	uint16_t generation = (slots.generations[slot] + 1) & generationMask;
+	slots.generations[slot] = generation == 0 ? 1 : generation;
+	slots.freeSlots.push_back(slot);
+}
+
+static bool IsSlotHandleValid(const VulkanBackend::SlotTable& slots, uint32_t handleValue)
+{
+	const uint32_t slot = handleValue & slotMask;
+	return handleValue != 0 && slot < slots.generations.size() && slots.generations[slot] == (handleValue >> slotBits);
+}
+
+uint32_t VulkanBackend::GetHandleSlot(uint32_t handleValue)
+{
+	return handleValue & slotMask;
+}
+
+VulkanBackend::BufferHandle VulkanBackend::RegisterBuffer(ResourceRegistry& registry, const Buffer& buffer, VkDeviceSize size,
+	VkBufferUsageFlags usage)
+{
+	BufferTable& table = registry.buffers;
+	const uint32_t slot = AllocateSlot(table.slots);
+	if (slot == invalidSlot)
+	{
+		return {};
+	}
+	if (slot == table.buffers.size())
+	{
+		table.buffers.emplace_back();
+		table.allocations.emplace_back();
+		table.importedMemories.emplace_back();
+		table.deviceAddresses.emplace_back();
+		table.sizes.emplace_back();
+		table.usages.emplace_back();
+		table.states.emplace_back();
+	}
+
+	table.buffers[slot] = buffer.buffer;
+	table.allocations[slot] = buffer.allocation;
+	table.importedMemories[slot] = buffer.importedMemory;
+	table.deviceAddresses[slot] = buffer.deviceAddress;
+	table.sizes[slot] = size;
+	table.usages[slot] = usage;
+	table.states[slot] = {};
+
+	return { MakeHandle(slot, table.slots.generations[slot]) };
+}
+
+VulkanBackend::BufferHandle VulkanBackend::CreateRegisteredBuffer(const BackendData& backendData, ResourceRegistry& registry,
+	VkBufferUsageFlags usage, VkDeviceSize size, VmaMemoryUsage residency)
+{
+	Buffer buffer = CreateBuffer(backendData, usage, size, residency);
+	BufferHandle handle = RegisterBuffer(registry, buffer, size, usage);
+	if (!handle.value)
+	{
+		DestroyBuffer(backendData, buffer);
+	}
+	return handle;
+}
+
+VulkanBackend::Buffer VulkanBackend::UnregisterBuffer(ResourceRegistry& registry, BufferHandle& handle)
+{
+	Buffer buffer;
+	if (!IsHandleValid(registry, handle))
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Unregistering a stale buffer handle.");
+		return buffer;
+	}
+
+	BufferTable& table = registry.buffers;
+	const uint32_t slot = GetHandleSlot(handle.value);
+	buffer.buffer = table.buffers[slot];
+	buffer.allocation = table.allocations[slot];
+	buffer.importedMemory = table.importedMemories[slot];
+	buffer.deviceAddress = table.deviceAddresses[slot];
+
+	table.buffers[slot] = VK_NULL_HANDLE;
+	table.allocations[slot] = VK_NULL_HANDLE;
+	table.importedMemories[slot] = VK_NULL_HANDLE;
+	table.deviceAddresses[slot] = 0;
+	ReleaseSlot(table.slots, slot);
+
+	handle.value = 0;
+	return buffer;
+}
+
+void VulkanBackend::DestroyRegisteredBuffer(const BackendData& backendData, ResourceRegistry& registry, BufferHandle& handle)
+{
+	Buffer buffer = UnregisterBuffer(registry, handle);
+	if (buffer.buffer)
+	{
+		DestroyBuffer(backendData, buffer);
+	}
+}
+
+bool VulkanBackend::IsHandleValid(const ResourceRegistry& registry, BufferHandle handle)
+{
+	return IsSlotHandleValid(registry.buffers.slots, handle.value);
+}
+
+VulkanBackend::Buffer VulkanBackend::GetBuffer(const ResourceRegistry& registry, BufferHandle handle)
+{
+	Buffer buffer;
+	if (IsHandleValid(registry, handle))
+	{
+		const uint32_t slot = GetHandleSlot(handle.value);
+		buffer.buffer = registry.buffers.buffers[slot];
+		buffer.allocation = registry.buffers.allocations[slot];
+		buffer.importedMemory = registry.buffers.importedMemories[slot];
+		buffer.deviceAddress = registry.buffers.deviceAddresses[slot];
+	}
+	return buffer;
+}
+
+VulkanBackend::ResourceState* VulkanBackend::GetBufferState(ResourceRegistry& registry, BufferHandle handle)
+{
+	if (!IsHandleValid(registry, handle))
+	{
+		return nullptr;
+	}
+	return &registry.buffers.states[GetHandleSlot(handle.value)];
+}
+
+VulkanBackend::ImageHandle VulkanBackend::RegisterImage(ResourceRegistry& registry, const Image& image, VkExtent3D extent, VkFormat format,
+	VkImageUsageFlags usage)
+{
+	ImageTable& table = registry.images;
+	const uint32_t slot = AllocateSlot(table.slots);
+	if (slot == invalidSlot)
+	{
+		return {};
+	}
+	if (slot == table.images.size())
+	{
+		table.images.emplace_back();
+		table.allocations.emplace_back();
+		table.extents.emplace_back();
+		table.formats.emplace_back();
+		table.usages.emplace_back();
+		table.states.emplace_back();
+	}
+
+	table.images[slot] = image.image;
+	table.allocations[slot] = image.allocation;
+	table.extents[slot] = extent;
+	table.formats[slot] = format;
+	table.usages[slot] = usage;
+	table.states[slot] = {};
+
+	return { MakeHandle(slot, table.slots.generations[slot]) };
+}
+
+VulkanBackend::ImageHandle VulkanBackend::CreateRegisteredImage2D(const BackendData& backendData, ResourceRegistry& registry, uint32_t width,
+	uint32_t height, uint32_t layerCount, uint32_t mipCount, VkImageUsageFlags usage, VkFormat format, VmaMemoryUsage residency)
+{
+	Image image = CreateImage2D(backendData, width, height, layerCount, mipCount, usage, format, residency);
+	ImageHandle handle = RegisterImage(registry, image, { width, height, 1 }, format, usage);
+	if (!handle.value)
+	{
+		DestroyImage(backendData, image);
+	}
+	return handle;
+}
+
+VulkanBackend::Image VulkanBackend::UnregisterImage(ResourceRegistry& registry, ImageHandle& handle)
+{
+	Image image;
+	if (!IsHandleValid(registry, handle))
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Unregistering a stale image handle.");
+		return image;
+	}
+
+	ImageTable& table = registry.images;
+	const uint32_t slot = GetHandleSlot(handle.value);
+	image.image = table.images[slot];
+	image.allocation = table.allocations[slot];
+
+	table.images[slot] = VK_NULL_HANDLE;
+	table.allocations[slot] = VK_NULL_HANDLE;
+	ReleaseSlot(table.slots, slot);
+
+	handle.value = 0;
+	return image;
+}
+
+void VulkanBackend::DestroyRegisteredImage(const BackendData& backendData, ResourceRegistry& registry, ImageHandle& handle)
+{
+	Image image = UnregisterImage(registry, handle);
+	if (image.image)
+	{
+		DestroyImage(backendData, image);
+	}
+}
+
+bool VulkanBackend::IsHandleValid(const ResourceRegistry& registry, ImageHandle handle)
+{
+	return IsSlotHandleValid(registry.images.slots, handle.value);
+}
+
+VulkanBackend::Image VulkanBackend::GetImage(const ResourceRegistry& registry, ImageHandle handle)
+{
+	Image image;
+	if (IsHandleValid(registry, handle))
+	{
+		const uint32_t slot = GetHandleSlot(handle.value);
+		image.image = registry.images.images[slot];
+		image.allocation = registry.images.allocations[slot];
+	}
+	return image;
+}
+
+VulkanBackend::ResourceState* VulkanBackend::GetImageState(ResourceRegistry& registry, ImageHandle handle)
+{
+	if (!IsHandleValid(registry, handle))
+	{
+		return nullptr;
+	}
+	return &registry.images.states[GetHandleSlot(handle.value)];
+}
+
+void VulkanBackend::ForEachBuffer(const ResourceRegistry& registry, const std::function<void(BufferHandle handle, uint32_t slot)>& function)
+{
+	const SlotTable& slots = registry.buffers.slots;
+	for (uint32_t slot : slots.liveSlots)
+	{
+		function({ MakeHandle(slot, slots.generations[slot]) }, slot);
+	}
+}
+
+void VulkanBackend::ForEachImage(const ResourceRegistry& registry, const std::function<void(ImageHandle handle, uint32_t slot)>& function)
+{
+	const SlotTable& slots = registry.images.slots;
+	for (uint32_t slot : slots.liveSlots)
+	{
+		function({ MakeHandle(slot, slots.generations[slot]) }, slot);
+	}
+}
+
+VulkanBackend::RegistryStatistics VulkanBackend::GetRegistryStatistics(const BackendData& backendData, const ResourceRegistry& registry)
+{
+	RegistryStatistics statistics{};
+	statistics.liveBuffers = (uint32_t)registry.buffers.slots.liveSlots.size();
+	statistics.liveImages = (uint32_t)registry.images.slots.liveSlots.size();
+
+	for (uint32_t slot : registry.buffers.slots.liveSlots)
+	{
+		statistics.bufferBytes += registry.buffers.sizes[slot];
+	}
+
+	// Image sizes depend on the driver layout, so they are taken from the allocations.
+	for (uint32_t slot : registry.images.slots.liveSlots)
+	{
+		if (registry.images.allocations[slot])
+		{
+			VmaAllocationInfo allocationInfo;
+			vmaGetAllocationInfo(backendData.allocator, registry.images.allocations[slot], &allocationInfo);
+			statistics.imageBytes += allocationInfo.size;
+		}
+	}
+
+	return statistics;
+}
+
+void VulkanBackend::ClearRegistry(const BackendData& backendData, ResourceRegistry& registry)
+{
+	while (!registry.buffers.slots.liveSlots.empty())
+	{
+		const uint32_t slot = registry.buffers.slots.liveSlots.back();
+		BufferHandle handle{ MakeHandle(slot, registry.buffers.slots.generations[slot]) };
+		DestroyRegisteredBuffer(backendData, registry, handle);
+	}
+
+	while (!registry.images.slots.liveSlots.empty())
+	{
+		const uint32_t slot = registry.images.slots.liveSlots.back();
+		ImageHandle handle{ MakeHandle(slot, registry.images.slots.generations[slot]) };
+		DestroyRegisteredImage(backendData, registry, handle);
+	}
+}
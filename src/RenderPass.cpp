@@ -0,0 +1,276 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include "Hashing.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+
+static bool IsDepthStencilFormat(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+	case VK_FORMAT_S8_UINT:
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static VkAttachmentReference GetAttachmentReference(const VulkanBackend::RenderPassDescription& description, uint32_t attachment,
+	VkImageLayout colorLayout, VkImageLayout depthStencilLayout)
+{
+	if (attachment == VK_ATTACHMENT_UNUSED)
+	{
+		return { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+	}
+	if (attachment >= description.attachments.size())
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Subpass references a missing attachment (%u).", attachment);
+		return { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+	}
+	return { attachment, IsDepthStencilFormat(description.attachments[attachment].format) ? depthStencilLayout : colorLayout };
+}
+
+static size_t HashRenderPassDescription(const VulkanBackend::RenderPassDescription& description)
+{
+	uint64_t hash = Hashing::Bytes(nullptr, 0);
+	Hashing::HashArray(hash, description.attachments);
+	for (const auto& subpass : description.subpasses)
+	{
+		Hashing::HashArray(hash, subpass.colorAttachments);
+		Hashing::HashArray(hash, subpass.resolveAttachments);
+		Hashing::HashArray(hash, subpass.inputAttachments);
+		Hashing::HashArray(hash, subpass.preserveAttachments);
+		hash = Hashing::Bytes(&subpass.depthStencilAttachment, sizeof(VkAttachmentReference), hash);
+	}
+	Hashing::HashArray(hash, description.dependencies);
+	return (size_t)hash;
+}
+
+static bool RenderPassDescriptionsEqual(const VulkanBackend::RenderPassDescription& a, const VulkanBackend::RenderPassDescription& b)
+{
+	if (!Hashing::ArraysEqual(a.attachments, b.attachments) || !Hashing::ArraysEqual(a.dependencies, b.dependencies) ||
+		a.subpasses.size() != b.subpasses.size())
+	{
+		return false;
+	}
+	for (size_t s = 0; s < a.subpasses.size(); ++s)
+	{
+		const auto& subpassA = a.subpasses[s];
+		const auto& subpassB = b.subpasses[s];
+		if (!Hashing::ArraysEqual(subpassA.colorAttachments, subpassB.colorAttachments) ||
+			!Hashing::ArraysEqual(subpassA.resolveAttachments, subpassB.resolveAttachments) ||
+			!Hashing::ArraysEqual(subpassA.inputAttachments, subpassB.inputAttachments) ||
+			!Hashing::ArraysEqual(subpassA.preserveAttachments, subpassB.preserveAttachments) ||
+			subpassA.depthStencilAttachment.attachment != subpassB.depthStencilAttachment.attachment ||
+			subpassA.depthStencilAttachment.layout != subpassB.depthStencilAttachment.layout)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32_t VulkanBackend::AddColorAttachment(RenderPassDescription& description, VkFormat format, VkSampleCountFlagBits samples,
+	VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkImageLayout initialLayout, VkImageLayout finalLayout)
+{
+	VkAttachmentDescription attachment{};
+	attachment.format = format;
+	attachment.samples = samples;
+	attachment.loadOp = loadOp;
+	attachment.storeOp = storeOp;
+	attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachment.initialLayout = initialLayout;
+	attachment.finalLayout = finalLayout;
+
+	description.attachments.push_back(attachment);
+	return (uint32_t)description.attachments.size() - 1;
+}
+
+uint32_t VulkanBackend::AddDepthStencilAttachment(RenderPassDescription& description, VkFormat format, VkSampleCountFlagBits samples,
+	VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkAttachmentLoadOp stencilLoadOp, VkAttachmentStoreOp stencilStoreOp,
+	VkImageLayout initialLayout, VkImageLayout finalLayout)
+{
+	VkAttachmentDescription attachment{};
+	attachment.format = format;
+	attachment.samples = samples;
+	attachment.loadOp = loadOp;
+	attachment.storeOp = storeOp;
+	attachment.stencilLoadOp = stencilLoadOp;
+	attachment.stencilStoreOp = stencilStoreOp;
+	attachment.initialLayout = initialLayout;
+	attachment.finalLayout = finalLayout;
+
+	description.attachments.push_back(attachment);
+	return (uint32_t)description.attachments.size() - 1;
+}
+
+uint32_t VulkanBackend::AddSubpass(RenderPassDescription& description, const std::vector<uint32_t>& colorAttachments,
+	uint32_t depthStencilAttachment, const std::vector<uint32_t>& inputAttachments, const std::vector<uint32_t>& resolveAttachments,
+	const std::vector<uint32_t>& preserveAttachments)
+{
+	SubpassDescription subpass{};
+	for (uint32_t attachment : colorAttachments)
+	{
+		subpass.colorAttachments.push_back(GetAttachmentReference(description, attachment,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+	}
+
+	if (!resolveAttachments.empty())
+	{
+		if (resolveAttachments.size() != colorAttachments.size())
+		{
+			CoreLogError(DefaultLogger, "Vulkan backend: Subpass resolve attachments do not match its color attachments.");
+		}
+		for (size_t r = 0; r < colorAttachments.size(); ++r)
+		{
+			const uint32_t attachment = r < resolveAttachments.size() ? resolveAttachments[r] : VK_ATTACHMENT_UNUSED;
+			subpass.resolveAttachments.push_back(GetAttachmentReference(description, attachment,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+		}
+	}
+
+	// Input attachments are read in the fragment shader, depth ones stay in a depth read-only layout.
+	for (uint32_t attachment : inputAttachments)
+	{
+		subpass.inputAttachments.push_back(GetAttachmentReference(description, attachment,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL));
+	}
+
+	// All references to one attachment within a subpass need the same layout. A depth attachment that is also read as an input
+	// is therefore read-only for the depth test too (depth writes must be disabled), and a color one used both ways is general.
+	const bool depthIsInput = depthStencilAttachment != VK_ATTACHMENT_UNUSED &&
+		std::find(inputAttachments.begin(), inputAttachments.end(), depthStencilAttachment) != inputAttachments.end();
+	subpass.depthStencilAttachment = GetAttachmentReference(description, depthStencilAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		depthIsInput ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	for (auto& inputReference : subpass.inputAttachments)
+	{
+		for (auto& colorReference : subpass.colorAttachments)
+		{
+			if (inputReference.attachment != VK_ATTACHMENT_UNUSED && inputReference.attachment == colorReference.attachment)
+			{
+				inputReference.layout = VK_IMAGE_LAYOUT_GENERAL;
+				colorReference.layout = VK_IMAGE_LAYOUT_GENERAL;
+			}
+		}
+	}
+	subpass.preserveAttachments = preserveAttachments;
+
+	description.subpasses.push_back(std::move(subpass));
+	return (uint32_t)description.subpasses.size() - 1;
+}
+
+void VulkanBackend::AddSubpassDependency(RenderPassDescription& description, uint32_t sourceSubpass, uint32_t destinationSubpass,
+	VkPipelineStageFlags sourceStage, VkPipelineStageFlags destinationStage, VkAccessFlags sourceAccessMask,
+	VkAccessFlags destinationAccessMask, VkDependencyFlags flags)
+{
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = sourceSubpass;
+	dependency.dstSubpass = destinationSubpass;
+	dependency.srcStageMask = sourceStage;
+	dependency.dstStageMask = destinationStage;
+	dependency.srcAccessMask = sourceAccessMask;
+	dependency.dstAccessMask = destinationAccessMask;
+	dependency.dependencyFlags = flags;
+
+	description.dependencies.push_back(dependency);
+}
+
+VkRenderPass VulkanBackend::CreateRenderPass(const BackendData& backendData, const RenderPassDescription& description)
+{
+	std::vector<VkSubpassDescription> subpasses(description.subpasses.size());
+	for (size_t s = 0; s < subpasses.size(); ++s)
+	{
+		const auto& subpass = description.subpasses[s];
+		if (subpass.colorAttachments.size() > backendData.deviceProperties.limits.maxColorAttachments)
+		{
+			CoreLogError(DefaultLogger, "Vulkan backend: Subpass exceeds the device color attachment limit (%u).",
+				backendData.deviceProperties.limits.maxColorAttachments);
+			return VK_NULL_HANDLE;
+		}
+
+		subpasses[s] = {};
+		subpasses[s].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpasses[s].colorAttachmentCount = (uint32_t)subpass.colorAttachments.size();
+		subpasses[s].pColorAttachments = subpass.colorAttachments.data();
+		subpasses[s].pResolveAttachments = subpass.resolveAttachments.empty() ? nullptr : subpass.resolveAttachments.data();
+		subpasses[s].inputAttachmentCount = (uint32_t)subpass.inputAttachments.size();
+		subpasses[s].pInputAttachments = subpass.inputAttachments.data();
+		subpasses[s].preserveAttachmentCount = (uint32_t)subpass.preserveAttachments.size();
+		subpasses[s].pPreserveAttachments = subpass.preserveAttachments.data();
+		if (subpass.depthStencilAttachment.attachment != VK_ATTACHMENT_UNUSED)
+		{
+			subpasses[s].pDepthStencilAttachment = &subpass.depthStencilAttachment;
+		}
+	}
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = (uint32_t)description.attachments.size();
+	renderPassInfo.pAttachments = description.attachments.data();
+	renderPassInfo.subpassCount = (uint32_t)subpasses.size();
+	renderPassInfo.pSubpasses = subpasses.data();
+	renderPassInfo.dependencyCount = (uint32_t)description.dependencies.size();
+	renderPassInfo.pDependencies = description.dependencies.data();
+
+	VkRenderPass renderPass;
+	VulkanCheck(vkCreateRenderPass(backendData.logicalDevice, &renderPassInfo, nullptr, &renderPass));
+	return renderPass;
+}
+
+VkRenderPass VulkanBackend::AcquireRenderPass(const BackendData& backendData, RenderPassCache& cache, const RenderPassDescription& description)
+{
+	const size_t hash = HashRenderPassDescription(description);
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto range = cache.entries.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (RenderPassDescriptionsEqual(it->second.description, description))
+		{
+			++cache.statistics.hits;
+			return it->second.renderPass;
+		}
+	}
+
+	++cache.statistics.misses;
+
+	RenderPassCacheEntry entry{};
+	entry.description = description;
+	entry.renderPass = CreateRenderPass(backendData, description);
+
+	VkRenderPass renderPass = entry.renderPass;
+	if (!renderPass)
+	{
+		return VK_NULL_HANDLE;
+	}
+	cache.entries.emplace(hash, std::move(entry));
+	++cache.statistics.liveObjects;
+
+	return renderPass;
+}
+
+void VulkanBackend::DestroyRenderPassCache(const BackendData& backendData, RenderPassCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	for (auto& entry : cache.entries)
+	{
+		DestroyRenderPass(backendData, entry.second.renderPass);
+	}
+	cache.entries.clear();
+	cache.statistics = {};
+}
+
+VulkanBackend::CacheStatistics VulkanBackend::GetRenderPassCacheStatistics(RenderPassCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	return cache.statistics;
+}
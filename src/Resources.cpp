@@ -1,5 +1,6 @@
 #include "VulkanBackend/VulkanBackendAPI.hpp"
 #include "VulkanBackend/ErrorCheck.hpp"
+#include "Hashing.hpp"
 #include <SoftwareCore/DefaultLogger.hpp>
 
 VulkanBackend::Image VulkanBackend::CreateImage2D(const BackendData& backendData, uint32_t width, uint32_t height, uint32_t layerCount, uint32_t mipCount,
@@ -50,7 +51,7 @@ void VulkanBackend::TransitionImageLayout(VkCommandBuffer commandBuffer,
 	barrier.dstQueueFamilyIndex = destinationQueueFamilyIndex;
 
 	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.aspectMask = aspect;
 	barrier.subresourceRange.baseMipLevel = 0;
 	barrier.subresourceRange.levelCount = mipLevels;
 	barrier.subresourceRange.baseArrayLayer = 0;
@@ -194,7 +195,7 @@ void VulkanBackend::AcquireImageOwnership(const BackendData& backendData, VkComm
 	vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 0, nullptr);
 }
 
-VkImageView VulkanBackend::CreateImageView2D(const BackendData& backendData, VkImage image, VkFormat format, VkImageSubresourceRange& subresource)
+static VkImageViewCreateInfo GetImageView2DCreateInfo(VkImage image, VkFormat format, const VkImageSubresourceRange& subresource)
 {
 	VkImageViewCreateInfo imageViewCreateInfo{};
 	imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -202,7 +203,16 @@ VkImageView VulkanBackend::CreateImageView2D(const BackendData& backendData, VkI
 	imageViewCreateInfo.image = image;
 	imageViewCreateInfo.format = format;
 	imageViewCreateInfo.subresourceRange = subresource;
+	return imageViewCreateInfo;
+}
+
+VkImageView VulkanBackend::CreateImageView2D(const BackendData& backendData, VkImage image, VkFormat format, VkImageSubresourceRange& subresource)
+{
+	return CreateImageView(backendData, GetImageView2DCreateInfo(image, format, subresource));
+}
 
+VkImageView VulkanBackend::CreateImageView(const BackendData& backendData, const VkImageViewCreateInfo& imageViewCreateInfo)
+{
 	VkImageView imageView;
 	VulkanCheck(vkCreateImageView(backendData.logicalDevice, &imageViewCreateInfo, nullptr, &imageView));
 
@@ -211,11 +221,19 @@ VkImageView VulkanBackend::CreateImageView2D(const BackendData& backendData, VkI
 
 void VulkanBackend::DestroyImageView(const BackendData& backendData, VkImageView& imageView)
 {
+	if (backendData.framebufferCache)
+	{
+		EvictFramebuffers(backendData, *backendData.framebufferCache, imageView);
+	}
+	if (backendData.descriptorSetCache)
+	{
+		InvalidateDescriptorSets(*backendData.descriptorSetCache, imageView);
+	}
 	vkDestroyImageView(backendData.logicalDevice, imageView, nullptr);
 	imageView = VK_NULL_HANDLE;
 }
 
-VkSampler VulkanBackend::CreateImageSampler(const BackendData& backendData, VkFilter magnificationFilter,
+static VkSamplerCreateInfo GetImageSamplerCreateInfo(VkFilter magnificationFilter,
 	VkFilter minificationFilter, VkBorderColor borderColor,
 	VkSamplerAddressMode uAddressMode, VkSamplerAddressMode vAddressMode, VkSamplerAddressMode wAddressMode,
 	float minLod, float maxLod, float mipLodBias, VkSamplerMipmapMode mipmapMode, float maxAnisotropy)
@@ -233,7 +251,20 @@ VkSampler VulkanBackend::CreateImageSampler(const BackendData& backendData, VkFi
 	samplerCreateInfo.minLod = minLod;
 	samplerCreateInfo.maxLod = maxLod;
 	samplerCreateInfo.mipLodBias = mipLodBias;
+	return samplerCreateInfo;
+}
+
+VkSampler VulkanBackend::CreateImageSampler(const BackendData& backendData, VkFilter magnificationFilter,
+	VkFilter minificationFilter, VkBorderColor borderColor,
+	VkSamplerAddressMode uAddressMode, VkSamplerAddressMode vAddressMode, VkSamplerAddressMode wAddressMode,
+	float minLod, float maxLod, float mipLodBias, VkSamplerMipmapMode mipmapMode, float maxAnisotropy)
+{
+	return CreateImageSampler(backendData, GetImageSamplerCreateInfo(magnificationFilter, minificationFilter, borderColor,
+		uAddressMode, vAddressMode, wAddressMode, minLod, maxLod, mipLodBias, mipmapMode, maxAnisotropy));
+}
 
+VkSampler VulkanBackend::CreateImageSampler(const BackendData& backendData, const VkSamplerCreateInfo& samplerCreateInfo)
+{
 	VkSampler sampler;
 	VulkanCheck(vkCreateSampler(backendData.logicalDevice, &samplerCreateInfo, nullptr, &sampler));
 
@@ -242,6 +273,10 @@ VkSampler VulkanBackend::CreateImageSampler(const BackendData& backendData, VkFi
 
 void VulkanBackend::DestroyImageSampler(const BackendData& backendData, VkSampler& sampler)
 {
+	if (backendData.descriptorSetCache)
+	{
+		InvalidateDescriptorSets(*backendData.descriptorSetCache, sampler);
+	}
 	vkDestroySampler(backendData.logicalDevice, sampler, nullptr);
 	sampler = VK_NULL_HANDLE;
 }
@@ -261,14 +296,41 @@ VulkanBackend::Buffer VulkanBackend::CreateBuffer(const BackendData& backendData
 	Buffer buffer;
 	VulkanCheck(vmaCreateBuffer(backendData.allocator, &bufferCreateInfo, &allocationInfo, &buffer.buffer, &buffer.allocation, nullptr));
 
+	if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+	{
+		buffer.deviceAddress = GetBufferDeviceAddress(backendData, buffer.buffer);
+	}
+
 	return buffer;
 }
 
 void VulkanBackend::DestroyBuffer(const BackendData& backendData, VulkanBackend::Buffer& buffer)
 {
-	vmaDestroyBuffer(backendData.allocator, buffer.buffer, buffer.allocation);
+	if (backendData.descriptorSetCache)
+	{
+		InvalidateDescriptorSets(*backendData.descriptorSetCache, buffer.buffer);
+	}
+	if (buffer.importedMemory)
+	{
+		vkDestroyBuffer(backendData.logicalDevice, buffer.buffer, nullptr);
+		vkFreeMemory(backendData.logicalDevice, buffer.importedMemory, nullptr);
+		buffer.importedMemory = VK_NULL_HANDLE;
+	}
+	else
+	{
+		vmaDestroyBuffer(backendData.allocator, buffer.buffer, buffer.allocation);
+	}
 	buffer.buffer = VK_NULL_HANDLE;
 	buffer.allocation = VK_NULL_HANDLE;
+	buffer.deviceAddress = 0;
+}
+
+VkDeviceAddress VulkanBackend::GetBufferDeviceAddress(const BackendData& backendData, VkBuffer buffer)
+{
+	VkBufferDeviceAddressInfo bufferDeviceAddressInfo{};
+	bufferDeviceAddressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+	bufferDeviceAddressInfo.buffer = buffer;
+	return vkGetBufferDeviceAddress(backendData.logicalDevice, &bufferDeviceAddressInfo);
 }
 
 void VulkanBackend::ReleaseBufferOwnership(const BackendData& backendData, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize size, VkDeviceSize offset,
@@ -325,6 +387,12 @@ void VulkanBackend::CopyBufferToImage(const BackendData& backendData, VkBuffer s
 	vkCmdCopyBufferToImage(commandBuffer, source, destination, layout, 1, &bufferImageCopy);
 }
 
+void VulkanBackend::CopyBufferToImage(const BackendData& backendData, VkBuffer source, VkImage destination, VkImageLayout layout,
+	VkCommandBuffer commandBuffer, const std::vector<VkBufferImageCopy>& regions)
+{
+	vkCmdCopyBufferToImage(commandBuffer, source, destination, layout, (uint32_t)regions.size(), regions.data());
+}
+
 void VulkanBackend::CopyImageToBuffer(const BackendData& backendData, VkImage source, VkBuffer destination, VkImageLayout layout,
 	VkCommandBuffer commandBuffer, uint32_t width, uint32_t height, VkImageAspectFlags aspect, int32_t xOffset, int32_t yOffset)
 {
@@ -337,3 +405,271 @@ void VulkanBackend::CopyImageToBuffer(const BackendData& backendData, VkImage so
 	bufferImageCopy.imageOffset = { xOffset, yOffset, 0 };
 	vkCmdCopyImageToBuffer(commandBuffer, source, layout, destination, 1, &bufferImageCopy);
 }
+
+static size_t HashSamplerCreateInfo(const VkSamplerCreateInfo& createInfo)
+{
+	size_t hash = 0;
+	Hashing::CombineValue(hash, createInfo.flags);
+	Hashing::CombineValue(hash, createInfo.magFilter);
+	Hashing::CombineValue(hash, createInfo.minFilter);
+	Hashing::CombineValue(hash, createInfo.mipmapMode);
+	Hashing::CombineValue(hash, createInfo.addressModeU);
+	Hashing::CombineValue(hash, createInfo.addressModeV);
+	Hashing::CombineValue(hash, createInfo.addressModeW);
+	Hashing::CombineValue(hash, createInfo.mipLodBias);
+	Hashing::CombineValue(hash, createInfo.anisotropyEnable);
+	Hashing::CombineValue(hash, createInfo.maxAnisotropy);
+	Hashing::CombineValue(hash, createInfo.compareEnable);
+	Hashing::CombineValue(hash, createInfo.compareOp);
+	Hashing::CombineValue(hash, createInfo.minLod);
+	Hashing::CombineValue(hash, createInfo.maxLod);
+	Hashing::CombineValue(hash, createInfo.borderColor);
+	Hashing::CombineValue(hash, createInfo.unnormalizedCoordinates);
+	return hash;
+}
+
+static bool SamplerCreateInfosEqual(const VkSamplerCreateInfo& a, const VkSamplerCreateInfo& b)
+{
+	return a.flags == b.flags && a.magFilter == b.magFilter && a.minFilter == b.minFilter && a.mipmapMode == b.mipmapMode &&
+		a.addressModeU == b.addressModeU && a.addressModeV == b.addressModeV && a.addressModeW == b.addressModeW &&
+		a.mipLodBias == b.mipLodBias && a.anisotropyEnable == b.anisotropyEnable && a.maxAnisotropy == b.maxAnisotropy &&
+		a.compareEnable == b.compareEnable && a.compareOp == b.compareOp && a.minLod == b.minLod && a.maxLod == b.maxLod &&
+		a.borderColor == b.borderColor && a.unnormalizedCoordinates == b.unnormalizedCoordinates;
+}
+
+static size_t HashImageViewCreateInfo(const VkImageViewCreateInfo& createInfo)
+{
+	size_t hash = 0;
+	Hashing::CombineValue(hash, createInfo.flags);
+	Hashing::CombineValue(hash, createInfo.image);
+	Hashing::CombineValue(hash, createInfo.viewType);
+	Hashing::CombineValue(hash, createInfo.format);
+	Hashing::CombineValue(hash, createInfo.components.r);
+	Hashing::CombineValue(hash, createInfo.components.g);
+	Hashing::CombineValue(hash, createInfo.components.b);
+	Hashing::CombineValue(hash, createInfo.components.a);
+	Hashing::CombineValue(hash, createInfo.subresourceRange.aspectMask);
+	Hashing::CombineValue(hash, createInfo.subresourceRange.baseMipLevel);
+	Hashing::CombineValue(hash, createInfo.subresourceRange.levelCount);
+	Hashing::CombineValue(hash, createInfo.subresourceRange.baseArrayLayer);
+	Hashing::CombineValue(hash, createInfo.subresourceRange.layerCount);
+	return hash;
+}
+
+static bool ImageViewCreateInfosEqual(const VkImageViewCreateInfo& a, const VkImageViewCreateInfo& b)
+{
+	return a.flags == b.flags && a.image == b.image && a.viewType == b.viewType && a.format == b.format &&
+		a.components.r == b.components.r && a.components.g == b.components.g &&
+		a.components.b == b.components.b && a.components.a == b.components.a &&
+		a.subresourceRange.aspectMask == b.subresourceRange.aspectMask &&
+		a.subresourceRange.baseMipLevel == b.subresourceRange.baseMipLevel &&
+		a.subresourceRange.levelCount == b.subresourceRange.levelCount &&
+		a.subresourceRange.baseArrayLayer == b.subresourceRange.baseArrayLayer &&
+		a.subresourceRange.layerCount == b.subresourceRange.layerCount;
+}
+
+VkSampler VulkanBackend::AcquireImageSampler(const BackendData& backendData, SamplerCache& cache, VkFilter magnificationFilter,
+	VkFilter minificationFilter, VkBorderColor borderColor,
+	VkSamplerAddressMode uAddressMode, VkSamplerAddressMode vAddressMode, VkSamplerAddressMode wAddressMode,
+	float minLod, float maxLod, float mipLodBias, VkSamplerMipmapMode mipmapMode, float maxAnisotropy)
+{
+	return AcquireImageSampler(backendData, cache, GetImageSamplerCreateInfo(magnificationFilter, minificationFilter, borderColor,
+		uAddressMode, vAddressMode, wAddressMode, minLod, maxLod, mipLodBias, mipmapMode, maxAnisotropy));
+}
+
+VkSampler VulkanBackend::AcquireImageSampler(const BackendData& backendData, SamplerCache& cache, const VkSamplerCreateInfo& samplerCreateInfo)
+{
+	if (samplerCreateInfo.pNext)
+	{
+		return CreateImageSampler(backendData, samplerCreateInfo);
+	}
+
+	const size_t hash = HashSamplerCreateInfo(samplerCreateInfo);
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto range = cache.entries.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (SamplerCreateInfosEqual(it->second.createInfo, samplerCreateInfo))
+		{
+			++it->second.referenceCount;
+			++cache.statistics.hits;
+			return it->second.sampler;
+		}
+	}
+
+	++cache.statistics.misses;
+
+	if (cache.statistics.liveObjects >= backendData.deviceProperties.limits.maxSamplerAllocationCount)
+	{
+		CoreLogWarn(DefaultLogger, "Vulkan backend: Sampler cache exceeds the device sampler allocation limit (%u).",
+			backendData.deviceProperties.limits.maxSamplerAllocationCount);
+	}
+
+	SamplerCacheEntry entry{};
+	entry.createInfo = samplerCreateInfo;
+	entry.sampler = CreateImageSampler(backendData, samplerCreateInfo);
+	entry.referenceCount = 1;
+
+	cache.entries.emplace(hash, entry);
+	cache.hashes[entry.sampler] = hash;
+	++cache.statistics.liveObjects;
+
+	return entry.sampler;
+}
+
+void VulkanBackend::ReleaseImageSampler(const BackendData& backendData, SamplerCache& cache, VkSampler& sampler)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto hashIt = cache.hashes.find(sampler);
+	if (hashIt == cache.hashes.end())
+	{
+		// Samplers bypassing the cache are owned by the caller only.
+		DestroyImageSampler(backendData, sampler);
+		return;
+	}
+
+	auto range = cache.entries.equal_range(hashIt->second);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.sampler == sampler && --it->second.referenceCount == 0)
+		{
+			DestroyImageSampler(backendData, it->second.sampler);
+			cache.entries.erase(it);
+			cache.hashes.erase(hashIt);
+			--cache.statistics.liveObjects;
+			break;
+		}
+	}
+
+	sampler = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::DestroySamplerCache(const BackendData& backendData, SamplerCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	for (auto& entry : cache.entries)
+	{
+		DestroyImageSampler(backendData, entry.second.sampler);
+	}
+	cache.entries.clear();
+	cache.hashes.clear();
+	cache.statistics = {};
+}
+
+VulkanBackend::CacheStatistics VulkanBackend::GetSamplerCacheStatistics(SamplerCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	return cache.statistics;
+}
+
+VkImageView VulkanBackend::AcquireImageView2D(const BackendData& backendData, ImageViewCache& cache, VkImage image, VkFormat format,
+	const VkImageSubresourceRange& subresource)
+{
+	return AcquireImageView(backendData, cache, GetImageView2DCreateInfo(image, format, subresource));
+}
+
+VkImageView VulkanBackend::AcquireImageView(const BackendData& backendData, ImageViewCache& cache, const VkImageViewCreateInfo& imageViewCreateInfo)
+{
+	if (imageViewCreateInfo.pNext)
+	{
+		return CreateImageView(backendData, imageViewCreateInfo);
+	}
+
+	const size_t hash = HashImageViewCreateInfo(imageViewCreateInfo);
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto range = cache.entries.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (ImageViewCreateInfosEqual(it->second.createInfo, imageViewCreateInfo))
+		{
+			++it->second.referenceCount;
+			++cache.statistics.hits;
+			return it->second.imageView;
+		}
+	}
+
+	++cache.statistics.misses;
+
+	ImageViewCacheEntry entry{};
+	entry.createInfo = imageViewCreateInfo;
+	entry.imageView = CreateImageView(backendData, imageViewCreateInfo);
+	entry.referenceCount = 1;
+
+	cache.entries.emplace(hash, entry);
+	cache.hashes[entry.imageView] = hash;
+	++cache.statistics.liveObjects;
+
+	return entry.imageView;
+}
+
+void VulkanBackend::ReleaseImageView(const BackendData& backendData, ImageViewCache& cache, VkImageView& imageView)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto hashIt = cache.hashes.find(imageView);
+	if (hashIt == cache.hashes.end())
+	{
+		DestroyImageView(backendData, imageView);
+		return;
+	}
+
+	auto range = cache.entries.equal_range(hashIt->second);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.imageView == imageView && --it->second.referenceCount == 0)
+		{
+			DestroyImageView(backendData, it->second.imageView);
+			cache.entries.erase(it);
+			cache.hashes.erase(hashIt);
+			--cache.statistics.liveObjects;
+			break;
+		}
+	}
+
+	imageView = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::EvictImageViews(const BackendData& backendData, ImageViewCache& cache, VkImage image)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	for (auto it = cache.entries.begin(); it != cache.entries.end();)
+	{
+		if (it->second.createInfo.image == image)
+		{
+			cache.hashes.erase(it->second.imageView);
+			DestroyImageView(backendData, it->second.imageView);
+			it = cache.entries.erase(it);
+			--cache.statistics.liveObjects;
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void VulkanBackend::DestroyImageViewCache(const BackendData& backendData, ImageViewCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+
+	for (auto& entry : cache.entries)
+	{
+		DestroyImageView(backendData, entry.second.imageView);
+	}
+	cache.entries.clear();
+	cache.hashes.clear();
+	cache.statistics = {};
+}
+
+VulkanBackend::CacheStatistics VulkanBackend::GetImageViewCacheStatistics(ImageViewCache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	return cache.statistics;
+}
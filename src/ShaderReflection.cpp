@@ -0,0 +1,800 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// The subset of the SPIR-V specification needed to reflect the interface of a module.
+namespace Spirv
+{
+	static constexpr uint32_t magic = 0x07230203;
+	static constexpr uint32_t headerWords = 5;
+	// Universal limits of the specification, larger values only come from corrupted modules.
+	static constexpr uint32_t maxIdBound = 4194303;
+	static constexpr uint32_t maxStructMembers = 16383;
+
+	enum Op : uint32_t
+	{
+		OpEntryPoint = 15,
+		OpExecutionMode = 16,
+		OpTypeBool = 20,
+		OpTypeInt = 21,
+		OpTypeFloat = 22,
+		OpTypeVector = 23,
+		OpTypeMatrix = 24,
+		OpTypeImage = 25,
+		OpTypeSampler = 26,
+		OpTypeSampledImage = 27,
+		OpTypeArray = 28,
+		OpTypeRuntimeArray = 29,
+		OpTypeStruct = 30,
+		OpTypePointer = 32,
+		OpConstant = 43,
+		OpConstantComposite = 44,
+		OpSpecConstant = 50,
+		OpSpecConstantComposite = 51,
+		OpFunction = 54,
+		OpVariable = 59,
+		OpDecorate = 71,
+		OpMemberDecorate = 72,
+		OpExecutionModeId = 331,
+		OpTypeAccelerationStructureKHR = 5341
+	};
+
+	enum Decoration : uint32_t
+	{
+		DecorationBlock = 2,
+		DecorationBufferBlock = 3,
+		DecorationArrayStride = 6,
+		DecorationMatrixStride = 7,
+		DecorationBuiltIn = 11,
+		DecorationLocation = 30,
+		DecorationBinding = 33,
+		DecorationDescriptorSet = 34,
+		DecorationOffset = 35
+	};
+
+	enum StorageClass : uint32_t
+	{
+		StorageClassUniformConstant = 0,
+		StorageClassInput = 1,
+		StorageClassUniform = 2,
+		StorageClassPushConstant = 9,
+		StorageClassStorageBuffer = 12
+	};
+
+	static constexpr uint32_t ExecutionModeLocalSize = 17;
+	static constexpr uint32_t ExecutionModeLocalSizeId = 38;
+	static constexpr uint32_t BuiltInWorkgroupSize = 25;
+	static constexpr uint32_t DimBuffer = 5;
+	static constexpr uint32_t DimSubpassData = 6;
+}
+
+static constexpr uint32_t unassigned = ~0u;
+
+struct SpirvId
+{
+	// Word offset of the instruction defining the id.
+	uint32_t instruction = 0;
+	uint32_t set = unassigned;
+	uint32_t binding = unassigned;
+	uint32_t location = unassigned;
+	uint32_t arrayStride = 0;
+	uint32_t builtIn = unassigned;
+	bool block = false;
+	bool bufferBlock = false;
+};
+
+struct SpirvMemberDecorations
+{
+	uint32_t offset = unassigned;
+	uint32_t matrixStride = unassigned;
+};
+
+struct ReflectedBinding
+{
+	uint32_t set;
+	VkDescriptorSetLayoutBinding binding;
+};
+
+struct SpirvModule
+{
+	const std::vector<uint32_t>& code;
+	std::vector<SpirvId> ids;
+	// Indexed by struct id and then by member, looked up for every member when sizing the blocks.
+	std::unordered_map<uint32_t, std::vector<SpirvMemberDecorations>> memberDecorations;
+	std::vector<uint32_t> variables;
+	std::vector<ReflectedBinding> bindings;
+};
+
+static uint32_t GetOpcode(const SpirvModule& module, uint32_t id)
+{
+	if (id >= module.ids.size())
+	{
+		return 0;
+	}
+	const uint32_t instruction = module.ids[id].instruction;
+	return instruction ? module.code[instruction] & 0xFFFF : 0;
+}
+
+static bool IsValidId(const SpirvModule& module, uint32_t id)
+{
+	return id < module.ids.size() && module.ids[id].instruction != 0;
+}
+
+// The word counts were checked against the size of the code while parsing.
+static uint32_t GetWordCount(const SpirvModule& module, uint32_t id)
+{
+	return IsValidId(module, id) ? module.code[module.ids[id].instruction] >> 16 : 0;
+}
+
+// Operand zero is the first word after the opcode. Operands missing from the instruction read as zero, which is never a valid id.
+static uint32_t GetOperand(const SpirvModule& module, uint32_t id, uint32_t operand)
+{
+	if (operand + 1 >= GetWordCount(module, id))
+	{
+		return 0;
+	}
+	return module.code[module.ids[id].instruction + 1 + operand];
+}
+
+// Struct types have their member types after the result id.
+static uint32_t GetMemberCount(const SpirvModule& module, uint32_t structId)
+{
+	const uint32_t wordCount = GetWordCount(module, structId);
+	return wordCount >= 2 ? wordCount - 2 : 0;
+}
+
+// Only the low word of the constant is used, which covers all the sizes and counts.
+static uint32_t GetConstantValue(const SpirvModule& module, uint32_t id)
+{
+	if (!IsValidId(module, id))
+	{
+		return 0;
+	}
+	const uint32_t opcode = GetOpcode(module, id);
+	if ((opcode != Spirv::OpConstant && opcode != Spirv::OpSpecConstant) || GetWordCount(module, id) < 4)
+	{
+		return 0;
+	}
+	return GetOperand(module, id, 2);
+}
+
+static uint32_t GetMemberDecoration(const SpirvModule& module, uint32_t structId, uint32_t member, uint32_t decoration)
+{
+	auto it = module.memberDecorations.find(structId);
+	if (it == module.memberDecorations.end() || member >= it->second.size())
+	{
+		return unassigned;
+	}
+	return decoration == Spirv::DecorationOffset ? it->second[member].offset : it->second[member].matrixStride;
+}
+
+static uint32_t GetTypeSize(const SpirvModule& module, uint32_t typeId, uint32_t matrixStride = unassigned, uint32_t depth = 0)
+{
+	// Guards against malformed modules with cyclic types.
+	if (!IsValidId(module, typeId) || depth > 32)
+	{
+		return 0;
+	}
+
+	switch (GetOpcode(module, typeId))
+	{
+	case Spirv::OpTypeBool:
+		return 4;
+	case Spirv::OpTypeInt:
+	case Spirv::OpTypeFloat:
+		return GetOperand(module, typeId, 1) / 8;
+	case Spirv::OpTypeVector:
+		return GetOperand(module, typeId, 2) * GetTypeSize(module, GetOperand(module, typeId, 1), unassigned, depth + 1);
+	case Spirv::OpTypeMatrix:
+	{
+		const uint32_t columnSize = matrixStride != unassigned ? matrixStride :
+			GetTypeSize(module, GetOperand(module, typeId, 1), unassigned, depth + 1);
+		return GetOperand(module, typeId, 2) * columnSize;
+	}
+	case Spirv::OpTypeArray:
+	{
+		const uint32_t length = GetConstantValue(module, GetOperand(module, typeId, 2));
+		const uint32_t stride = module.ids[typeId].arrayStride ? module.ids[typeId].arrayStride :
+			GetTypeSize(module, GetOperand(module, typeId, 1), matrixStride, depth + 1);
+		return length * stride;
+	}
+	case Spirv::OpTypeStruct:
+	{
+		uint32_t size = 0;
+		const uint32_t memberCount = GetMemberCount(module, typeId);
+		for (uint32_t m = 0; m < memberCount; ++m)
+		{
+			uint32_t offset = GetMemberDecoration(module, typeId, m, Spirv::DecorationOffset);
+			offset = offset == unassigned ? size : offset;
+			const uint32_t memberStride = GetMemberDecoration(module, typeId, m, Spirv::DecorationMatrixStride);
+			size = (std::max)(size, offset + GetTypeSize(module, GetOperand(module, typeId, 1 + m), memberStride, depth + 1));
+		}
+		return size;
+	}
+	case Spirv::OpTypePointer:
+		// Physical storage buffer pointers.
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+// Returns false for the types that are not descriptors.
+static bool GetDescriptorType(const SpirvModule& module, uint32_t typeId, uint32_t storageClass, VkDescriptorType& descriptorType)
+{
+	switch (GetOpcode(module, typeId))
+	{
+	case Spirv::OpTypeSampler:
+		descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+		return true;
+	case Spirv::OpTypeSampledImage:
+		descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		return true;
+	case Spirv::OpTypeImage:
+	{
+		const uint32_t dimension = GetOperand(module, typeId, 2);
+		// Sampled is 1 for images used with a sampler and 2 for storage images.
+		const bool storage = GetOperand(module, typeId, 6) == 2;
+		if (dimension == Spirv::DimBuffer)
+		{
+			descriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+		}
+		else if (dimension == Spirv::DimSubpassData)
+		{
+			descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		}
+		else
+		{
+			descriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		return true;
+	}
+	case Spirv::OpTypeStruct:
+		if (storageClass == Spirv::StorageClassStorageBuffer || module.ids[typeId].bufferBlock)
+		{
+			descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			return true;
+		}
+		if (storageClass == Spirv::StorageClassUniform && module.ids[typeId].block)
+		{
+			descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			return true;
+		}
+		return false;
+#ifdef VK_KHR_acceleration_structure
+	case Spirv::OpTypeAccelerationStructureKHR:
+		descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+static VkShaderStageFlagBits GetShaderStage(uint32_t executionModel)
+{
+	switch (executionModel)
+	{
+	case 0:
+		return VK_SHADER_STAGE_VERTEX_BIT;
+	case 1:
+		return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+	case 2:
+		return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+	case 3:
+		return VK_SHADER_STAGE_GEOMETRY_BIT;
+	case 4:
+		return VK_SHADER_STAGE_FRAGMENT_BIT;
+	case 5:
+		return VK_SHADER_STAGE_COMPUTE_BIT;
+#ifdef VK_EXT_mesh_shader
+	case 5364:
+		return VK_SHADER_STAGE_TASK_BIT_EXT;
+	case 5365:
+		return VK_SHADER_STAGE_MESH_BIT_EXT;
+#endif
+#ifdef VK_KHR_ray_tracing_pipeline
+	case 5313:
+		return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+	case 5314:
+		return VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
+	case 5315:
+		return VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+	case 5316:
+		return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+	case 5317:
+		return VK_SHADER_STAGE_MISS_BIT_KHR;
+	case 5318:
+		return VK_SHADER_STAGE_CALLABLE_BIT_KHR;
+#endif
+	default:
+		return VK_SHADER_STAGE_ALL;
+	}
+}
+
+static VkFormat GetVertexFormat(const SpirvModule& module, uint32_t scalarTypeId, uint32_t componentCount)
+{
+	static constexpr VkFormat float16Formats[] = { VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R16G16B16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT };
+	static constexpr VkFormat float32Formats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+	static constexpr VkFormat float64Formats[] = { VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT };
+	static constexpr VkFormat int16Formats[] = { VK_FORMAT_R16_SINT, VK_FORMAT_R16G16_SINT, VK_FORMAT_R16G16B16_SINT, VK_FORMAT_R16G16B16A16_SINT };
+	static constexpr VkFormat int32Formats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+	static constexpr VkFormat uint16Formats[] = { VK_FORMAT_R16_UINT, VK_FORMAT_R16G16_UINT, VK_FORMAT_R16G16B16_UINT, VK_FORMAT_R16G16B16A16_UINT };
+	static constexpr VkFormat uint32Formats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+	if (componentCount < 1 || componentCount > 4 || !IsValidId(module, scalarTypeId))
+	{
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	const uint32_t width = GetOperand(module, scalarTypeId, 1);
+	const uint32_t c = componentCount - 1;
+	if (GetOpcode(module, scalarTypeId) == Spirv::OpTypeFloat)
+	{
+		return width == 16 ? float16Formats[c] : width == 64 ? float64Formats[c] : float32Formats[c];
+	}
+	if (GetOpcode(module, scalarTypeId) == Spirv::OpTypeInt)
+	{
+		const bool isSigned = GetOperand(module, scalarTypeId, 2) != 0;
+		if (width == 16)
+		{
+			return isSigned ? int16Formats[c] : uint16Formats[c];
+		}
+		return isSigned ? int32Formats[c] : uint32Formats[c];
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+static void ReflectVertexInput(const SpirvModule& module, uint32_t variable, uint32_t typeId, VulkanBackend::ShaderReflection& reflection)
+{
+	const SpirvId& id = module.ids[variable];
+	if (id.location == unassigned || id.builtIn != unassigned)
+	{
+		return;
+	}
+
+	// Matrices take one location per column.
+	uint32_t columnType = typeId;
+	uint32_t columnCount = 1;
+	if (GetOpcode(module, typeId) == Spirv::OpTypeMatrix)
+	{
+		columnType = GetOperand(module, typeId, 1);
+		columnCount = GetOperand(module, typeId, 2);
+	}
+
+	uint32_t scalarType = columnType;
+	uint32_t componentCount = 1;
+	if (GetOpcode(module, columnType) == Spirv::OpTypeVector)
+	{
+		scalarType = GetOperand(module, columnType, 1);
+		componentCount = GetOperand(module, columnType, 2);
+	}
+
+	const VkFormat format = GetVertexFormat(module, scalarType, componentCount);
+	if (format == VK_FORMAT_UNDEFINED || columnCount > 4)
+	{
+		CoreLogWarn(DefaultLogger, "Vulkan backend: Vertex input at location %u has an unsupported type.", id.location);
+		return;
+	}
+
+	const uint32_t size = GetTypeSize(module, columnType);
+	for (uint32_t c = 0; c < columnCount; ++c)
+	{
+		reflection.vertexInputs.push_back({ id.location + c, format, size });
+	}
+}
+
+static void ReflectDescriptor(SpirvModule& module, uint32_t variable, uint32_t storageClass, uint32_t typeId,
+	VulkanBackend::ShaderReflection& reflection)
+{
+	const SpirvId& id = module.ids[variable];
+	if (id.set == unassigned || id.binding == unassigned)
+	{
+		return;
+	}
+
+	// The depth guards against malformed modules with cyclic array types.
+	uint32_t descriptorCount = 1;
+	for (uint32_t depth = 0; IsValidId(module, typeId) && depth <= 32; ++depth)
+	{
+		const uint32_t opcode = GetOpcode(module, typeId);
+		if (opcode == Spirv::OpTypeArray)
+		{
+			descriptorCount *= GetConstantValue(module, GetOperand(module, typeId, 2));
+		}
+		else if (opcode == Spirv::OpTypeRuntimeArray)
+		{
+			descriptorCount = 0;
+		}
+		else
+		{
+			break;
+		}
+		typeId = GetOperand(module, typeId, 1);
+	}
+
+	VkDescriptorType descriptorType;
+	if (!GetDescriptorType(module, typeId, storageClass, descriptorType))
+	{
+		return;
+	}
+
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = id.binding;
+	binding.descriptorType = descriptorType;
+	binding.descriptorCount = descriptorCount;
+	binding.stageFlags = reflection.stage;
+	module.bindings.push_back({ id.set, binding });
+}
+
+// Sorting first keeps modules with thousands of bindings linear, instead of searching the set for every binding.
+static void BuildDescriptorSets(SpirvModule& module, VulkanBackend::ShaderReflection& reflection)
+{
+	std::sort(module.bindings.begin(), module.bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b)
+		{
+			return a.set != b.set ? a.set < b.set : a.binding.binding < b.binding.binding;
+		});
+
+	for (const auto& reflected : module.bindings)
+	{
+		if (reflected.set >= reflection.layout.sets.size())
+		{
+			reflection.layout.sets.resize(reflected.set + 1);
+		}
+
+		// Aliased variables share the binding.
+		auto& bindings = reflection.layout.sets[reflected.set].bindings;
+		if (!bindings.empty() && bindings.back().binding == reflected.binding.binding)
+		{
+			continue;
+		}
+		bindings.push_back(reflected.binding);
+	}
+}
+
+static void ReflectPushConstants(const SpirvModule& module, uint32_t typeId, VulkanBackend::ShaderReflection& reflection)
+{
+	if (GetOpcode(module, typeId) != Spirv::OpTypeStruct)
+	{
+		return;
+	}
+
+	// The range starts at the first member, blocks of different stages usually start where the previous ones end.
+	uint32_t offset = unassigned;
+	const uint32_t memberCount = GetMemberCount(module, typeId);
+	for (uint32_t m = 0; m < memberCount; ++m)
+	{
+		offset = (std::min)(offset, GetMemberDecoration(module, typeId, m, Spirv::DecorationOffset));
+	}
+	offset = offset == unassigned ? 0 : offset;
+
+	const uint32_t size = GetTypeSize(module, typeId);
+	if (size > offset)
+	{
+		VulkanBackend::AddPushConstantRange(reflection.layout, reflection.stage, offset, size - offset);
+	}
+}
+
+static void ResolveWorkgroupSize(const SpirvModule& module, uint32_t id, VulkanBackend::ShaderReflection& reflection)
+{
+	const uint32_t opcode = GetOpcode(module, id);
+	if ((opcode == Spirv::OpConstantComposite || opcode == Spirv::OpSpecConstantComposite) && GetWordCount(module, id) >= 6)
+	{
+		for (uint32_t d = 0; d < 3; ++d)
+		{
+			reflection.workgroupSize[d] = GetConstantValue(module, GetOperand(module, id, 2 + d));
+		}
+	}
+}
+
+bool VulkanBackend::ReflectShaderModule(const std::vector<uint32_t>& code, ShaderReflection& reflection)
+{
+	reflection = {};
+	if (code.size() < Spirv::headerWords || code[0] != Spirv::magic)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Shader reflection expects a SPIR-V module.");
+		return false;
+	}
+
+	// The bound sizes the id table, so it is limited before anything is allocated from it.
+	if (code[3] > Spirv::maxIdBound)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Shader reflection found an id bound of %u beyond the SPIR-V limit.", code[3]);
+		return false;
+	}
+
+	SpirvModule module{ code };
+	module.ids.resize(code[3]);
+
+	bool hasEntryPoint = false;
+	uint32_t entryPointId = unassigned;
+	uint32_t localSizeIds[3] = { 0, 0, 0 };
+	uint32_t workgroupSizeConstant = 0;
+
+	const uint32_t wordCount = (uint32_t)code.size();
+	uint32_t word = Spirv::headerWords;
+	while (word < wordCount)
+	{
+		const uint32_t instructionWords = code[word] >> 16;
+		const uint32_t opcode = code[word] & 0xFFFF;
+		if (instructionWords == 0 || word + instructionWords > wordCount)
+		{
+			CoreLogError(DefaultLogger, "Vulkan backend: Shader reflection found a malformed instruction at word %u.", word);
+			return false;
+		}
+
+		// The declarations precede all the function definitions, there is nothing left to reflect after the first one.
+		if (opcode == Spirv::OpFunction)
+		{
+			break;
+		}
+
+		const uint32_t* operands = code.data() + word + 1;
+		const uint32_t operandCount = instructionWords - 1;
+
+		switch (opcode)
+		{
+		case Spirv::OpEntryPoint:
+			if (!hasEntryPoint && operandCount >= 3)
+			{
+				hasEntryPoint = true;
+				reflection.stage = GetShaderStage(operands[0]);
+				entryPointId = operands[1];
+				// The name is a nul terminated string packed into the following words.
+				const char* name = (const char*)(operands + 2);
+				reflection.entryPoint.assign(name, strnlen(name, (operandCount - 2) * sizeof(uint32_t)));
+			}
+			break;
+		case Spirv::OpExecutionMode:
+			if (operandCount >= 5 && operands[0] == entryPointId && operands[1] == Spirv::ExecutionModeLocalSize)
+			{
+				reflection.workgroupSize[0] = operands[2];
+				reflection.workgroupSize[1] = operands[3];
+				reflection.workgroupSize[2] = operands[4];
+			}
+			break;
+		case Spirv::OpExecutionModeId:
+			if (operandCount >= 5 && operands[0] == entryPointId && operands[1] == Spirv::ExecutionModeLocalSizeId)
+			{
+				localSizeIds[0] = operands[2];
+				localSizeIds[1] = operands[3];
+				localSizeIds[2] = operands[4];
+			}
+			break;
+		case Spirv::OpDecorate:
+			if (operandCount >= 2 && operands[0] < module.ids.size())
+			{
+				SpirvId& id = module.ids[operands[0]];
+				const uint32_t value = operandCount >= 3 ? operands[2] : 0;
+				switch (operands[1])
+				{
+				case Spirv::DecorationBlock:
+					id.block = true;
+					break;
+				case Spirv::DecorationBufferBlock:
+					id.bufferBlock = true;
+					break;
+				case Spirv::DecorationArrayStride:
+					id.arrayStride = value;
+					break;
+				case Spirv::DecorationBuiltIn:
+					id.builtIn = value;
+					if (value == Spirv::BuiltInWorkgroupSize)
+					{
+						workgroupSizeConstant = operands[0];
+					}
+					break;
+				case Spirv::DecorationLocation:
+					id.location = value;
+					break;
+				case Spirv::DecorationBinding:
+					id.binding = value;
+					break;
+				case Spirv::DecorationDescriptorSet:
+					id.set = value;
+					break;
+				default:
+					break;
+				}
+			}
+			break;
+		case Spirv::OpMemberDecorate:
+			if (operandCount >= 4 && operands[0] < module.ids.size() && operands[1] < Spirv::maxStructMembers &&
+				(operands[2] == Spirv::DecorationOffset || operands[2] == Spirv::DecorationMatrixStride))
+			{
+				auto& members = module.memberDecorations[operands[0]];
+				if (operands[1] >= members.size())
+				{
+					members.resize(operands[1] + 1);
+				}
+				(operands[2] == Spirv::DecorationOffset ? members[operands[1]].offset : members[operands[1]].matrixStride) = operands[3];
+			}
+			break;
+		case Spirv::OpTypeBool:
+		case Spirv::OpTypeInt:
+		case Spirv::OpTypeFloat:
+		case Spirv::OpTypeVector:
+		case Spirv::OpTypeMatrix:
+		case Spirv::OpTypeImage:
+		case Spirv::OpTypeSampler:
+		case Spirv::OpTypeSampledImage:
+		case Spirv::OpTypeArray:
+		case Spirv::OpTypeRuntimeArray:
+		case Spirv::OpTypeStruct:
+		case Spirv::OpTypePointer:
+		case Spirv::OpTypeAccelerationStructureKHR:
+			// Types have their result id as the first operand.
+			if (operandCount >= 1 && operands[0] < module.ids.size())
+			{
+				module.ids[operands[0]].instruction = word;
+			}
+			break;
+		case Spirv::OpConstant:
+		case Spirv::OpConstantComposite:
+		case Spirv::OpSpecConstant:
+		case Spirv::OpSpecConstantComposite:
+		case Spirv::OpVariable:
+			// Values have their result type first and their result id second.
+			if (operandCount >= 2 && operands[1] < module.ids.size())
+			{
+				module.ids[operands[1]].instruction = word;
+				if (opcode == Spirv::OpVariable)
+				{
+					module.variables.push_back(operands[1]);
+				}
+			}
+			break;
+		default:
+			break;
+		}
+
+		word += instructionWords;
+	}
+
+	if (!hasEntryPoint)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Shader module has no entry point.");
+		return false;
+	}
+
+	for (uint32_t variable : module.variables)
+	{
+		if (GetWordCount(module, variable) < 4)
+		{
+			continue;
+		}
+		const uint32_t storageClass = GetOperand(module, variable, 2);
+		const uint32_t pointerType = GetOperand(module, variable, 0);
+		if (GetOpcode(module, pointerType) != Spirv::OpTypePointer)
+		{
+			continue;
+		}
+		const uint32_t typeId = GetOperand(module, pointerType, 2);
+
+		switch (storageClass)
+		{
+		case Spirv::StorageClassUniformConstant:
+		case Spirv::StorageClassUniform:
+		case Spirv::StorageClassStorageBuffer:
+			ReflectDescriptor(module, variable, storageClass, typeId, reflection);
+			break;
+		case Spirv::StorageClassPushConstant:
+			ReflectPushConstants(module, typeId, reflection);
+			break;
+		case Spirv::StorageClassInput:
+			if (reflection.stage == VK_SHADER_STAGE_VERTEX_BIT)
+			{
+				ReflectVertexInput(module, variable, typeId, reflection);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	BuildDescriptorSets(module, reflection);
+	std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(),
+		[](const ShaderVertexInput& a, const ShaderVertexInput& b) { return a.location < b.location; });
+
+	// The WorkgroupSize built-in takes precedence over the execution modes.
+	if (localSizeIds[0])
+	{
+		for (uint32_t d = 0; d < 3; ++d)
+		{
+			reflection.workgroupSize[d] = GetConstantValue(module, localSizeIds[d]);
+		}
+	}
+	if (workgroupSizeConstant)
+	{
+		ResolveWorkgroupSize(module, workgroupSizeConstant, reflection);
+	}
+
+	return true;
+}
+
+VulkanBackend::PipelineLayoutDescription VulkanBackend::MergeShaderLayouts(const std::vector<ShaderReflection>& reflections)
+{
+	PipelineLayoutDescription merged;
+	for (const auto& reflection : reflections)
+	{
+		for (uint32_t set = 0; set < (uint32_t)reflection.layout.sets.size(); ++set)
+		{
+			for (const auto& binding : reflection.layout.sets[set].bindings)
+			{
+				AddDescriptorBinding(merged, set, binding.binding, binding.descriptorType, binding.stageFlags, binding.descriptorCount);
+			}
+		}
+
+		// A stage may only appear in one range, stages sharing the same block share the range.
+		for (const auto& range : reflection.layout.pushConstantRanges)
+		{
+			auto it = std::find_if(merged.pushConstantRanges.begin(), merged.pushConstantRanges.end(),
+				[&range](const VkPushConstantRange& r) { return r.offset == range.offset && r.size == range.size; });
+			if (it != merged.pushConstantRanges.end())
+			{
+				it->stageFlags |= range.stageFlags;
+			}
+			else
+			{
+				merged.pushConstantRanges.push_back(range);
+			}
+		}
+	}
+	return merged;
+}
+
+void VulkanBackend::GetVertexInputDescriptions(const ShaderReflection& reflection, uint32_t binding,
+	std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes)
+{
+	uint32_t offset = 0;
+	for (const auto& input : reflection.vertexInputs)
+	{
+		attributes.push_back({ input.location, binding, input.format, offset });
+		offset += input.size;
+	}
+	if (offset > 0)
+	{
+		bindings.push_back({ binding, offset, VK_VERTEX_INPUT_RATE_VERTEX });
+	}
+}
+
+static void AppendInstruction(std::vector<uint32_t>& code, uint32_t opcode, std::initializer_list<uint32_t> operands)
+{
+	code.push_back(((uint32_t)(operands.size() + 1) << 16) | opcode);
+	code.insert(code.end(), operands.begin(), operands.end());
+}
+
+double VulkanBackend::BenchmarkShaderReflection(uint32_t bindingCount, uint32_t iterations)
+{
+	// Ids: 1 entry point, 2 float, 3 block struct, 4 uniform pointer, 5 and up the variables.
+	std::vector<uint32_t> code = { Spirv::magic, 0x00010000, 0, 5 + bindingCount, 0 };
+	AppendInstruction(code, 17, { 1 }); // OpCapability Shader
+	AppendInstruction(code, 14, { 0, 1 }); // OpMemoryModel Logical GLSL450
+	AppendInstruction(code, Spirv::OpEntryPoint, { 5, 1, 0x6E69616D, 0 }); // GLCompute "main"
+	AppendInstruction(code, Spirv::OpExecutionMode, { 1, Spirv::ExecutionModeLocalSize, 64, 1, 1 });
+	AppendInstruction(code, Spirv::OpDecorate, { 3, Spirv::DecorationBlock });
+	AppendInstruction(code, Spirv::OpMemberDecorate, { 3, 0, Spirv::DecorationOffset, 0 });
+	for (uint32_t b = 0; b < bindingCount; ++b)
+	{
+		AppendInstruction(code, Spirv::OpDecorate, { 5 + b, Spirv::DecorationDescriptorSet, b % 4 });
+		AppendInstruction(code, Spirv::OpDecorate, { 5 + b, Spirv::DecorationBinding, b / 4 });
+	}
+	AppendInstruction(code, Spirv::OpTypeFloat, { 2, 32 });
+	AppendInstruction(code, Spirv::OpTypeStruct, { 3, 2 });
+	AppendInstruction(code, Spirv::OpTypePointer, { 4, Spirv::StorageClassUniform, 3 });
+	for (uint32_t b = 0; b < bindingCount; ++b)
+	{
+		AppendInstruction(code, Spirv::OpVariable, { 4, 5 + b, Spirv::StorageClassUniform });
+	}
+
+	ShaderReflection reflection;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		ReflectShaderModule(code, reflection);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / (std::max)(1u, iterations);
+}
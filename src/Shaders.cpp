@@ -10,7 +10,7 @@ VkDescriptorPool VulkanBackend::CreateDescriptorPool(const BackendData& backendD
 	descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
 	descriptorPoolCreateInfo.maxSets = maxSets;
 
-	VkDescriptorPool descriptorPool;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
 	VulkanCheck(vkCreateDescriptorPool(backendData.logicalDevice, &descriptorPoolCreateInfo, nullptr, &descriptorPool));
 	return descriptorPool;
 }
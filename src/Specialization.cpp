@@ -0,0 +1,67 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include <algorithm>
+#include <cstring>
+
+void VulkanBackend::SetSpecializationConstant(SpecializationConstants& constants, uint32_t constantId, const void* value, size_t size)
+{
+	for (size_t e = 0; e < constants.entries.size(); ++e)
+	{
+		auto& entry = constants.entries[e];
+		if (entry.constantID != constantId)
+		{
+			continue;
+		}
+		if (entry.size == size)
+		{
+			memcpy(constants.data.data() + entry.offset, value, size);
+			return;
+		}
+		// The old bytes stay in the data until the constants are sorted.
+		constants.entries.erase(constants.entries.begin() + e);
+		break;
+	}
+
+	VkSpecializationMapEntry entry{};
+	entry.constantID = constantId;
+	entry.offset = (uint32_t)constants.data.size();
+	entry.size = size;
+	constants.entries.push_back(entry);
+
+	const uint8_t* bytes = (const uint8_t*)value;
+	constants.data.insert(constants.data.end(), bytes, bytes + size);
+}
+
+void VulkanBackend::SetSpecializationConstant(SpecializationConstants& constants, uint32_t constantId, bool value)
+{
+	const VkBool32 boolValue = value ? VK_TRUE : VK_FALSE;
+	SetSpecializationConstant(constants, constantId, &boolValue, sizeof(boolValue));
+}
+
+VulkanBackend::SpecializationConstants VulkanBackend::SortSpecializationConstants(const SpecializationConstants& constants)
+{
+	SpecializationConstants sorted;
+	sorted.entries = constants.entries;
+	std::sort(sorted.entries.begin(), sorted.entries.end(), [](const VkSpecializationMapEntry& a, const VkSpecializationMapEntry& b)
+		{
+			return a.constantID < b.constantID;
+		});
+
+	for (auto& entry : sorted.entries)
+	{
+		const uint8_t* bytes = constants.data.data() + entry.offset;
+		entry.offset = (uint32_t)sorted.data.size();
+		sorted.data.insert(sorted.data.end(), bytes, bytes + entry.size);
+	}
+
+	return sorted;
+}
+
+VkSpecializationInfo VulkanBackend::GetSpecializationInfo(const SpecializationConstants& constants)
+{
+	VkSpecializationInfo specializationInfo{};
+	specializationInfo.mapEntryCount = (uint32_t)constants.entries.size();
+	specializationInfo.pMapEntries = constants.entries.data();
+	specializationInfo.dataSize = constants.data.size();
+	specializationInfo.pData = constants.data.data();
+	return specializationInfo;
+}
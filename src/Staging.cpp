@@ -0,0 +1,158 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool IsStagingEmpty(const VulkanBackend::StagingRing& ring)
+{
+	return ring.submissions.empty() && !ring.hasOpenAllocations;
+}
+
+static bool IsStagingRangeFree(const VulkanBackend::StagingRing& ring, VkDeviceSize offset, VkDeviceSize size)
+{
+	if (IsStagingEmpty(ring))
+	{
+		return true;
+	}
+
+	// The live data spans from the tail to the head, possibly wrapping around the end of the buffer.
+	if (ring.tail < ring.head)
+	{
+		return offset >= ring.head || offset + size <= ring.tail;
+	}
+	return offset >= ring.head && offset + size <= ring.tail;
+}
+
+static void RetireOldestStaging(const VulkanBackend::BackendData& backendData, VulkanBackend::StagingRing& ring)
+{
+	auto& submission = ring.submissions.front();
+	VulkanCheck(vkWaitForFences(backendData.logicalDevice, 1, &submission.fence, VK_TRUE, UINT64_MAX));
+	VulkanCheck(vkResetFences(backendData.logicalDevice, 1, &submission.fence));
+
+	ring.tail = submission.end;
+	ring.freeFences.push_back(submission.fence);
+	ring.submissions.pop_front();
+
+	if (IsStagingEmpty(ring))
+	{
+		ring.head = 0;
+		ring.tail = 0;
+	}
+}
+
+VulkanBackend::StagingRing VulkanBackend::CreateStagingRing(const BackendData& backendData, VkDeviceSize capacity)
+{
+	StagingRing ring{};
+	ring.capacity = capacity;
+	ring.buffer = CreateBuffer(backendData, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, capacity, VMA_MEMORY_USAGE_CPU_ONLY);
+	VulkanCheck(vmaMapMemory(backendData.allocator, ring.buffer.allocation, (void**)&ring.data));
+	return ring;
+}
+
+void VulkanBackend::DestroyStagingRing(const BackendData& backendData, StagingRing& ring)
+{
+	while (!ring.submissions.empty())
+	{
+		RetireOldestStaging(backendData, ring);
+	}
+	for (auto& fence : ring.freeFences)
+	{
+		DestroyFence(backendData, fence);
+	}
+	ring.freeFences.clear();
+
+	vmaUnmapMemory(backendData.allocator, ring.buffer.allocation);
+	DestroyBuffer(backendData, ring.buffer);
+	ring.data = nullptr;
+	ring.capacity = 0;
+	ring.head = 0;
+	ring.tail = 0;
+	ring.hasOpenAllocations = false;
+}
+
+bool VulkanBackend::AllocateStaging(const BackendData& backendData, StagingRing& ring, VkDeviceSize size, VkDeviceSize alignment,
+	VkDeviceSize& offset)
+{
+	if (size > ring.capacity)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Staging request is larger than the staging ring.");
+		return false;
+	}
+
+	RetireStaging(backendData, ring);
+
+	offset = AlignUp(ring.head, alignment);
+	if (offset + size > ring.capacity)
+	{
+		// The space at the end is skipped, it is reclaimed together with the submission preceding it.
+		offset = 0;
+	}
+
+	while (!IsStagingRangeFree(ring, offset, size))
+	{
+		if (ring.submissions.empty())
+		{
+			CoreLogError(DefaultLogger, "Vulkan backend: Staging ring is full of unsubmitted data.");
+			return false;
+		}
+		RetireOldestStaging(backendData, ring);
+
+		if (IsStagingEmpty(ring))
+		{
+			offset = 0;
+		}
+	}
+
+	ring.head = offset + size;
+	ring.hasOpenAllocations = true;
+	return true;
+}
+
+bool VulkanBackend::SubmitStaging(const BackendData& backendData, StagingRing& ring, VkQueue queue, VkCommandBuffer commandBuffer)
+{
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	if (!ring.hasOpenAllocations)
+	{
+		return vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS;
+	}
+
+	VkFence fence;
+	if (!ring.freeFences.empty())
+	{
+		fence = ring.freeFences.back();
+		ring.freeFences.pop_back();
+	}
+	else
+	{
+		fence = CreateFence(backendData);
+	}
+
+	// The space is only tied to the fence once the submission signaling it exists, otherwise retiring it would wait forever.
+	const VkResult result = vkQueueSubmit(queue, 1, &submitInfo, fence);
+	if (result != VK_SUCCESS)
+	{
+		VulkanCheck(result);
+		ring.freeFences.push_back(fence);
+		return false;
+	}
+
+	ring.submissions.push_back({ fence, ring.head });
+	ring.hasOpenAllocations = false;
+	return true;
+}
+
+void VulkanBackend::RetireStaging(const BackendData& backendData, StagingRing& ring)
+{
+	while (!ring.submissions.empty() && vkGetFenceStatus(backendData.logicalDevice, ring.submissions.front().fence) == VK_SUCCESS)
+	{
+		RetireOldestStaging(backendData, ring);
+	}
+}
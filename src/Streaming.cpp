@@ -0,0 +1,758 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include "Formats.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+
+struct TileRequest
+{
+	uint32_t texture;
+	uint32_t tile;
+	uint32_t mip;
+};
+
+static uint32_t DivideRoundUp(uint32_t value, uint32_t divisor)
+{
+	return (value + divisor - 1) / divisor;
+}
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static VkExtent3D GetMipExtent(const VulkanBackend::StreamingTexture& texture, uint32_t mip)
+{
+	return { (std::max)(texture.width >> mip, 1u), (std::max)(texture.height >> mip, 1u), 1 };
+}
+
+static uint32_t GetTileIndex(const VulkanBackend::StreamingTexture& texture, uint32_t mip, uint32_t regionColumn, uint32_t regionRow)
+{
+	// Tiles have the same texel extent in all mip levels, so a region covers a single tile of each coarser level.
+	// Mip extents round down, so the last regions of non power of two sizes can fall past the last tile of a level.
+	const uint32_t column = (std::min)(regionColumn >> mip, texture.mipTileColumns[mip] - 1);
+	const uint32_t row = (std::min)(regionRow >> mip, texture.mipTileRows[mip] - 1);
+	return texture.mipTileOffsets[mip] + row * texture.mipTileColumns[mip] + column;
+}
+
+static VkDeviceSize GetTileDataSize(const VulkanBackend::StreamingTexture& texture, VkExtent3D extent)
+{
+	const Formats::FormatBlock block{ texture.blockExtent.width, texture.blockExtent.height, texture.blockSize };
+	return Formats::GetRegionSize(block, extent.width, extent.height);
+}
+
+static void GetTileRegion(const VulkanBackend::StreamingTexture& texture, uint32_t tile, uint32_t& mip, VkOffset3D& offset, VkExtent3D& extent)
+{
+	mip = 0;
+	while (tile >= texture.mipTileOffsets[mip + 1])
+	{
+		++mip;
+	}
+
+	const uint32_t localTile = tile - texture.mipTileOffsets[mip];
+	const uint32_t column = localTile % texture.mipTileColumns[mip];
+	const uint32_t row = localTile / texture.mipTileColumns[mip];
+	const VkExtent3D mipExtent = GetMipExtent(texture, mip);
+
+	offset = { (int32_t)(column * texture.tileExtent.width), (int32_t)(row * texture.tileExtent.height), 0 };
+	// Edge tiles are clipped to the mip extent, which is allowed for sparse binds.
+	extent.width = (std::min)(texture.tileExtent.width, mipExtent.width - (uint32_t)offset.x);
+	extent.height = (std::min)(texture.tileExtent.height, mipExtent.height - (uint32_t)offset.y);
+	extent.depth = 1;
+}
+
+static VkSparseImageMemoryBind GetTileBind(const VulkanBackend::StreamingTexture& texture, uint32_t tile,
+	VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+	VkSparseImageMemoryBind bind{};
+	GetTileRegion(texture, tile, bind.subresource.mipLevel, bind.offset, bind.extent);
+	bind.subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	bind.subresource.arrayLayer = 0;
+	bind.memory = memory;
+	bind.memoryOffset = memoryOffset;
+	return bind;
+}
+
+static void UpdateResidency(VulkanBackend::StreamingTexture& texture)
+{
+	// The finest resident mip of a region is the finest level with all the coarser levels up to the mip tail resident.
+	for (uint32_t row = 0; row < texture.regionRows; ++row)
+	{
+		for (uint32_t column = 0; column < texture.regionColumns; ++column)
+		{
+			uint32_t residentMip = texture.mipTailFirstLod;
+			for (uint32_t mip = texture.mipTailFirstLod; mip > 0; --mip)
+			{
+				if (texture.tileStates[GetTileIndex(texture, mip - 1, column, row)] != VulkanBackend::TileState::Resident)
+				{
+					break;
+				}
+				residentMip = mip - 1;
+			}
+			texture.residentMips[row * texture.regionColumns + column] = (uint8_t)residentMip;
+		}
+	}
+}
+
+static void CompleteStreamingUpload(const VulkanBackend::BackendData& backendData, VulkanBackend::TextureStreamer& streamer)
+{
+	VulkanCheck(vkResetFences(backendData.logicalDevice, 1, &streamer.uploadFence));
+	streamer.uploadInFlight = false;
+
+	for (auto& pendingTile : streamer.pendingTiles)
+	{
+		streamer.textures[pendingTile.first].tileStates[pendingTile.second] = VulkanBackend::TileState::Resident;
+	}
+	streamer.pendingTiles.clear();
+
+	// Evicted tiles have been unbound by the completed batch, so their memory can be released now.
+	if (!streamer.pendingFrees.empty())
+	{
+		vmaFreeMemoryPages(backendData.allocator, streamer.pendingFrees.size(), streamer.pendingFrees.data());
+		streamer.pendingFrees.clear();
+	}
+
+	for (auto& texture : streamer.textures)
+	{
+		UpdateResidency(texture);
+	}
+}
+
+static void WaitForStreamingUpload(const VulkanBackend::BackendData& backendData, VulkanBackend::TextureStreamer& streamer)
+{
+	if (streamer.uploadInFlight)
+	{
+		VulkanCheck(vkWaitForFences(backendData.logicalDevice, 1, &streamer.uploadFence, VK_TRUE, UINT64_MAX));
+		CompleteStreamingUpload(backendData, streamer);
+	}
+}
+
+VulkanBackend::TextureStreamer VulkanBackend::CreateTextureStreamer(const BackendData& backendData, VkDeviceSize memoryBudget,
+	uint32_t maxTilesPerUpdate)
+{
+	TextureStreamer streamer{};
+	streamer.memoryBudget = memoryBudget;
+	streamer.maxTilesPerUpdate = maxTilesPerUpdate;
+
+	if (backendData.enabledFeatures.sparseResidencyImage2D != VK_TRUE)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Texture streaming requires the \"sparse residency\" device feature.");
+	}
+
+	uint32_t familyCount;
+	vkGetPhysicalDeviceQueueFamilyProperties(backendData.physicalDevice, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> familyProperties(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(backendData.physicalDevice, &familyCount, familyProperties.data());
+
+	// Binding and uploading on the transfer queue keeps the streaming off the rendering queue when possible.
+	if (!backendData.transferQueues.empty() &&
+		(familyProperties[backendData.transferFamilyIndex].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT))
+	{
+		streamer.queue = backendData.transferQueues[0];
+		streamer.queueFamilyIndex = backendData.transferFamilyIndex;
+	}
+	else if (familyProperties[backendData.generalFamilyIndex].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT)
+	{
+		streamer.queue = backendData.generalQueues[0];
+		streamer.queueFamilyIndex = backendData.generalFamilyIndex;
+	}
+	else
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: No sparse binding capable queue available for texture streaming.");
+		return streamer;
+	}
+
+	streamer.commandPool = CreateCommandPool(backendData, streamer.queueFamilyIndex, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+	streamer.commandBuffer = AllocateCommandBuffer(backendData, streamer.commandPool);
+	streamer.bindSemaphore = CreateSemaphore(backendData);
+	streamer.uploadFence = CreateFence(backendData);
+
+	streamer.statistics.memoryBudget = memoryBudget;
+
+	return streamer;
+}
+
+void VulkanBackend::DestroyTextureStreamer(const BackendData& backendData, TextureStreamer& streamer)
+{
+	WaitForStreamingUpload(backendData, streamer);
+
+	for (auto& texture : streamer.textures)
+	{
+		for (auto& allocation : texture.tileAllocations)
+		{
+			if (allocation)
+			{
+				vmaFreeMemory(backendData.allocator, allocation);
+			}
+		}
+		if (texture.mipTailAllocation)
+		{
+			vmaFreeMemory(backendData.allocator, texture.mipTailAllocation);
+		}
+		vkDestroyImage(backendData.logicalDevice, texture.image, nullptr);
+	}
+	streamer.textures.clear();
+	streamer.evictions.clear();
+
+	if (streamer.stagingBuffer.buffer)
+	{
+		vmaUnmapMemory(backendData.allocator, streamer.stagingBuffer.allocation);
+		DestroyBuffer(backendData, streamer.stagingBuffer);
+		streamer.stagingData = nullptr;
+		streamer.stagingSize = 0;
+	}
+
+	if (streamer.commandPool)
+	{
+		DestroyFence(backendData, streamer.uploadFence);
+		DestroySemaphore(backendData, streamer.bindSemaphore);
+		DestroyCommandPool(backendData, streamer.commandPool);
+		streamer.commandBuffer = VK_NULL_HANDLE;
+	}
+
+	streamer.bytesResident = 0;
+}
+
+uint32_t VulkanBackend::CreateStreamingTexture(const BackendData& backendData, TextureStreamer& streamer, uint32_t width, uint32_t height,
+	uint32_t mipCount, VkFormat format, const TileLoader& loader)
+{
+	const VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	if (!streamer.queue)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Streaming textures require a valid texture streamer.");
+		return UINT32_MAX;
+	}
+
+	Formats::FormatBlock block;
+	if (!Formats::GetFormatBlock(format, block))
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Unsupported streaming texture format %d.", (int)format);
+		return UINT32_MAX;
+	}
+
+	uint32_t sparseFormatCount = 0;
+	vkGetPhysicalDeviceSparseImageFormatProperties(backendData.physicalDevice, format, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT,
+		usage, VK_IMAGE_TILING_OPTIMAL, &sparseFormatCount, nullptr);
+	if (sparseFormatCount == 0)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Texture format does not support sparse residency.");
+		return UINT32_MAX;
+	}
+
+	// The creation is a loading operation, so it is fine to wait for the streaming objects to become available.
+	WaitForStreamingUpload(backendData, streamer);
+
+	StreamingTexture texture{};
+	texture.format = format;
+	texture.width = width;
+	texture.height = height;
+	texture.mipCount = mipCount;
+	texture.blockExtent = { block.width, block.height };
+	texture.blockSize = block.bytes;
+	texture.loader = loader;
+
+	VkImageCreateInfo imageCreateInfo{};
+	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageCreateInfo.flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageCreateInfo.format = format;
+	imageCreateInfo.extent = { width, height, 1 };
+	imageCreateInfo.mipLevels = mipCount;
+	imageCreateInfo.arrayLayers = 1;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCreateInfo.usage = usage;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	// The texture is sampled on the general queue while the streaming queue writes to it.
+	uint32_t queueFamilies[] = { (uint32_t)backendData.generalFamilyIndex, streamer.queueFamilyIndex };
+	if (streamer.queueFamilyIndex != (uint32_t)backendData.generalFamilyIndex)
+	{
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		imageCreateInfo.queueFamilyIndexCount = 2;
+		imageCreateInfo.pQueueFamilyIndices = queueFamilies;
+	}
+
+	VulkanCheck(vkCreateImage(backendData.logicalDevice, &imageCreateInfo, nullptr, &texture.image));
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(backendData.logicalDevice, texture.image, &memoryRequirements);
+	if (memoryRequirements.size > backendData.deviceProperties.limits.sparseAddressSpaceSize)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Streaming texture exceeds the sparse address space.");
+		vkDestroyImage(backendData.logicalDevice, texture.image, nullptr);
+		return UINT32_MAX;
+	}
+
+	uint32_t sparseRequirementCount = 0;
+	vkGetImageSparseMemoryRequirements(backendData.logicalDevice, texture.image, &sparseRequirementCount, nullptr);
+	std::vector<VkSparseImageMemoryRequirements> sparseRequirements(sparseRequirementCount);
+	vkGetImageSparseMemoryRequirements(backendData.logicalDevice, texture.image, &sparseRequirementCount, sparseRequirements.data());
+
+	VkSparseImageMemoryRequirements colorRequirements{};
+	bool colorRequirementsFound = false;
+	for (auto& sparseRequirement : sparseRequirements)
+	{
+		if (sparseRequirement.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT)
+		{
+			colorRequirements = sparseRequirement;
+			colorRequirementsFound = true;
+			break;
+		}
+	}
+
+	// Without them the tiles would have no extent and the whole image would be an empty mip tail.
+	const VkExtent3D granularity = colorRequirements.formatProperties.imageGranularity;
+	if (!colorRequirementsFound || granularity.width == 0 || granularity.height == 0)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Streaming texture has no sparse requirements for its color aspect.");
+		vkDestroyImage(backendData.logicalDevice, texture.image, nullptr);
+		return UINT32_MAX;
+	}
+
+	// A tile is a single sparse block (the memory alignment is the sparse block size).
+	texture.tileExtent = colorRequirements.formatProperties.imageGranularity;
+	texture.tileSize = memoryRequirements.alignment;
+	texture.memoryTypeBits = memoryRequirements.memoryTypeBits;
+	texture.mipTailFirstLod = (std::min)(colorRequirements.imageMipTailFirstLod, mipCount);
+
+	uint32_t tileCount = 0;
+	for (uint32_t mip = 0; mip < texture.mipTailFirstLod; ++mip)
+	{
+		const VkExtent3D mipExtent = GetMipExtent(texture, mip);
+		texture.mipTileOffsets.push_back(tileCount);
+		texture.mipTileColumns.push_back(DivideRoundUp(mipExtent.width, texture.tileExtent.width));
+		texture.mipTileRows.push_back(DivideRoundUp(mipExtent.height, texture.tileExtent.height));
+		tileCount += texture.mipTileColumns[mip] * texture.mipTileRows[mip];
+	}
+	texture.mipTileOffsets.push_back(tileCount);
+	texture.tileStates.resize(tileCount, TileState::Empty);
+	texture.tileAllocations.resize(tileCount, VK_NULL_HANDLE);
+	texture.tileLastUsedFrames.resize(tileCount, 0);
+
+	texture.regionColumns = texture.mipTailFirstLod > 0 ? texture.mipTileColumns[0] : 1;
+	texture.regionRows = texture.mipTailFirstLod > 0 ? texture.mipTileRows[0] : 1;
+	texture.desiredMips.resize(texture.regionColumns * texture.regionRows, (uint8_t)texture.mipTailFirstLod);
+	texture.residentMips.resize(texture.regionColumns * texture.regionRows, (uint8_t)texture.mipTailFirstLod);
+
+	// Making sure a full batch of the largest tiles fits into the staging buffer.
+	const VkDeviceSize requiredStagingSize = streamer.maxTilesPerUpdate * AlignUp(texture.tileSize, block.bytes * 4);
+	if (requiredStagingSize > streamer.stagingSize)
+	{
+		if (streamer.stagingBuffer.buffer)
+		{
+			vmaUnmapMemory(backendData.allocator, streamer.stagingBuffer.allocation);
+			DestroyBuffer(backendData, streamer.stagingBuffer);
+		}
+		streamer.stagingBuffer = CreateBuffer(backendData, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, requiredStagingSize, VMA_MEMORY_USAGE_CPU_ONLY);
+		VulkanCheck(vmaMapMemory(backendData.allocator, streamer.stagingBuffer.allocation, &streamer.stagingData));
+		streamer.stagingSize = requiredStagingSize;
+	}
+
+	// The mip tail is always resident, it is bound and uploaded right away.
+	const bool hasMipTail = texture.mipTailFirstLod < mipCount;
+	Buffer tailStagingBuffer;
+	std::vector<VkBufferImageCopy> tailRegions;
+	if (hasMipTail)
+	{
+		VkMemoryRequirements tailRequirements = memoryRequirements;
+		tailRequirements.size = colorRequirements.imageMipTailSize;
+
+		VmaAllocationCreateInfo allocationCreateInfo{};
+		allocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+		VmaAllocationInfo tailAllocationInfo;
+		VulkanCheck(vmaAllocateMemory(backendData.allocator, &tailRequirements, &allocationCreateInfo,
+			&texture.mipTailAllocation, &tailAllocationInfo));
+		streamer.bytesResident += colorRequirements.imageMipTailSize;
+
+		VkSparseMemoryBind tailBind{};
+		tailBind.resourceOffset = colorRequirements.imageMipTailOffset;
+		tailBind.size = colorRequirements.imageMipTailSize;
+		tailBind.memory = tailAllocationInfo.deviceMemory;
+		tailBind.memoryOffset = tailAllocationInfo.offset;
+
+		VkSparseImageOpaqueMemoryBindInfo opaqueBindInfo{};
+		opaqueBindInfo.image = texture.image;
+		opaqueBindInfo.bindCount = 1;
+		opaqueBindInfo.pBinds = &tailBind;
+
+		VkBindSparseInfo bindSparseInfo{};
+		bindSparseInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+		bindSparseInfo.imageOpaqueBindCount = 1;
+		bindSparseInfo.pImageOpaqueBinds = &opaqueBindInfo;
+		bindSparseInfo.signalSemaphoreCount = 1;
+		bindSparseInfo.pSignalSemaphores = &streamer.bindSemaphore;
+
+		VulkanCheck(vkQueueBindSparse(streamer.queue, 1, &bindSparseInfo, VK_NULL_HANDLE));
+
+		VkDeviceSize tailDataSize = 0;
+		for (uint32_t mip = texture.mipTailFirstLod; mip < mipCount; ++mip)
+		{
+			const VkExtent3D mipExtent = GetMipExtent(texture, mip);
+			tailDataSize = AlignUp(tailDataSize, block.bytes * 4);
+
+			VkBufferImageCopy region{};
+			region.bufferOffset = tailDataSize;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = mip;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = mipExtent;
+			tailRegions.push_back(region);
+
+			tailDataSize += Formats::GetRegionSize(block, mipExtent.width, mipExtent.height);
+		}
+
+		tailStagingBuffer = CreateBuffer(backendData, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, tailDataSize, VMA_MEMORY_USAGE_CPU_ONLY);
+		uint8_t* tailData;
+		VulkanCheck(vmaMapMemory(backendData.allocator, tailStagingBuffer.allocation, (void**)&tailData));
+		for (auto& region : tailRegions)
+		{
+			loader(region.imageSubresource.mipLevel, region.imageOffset, region.imageExtent, tailData + region.bufferOffset);
+		}
+		vmaFlushAllocation(backendData.allocator, tailStagingBuffer.allocation, 0, VK_WHOLE_SIZE);
+		vmaUnmapMemory(backendData.allocator, tailStagingBuffer.allocation);
+	}
+
+	// Streaming textures live in the general layout, so tiles can be written while other tiles are being sampled.
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VulkanCheck(vkBeginCommandBuffer(streamer.commandBuffer, &beginInfo));
+
+	TransitionImageLayout(streamer.commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, texture.image, mipCount,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+	if (hasMipTail)
+	{
+		vkCmdCopyBufferToImage(streamer.commandBuffer, tailStagingBuffer.buffer, texture.image, VK_IMAGE_LAYOUT_GENERAL,
+			(uint32_t)tailRegions.size(), tailRegions.data());
+		TransitionImageLayout(streamer.commandBuffer, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, texture.image, mipCount,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+
+	VulkanCheck(vkEndCommandBuffer(streamer.commandBuffer));
+
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = hasMipTail ? 1 : 0;
+	submitInfo.pWaitSemaphores = &streamer.bindSemaphore;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &streamer.commandBuffer;
+
+	VulkanCheck(vkQueueSubmit(streamer.queue, 1, &submitInfo, streamer.uploadFence));
+	VulkanCheck(vkWaitForFences(backendData.logicalDevice, 1, &streamer.uploadFence, VK_TRUE, UINT64_MAX));
+	VulkanCheck(vkResetFences(backendData.logicalDevice, 1, &streamer.uploadFence));
+
+	if (tailStagingBuffer.buffer)
+	{
+		DestroyBuffer(backendData, tailStagingBuffer);
+	}
+
+	streamer.textures.push_back(std::move(texture));
+	return (uint32_t)streamer.textures.size() - 1;
+}
+
+void VulkanBackend::SetStreamingFeedback(TextureStreamer& streamer, uint32_t texture, const uint8_t* desiredMips)
+{
+	auto& streamingTexture = streamer.textures[texture];
+	for (size_t r = 0; r < streamingTexture.desiredMips.size(); ++r)
+	{
+		streamingTexture.desiredMips[r] = (std::min)(desiredMips[r], (uint8_t)streamingTexture.mipTailFirstLod);
+	}
+}
+
+void VulkanBackend::UpdateTextureStreamer(const BackendData& backendData, TextureStreamer& streamer)
+{
+	++streamer.frame;
+
+	StreamingStatistics& statistics = streamer.statistics;
+	statistics = {};
+	statistics.frame = streamer.frame;
+	statistics.memoryBudget = streamer.memoryBudget;
+
+	// Gathering the missing tiles and refreshing the usage of the wanted ones.
+	std::vector<TileRequest> requests;
+	for (uint32_t t = 0; t < streamer.textures.size(); ++t)
+	{
+		auto& texture = streamer.textures[t];
+		for (uint32_t row = 0; row < texture.regionRows; ++row)
+		{
+			for (uint32_t column = 0; column < texture.regionColumns; ++column)
+			{
+				const uint32_t desiredMip = texture.desiredMips[row * texture.regionColumns + column];
+				for (uint32_t mip = desiredMip; mip < texture.mipTailFirstLod; ++mip)
+				{
+					const uint32_t tile = GetTileIndex(texture, mip, column, row);
+					if (texture.tileLastUsedFrames[tile] == streamer.frame)
+					{
+						// Coarser tiles are shared by neighbouring regions.
+						continue;
+					}
+					texture.tileLastUsedFrames[tile] = streamer.frame;
+					if (texture.tileStates[tile] == TileState::Empty)
+					{
+						requests.push_back({ t, tile, mip });
+					}
+				}
+			}
+		}
+	}
+	statistics.tilesRequested = (uint32_t)requests.size();
+
+	if (streamer.uploadInFlight)
+	{
+		if (vkGetFenceStatus(backendData.logicalDevice, streamer.uploadFence) != VK_SUCCESS)
+		{
+			// The previous batch is still in flight, the frame must not block on it.
+			statistics.uploadStalled = true;
+			statistics.tilesPending = (uint32_t)streamer.pendingTiles.size();
+			statistics.bytesResident = streamer.bytesResident;
+			return;
+		}
+		CompleteStreamingUpload(backendData, streamer);
+	}
+
+	// Unbinding the evicted tiles no frame in flight can still be sampling, the memory is freed once the bind completes.
+	std::vector<std::vector<VkSparseImageMemoryBind>> textureBinds(streamer.textures.size());
+	while (!streamer.evictions.empty() && streamer.evictions.front().frame <= streamer.completedFrame)
+	{
+		const TileEviction eviction = streamer.evictions.front();
+		streamer.evictions.pop_front();
+
+		auto& texture = streamer.textures[eviction.texture];
+		textureBinds[eviction.texture].push_back(GetTileBind(texture, eviction.tile, VK_NULL_HANDLE, 0));
+		streamer.pendingFrees.push_back(texture.tileAllocations[eviction.tile]);
+		texture.tileAllocations[eviction.tile] = VK_NULL_HANDLE;
+		texture.tileStates[eviction.tile] = TileState::Empty;
+		streamer.bytesResident -= texture.tileSize;
+	}
+
+	// Coarse mips go first, so that regions sharpen progressively.
+	std::stable_sort(requests.begin(), requests.end(), [](const TileRequest& a, const TileRequest& b)
+	{
+		return a.mip > b.mip;
+	});
+	if (requests.size() > streamer.maxTilesPerUpdate)
+	{
+		requests.resize(streamer.maxTilesPerUpdate);
+	}
+
+	VkDeviceSize requiredMemory = 0;
+	for (auto& request : requests)
+	{
+		requiredMemory += streamer.textures[request.texture].tileSize;
+	}
+
+	// Evicting the least recently used tiles not wanted this frame. Frames already in flight may still sample them,
+	// so they are only reported as non-resident now and unbound once the current frame has completed.
+	VkDeviceSize evictingMemory = 0;
+	for (const auto& eviction : streamer.evictions)
+	{
+		evictingMemory += streamer.textures[eviction.texture].tileSize;
+	}
+	if (streamer.bytesResident + requiredMemory > streamer.memoryBudget + evictingMemory)
+	{
+		std::vector<std::pair<uint64_t, std::pair<uint32_t, uint32_t>>> candidates;
+		for (uint32_t t = 0; t < streamer.textures.size(); ++t)
+		{
+			auto& texture = streamer.textures[t];
+			for (uint32_t tile = 0; tile < texture.tileStates.size(); ++tile)
+			{
+				if (texture.tileStates[tile] == TileState::Resident && texture.tileLastUsedFrames[tile] < streamer.frame)
+				{
+					candidates.push_back({ texture.tileLastUsedFrames[tile], { t, tile } });
+				}
+			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		std::vector<bool> texturesEvicted(streamer.textures.size(), false);
+		for (auto& candidate : candidates)
+		{
+			if (streamer.bytesResident + requiredMemory <= streamer.memoryBudget + evictingMemory)
+			{
+				break;
+			}
+
+			auto& texture = streamer.textures[candidate.second.first];
+			const uint32_t tile = candidate.second.second;
+			texture.tileStates[tile] = TileState::Evicting;
+			streamer.evictions.push_back({ streamer.frame, candidate.second.first, tile });
+			evictingMemory += texture.tileSize;
+			texturesEvicted[candidate.second.first] = true;
+			++statistics.tilesEvicted;
+		}
+
+		// Evicted tiles must not be reported as resident past this point.
+		for (uint32_t t = 0; t < streamer.textures.size(); ++t)
+		{
+			if (texturesEvicted[t])
+			{
+				UpdateResidency(streamer.textures[t]);
+			}
+		}
+
+		// Whatever does not fit into the budget has to wait for the evicted tiles to be unbound.
+		while (!requests.empty() && streamer.bytesResident + requiredMemory > streamer.memoryBudget)
+		{
+			requiredMemory -= streamer.textures[requests.back().texture].tileSize;
+			requests.pop_back();
+		}
+	}
+
+	// Grouping the requests per texture, so that the memory pages and copies can be batched.
+	std::stable_sort(requests.begin(), requests.end(), [](const TileRequest& a, const TileRequest& b)
+	{
+		return a.texture < b.texture;
+	});
+
+	std::vector<std::vector<VkBufferImageCopy>> textureCopies(streamer.textures.size());
+	VkDeviceSize stagingOffset = 0;
+	for (size_t begin = 0; begin < requests.size();)
+	{
+		size_t end = begin;
+		while (end < requests.size() && requests[end].texture == requests[begin].texture)
+		{
+			++end;
+		}
+
+		auto& texture = streamer.textures[requests[begin].texture];
+		const size_t pageCount = end - begin;
+
+		VkMemoryRequirements pageRequirements{};
+		pageRequirements.size = texture.tileSize;
+		pageRequirements.alignment = texture.tileSize;
+		pageRequirements.memoryTypeBits = texture.memoryTypeBits;
+
+		VmaAllocationCreateInfo allocationCreateInfo{};
+		allocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+		std::vector<VmaAllocation> pageAllocations(pageCount);
+		std::vector<VmaAllocationInfo> pageInfos(pageCount);
+		VulkanCheck(vmaAllocateMemoryPages(backendData.allocator, &pageRequirements, &allocationCreateInfo, pageCount,
+			pageAllocations.data(), pageInfos.data()));
+
+		for (size_t r = begin; r < end; ++r)
+		{
+			const uint32_t tile = requests[r].tile;
+			const size_t page = r - begin;
+
+			VkSparseImageMemoryBind bind = GetTileBind(texture, tile, pageInfos[page].deviceMemory, pageInfos[page].offset);
+			textureBinds[requests[r].texture].push_back(bind);
+			texture.tileAllocations[tile] = pageAllocations[page];
+			texture.tileStates[tile] = TileState::Pending;
+			streamer.pendingTiles.push_back({ requests[r].texture, tile });
+			streamer.bytesResident += texture.tileSize;
+
+			stagingOffset = AlignUp(stagingOffset, texture.blockSize * 4);
+			texture.loader(bind.subresource.mipLevel, bind.offset, bind.extent, (uint8_t*)streamer.stagingData + stagingOffset);
+
+			VkBufferImageCopy region{};
+			region.bufferOffset = stagingOffset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = bind.subresource.mipLevel;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = bind.offset;
+			region.imageExtent = bind.extent;
+			textureCopies[requests[r].texture].push_back(region);
+
+			const VkDeviceSize tileDataSize = GetTileDataSize(texture, bind.extent);
+			stagingOffset += tileDataSize;
+			statistics.bytesUploaded += tileDataSize;
+		}
+
+		begin = end;
+	}
+	statistics.tilesPagedIn = (uint32_t)requests.size();
+	statistics.tilesPending = (uint32_t)streamer.pendingTiles.size();
+	statistics.bytesResident = streamer.bytesResident;
+
+	std::vector<VkSparseImageMemoryBindInfo> imageBindInfos;
+	for (uint32_t t = 0; t < streamer.textures.size(); ++t)
+	{
+		if (!textureBinds[t].empty())
+		{
+			VkSparseImageMemoryBindInfo imageBindInfo{};
+			imageBindInfo.image = streamer.textures[t].image;
+			imageBindInfo.bindCount = (uint32_t)textureBinds[t].size();
+			imageBindInfo.pBinds = textureBinds[t].data();
+			imageBindInfos.push_back(imageBindInfo);
+		}
+	}
+
+	if (imageBindInfos.empty())
+	{
+		return;
+	}
+
+	// Paging in and evicting happen in a single bind, the upload waits for it on the same queue.
+	const bool hasUploads = !requests.empty();
+	VkBindSparseInfo bindSparseInfo{};
+	bindSparseInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+	bindSparseInfo.imageBindCount = (uint32_t)imageBindInfos.size();
+	bindSparseInfo.pImageBinds = imageBindInfos.data();
+	bindSparseInfo.signalSemaphoreCount = hasUploads ? 1 : 0;
+	bindSparseInfo.pSignalSemaphores = &streamer.bindSemaphore;
+
+	VulkanCheck(vkQueueBindSparse(streamer.queue, 1, &bindSparseInfo, hasUploads ? VK_NULL_HANDLE : streamer.uploadFence));
+	streamer.uploadInFlight = true;
+
+	if (!hasUploads)
+	{
+		return;
+	}
+
+	vmaFlushAllocation(backendData.allocator, streamer.stagingBuffer.allocation, 0, stagingOffset);
+
+	VulkanCheck(vkResetCommandBuffer(streamer.commandBuffer, 0));
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VulkanCheck(vkBeginCommandBuffer(streamer.commandBuffer, &beginInfo));
+
+	for (uint32_t t = 0; t < streamer.textures.size(); ++t)
+	{
+		if (!textureCopies[t].empty())
+		{
+			auto& texture = streamer.textures[t];
+			vkCmdCopyBufferToImage(streamer.commandBuffer, streamer.stagingBuffer.buffer, texture.image, VK_IMAGE_LAYOUT_GENERAL,
+				(uint32_t)textureCopies[t].size(), textureCopies[t].data());
+			TransitionImageLayout(streamer.commandBuffer, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, texture.image, texture.mipCount,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+		}
+	}
+
+	VulkanCheck(vkEndCommandBuffer(streamer.commandBuffer));
+
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = &streamer.bindSemaphore;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &streamer.commandBuffer;
+
+	VulkanCheck(vkQueueSubmit(streamer.queue, 1, &submitInfo, streamer.uploadFence));
+}
+
+void VulkanBackend::SetStreamingCompletedFrame(TextureStreamer& streamer, uint64_t frame)
+{
+	streamer.completedFrame = (std::max)(streamer.completedFrame, frame);
+}
+
+const std::vector<uint8_t>& VulkanBackend::GetStreamingResidency(const TextureStreamer& streamer, uint32_t texture)
+{
+	return streamer.textures[texture].residentMips;
+}
+
+const VulkanBackend::StreamingStatistics& VulkanBackend::GetStreamingStatistics(const TextureStreamer& streamer)
+{
+	return streamer.statistics;
+}
@@ -0,0 +1,270 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+
+static void CreateSwapchainResources(const VulkanBackend::BackendData& backendData, const VulkanBackend::SurfaceData& surfaceData,
+	VulkanBackend::SwapchainManager& manager)
+{
+	VulkanBackend::GetSwapchainImages(backendData, manager.swapchain, manager.images);
+
+	manager.imageViews.resize(manager.images.size());
+	manager.renderFinished.resize(manager.images.size());
+	for (size_t i = 0; i < manager.images.size(); ++i)
+	{
+		VkImageSubresourceRange subresource{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		manager.imageViews[i] = VulkanBackend::CreateImageView2D(backendData, manager.images[i], surfaceData.surfaceFormat.format, subresource);
+		manager.renderFinished[i] = VulkanBackend::CreateSemaphore(backendData);
+	}
+}
+
+static void DestroyRetiredSwapchain(const VulkanBackend::BackendData& backendData, VulkanBackend::RetiredSwapchain& retired)
+{
+	// A registered framebuffer cache drops the framebuffers of the views here.
+	for (auto& imageView : retired.imageViews)
+	{
+		VulkanBackend::DestroyImageView(backendData, imageView);
+	}
+	for (auto& semaphore : retired.renderFinished)
+	{
+		VulkanBackend::DestroySemaphore(backendData, semaphore);
+	}
+	VulkanBackend::DestroySwapchain(backendData, retired.swapchain);
+}
+
+static bool RecreateManagedSwapchain(const VulkanBackend::BackendData& backendData, VulkanBackend::SurfaceData& surfaceData,
+	VulkanBackend::SwapchainManager& manager)
+{
+	VulkanBackend::GetSurfaceCapabilities(backendData, surfaceData);
+	VulkanBackend::GetSurfaceExtent(backendData, surfaceData);
+	if (surfaceData.surfaceExtent.width == 0 || surfaceData.surfaceExtent.height == 0)
+	{
+		// Minimized windows cannot have a swapchain, the recreation is retried on the next frame.
+		return false;
+	}
+
+	// The old swapchain stays valid for the frames still in flight, the new one is created from it.
+	VulkanBackend::RetiredSwapchain retired{};
+	retired.swapchain = manager.swapchain;
+	retired.imageViews = std::move(manager.imageViews);
+	retired.renderFinished = std::move(manager.renderFinished);
+	retired.retireFrame = manager.frameNumber;
+
+	VkSwapchainKHR oldSwapchain = manager.swapchain;
+	manager.swapchain = VulkanBackend::RecreateSwapchain(backendData, surfaceData, oldSwapchain, manager.imageUsage);
+	manager.imageViews.clear();
+	manager.renderFinished.clear();
+	CreateSwapchainResources(backendData, surfaceData, manager);
+
+	if (retired.swapchain)
+	{
+		manager.retired.push_back(std::move(retired));
+	}
+
+	// Present ids are tracked per swapchain, older ones can never be waited on through the new one.
+	manager.swapchainFirstPresentId = manager.presentId + 1;
+	manager.needsRecreation = false;
+	return true;
+}
+
+static void ReleaseRetiredSwapchains(const VulkanBackend::BackendData& backendData, VulkanBackend::SwapchainManager& manager)
+{
+	// Once every frame slot has been waited on since the retirement, nothing references the old swapchain anymore.
+	const uint64_t framesInFlight = manager.frames.size();
+	for (size_t r = 0; r < manager.retired.size();)
+	{
+		if (manager.frameNumber >= manager.retired[r].retireFrame + framesInFlight)
+		{
+			DestroyRetiredSwapchain(backendData, manager.retired[r]);
+			manager.retired[r] = std::move(manager.retired.back());
+			manager.retired.pop_back();
+		}
+		else
+		{
+			++r;
+		}
+	}
+}
+
+VulkanBackend::SwapchainManager VulkanBackend::CreateSwapchainManager(const BackendData& backendData, SurfaceData& surfaceData,
+	uint32_t framesInFlight, VkImageUsageFlags imageUsage)
+{
+	SwapchainManager manager{};
+	manager.imageUsage = imageUsage;
+
+	manager.frames.resize(framesInFlight);
+	for (auto& frame : manager.frames)
+	{
+		frame.imageAcquired = CreateSemaphore(backendData);
+		// Created signaled, so that the first wait on each frame slot returns immediately.
+		frame.inFlight = CreateFence(backendData, VK_FENCE_CREATE_SIGNALED_BIT);
+		frame.commandPool = CreateCommandPool(backendData, backendData.generalFamilyIndex, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		frame.commandBuffer = AllocateCommandBuffer(backendData, frame.commandPool);
+	}
+
+	if (!RecreateManagedSwapchain(backendData, surfaceData, manager))
+	{
+		manager.needsRecreation = true;
+	}
+
+	return manager;
+}
+
+void VulkanBackend::DestroySwapchainManager(const BackendData& backendData, const SurfaceData& surfaceData, SwapchainManager& manager)
+{
+	for (auto& frame : manager.frames)
+	{
+		VulkanCheck(vkWaitForFences(backendData.logicalDevice, 1, &frame.inFlight, VK_TRUE, UINT64_MAX));
+	}
+	manager.completedFrames = manager.frameNumber;
+	// Presentation is not covered by the fences.
+	if (surfaceData.defaultPresentQueue)
+	{
+		VulkanCheck(vkQueueWaitIdle(surfaceData.defaultPresentQueue));
+	}
+
+	for (auto& retired : manager.retired)
+	{
+		DestroyRetiredSwapchain(backendData, retired);
+	}
+	manager.retired.clear();
+
+	RetiredSwapchain current{ manager.swapchain, std::move(manager.imageViews), std::move(manager.renderFinished), 0 };
+	DestroyRetiredSwapchain(backendData, current);
+	manager.swapchain = VK_NULL_HANDLE;
+	manager.images.clear();
+	manager.imageViews.clear();
+	manager.renderFinished.clear();
+
+	for (auto& frame : manager.frames)
+	{
+		DestroySemaphore(backendData, frame.imageAcquired);
+		DestroyFence(backendData, frame.inFlight);
+		DestroyCommandPool(backendData, frame.commandPool);
+	}
+	manager.frames.clear();
+}
+
+VkCommandBuffer VulkanBackend::BeginSwapchainFrame(const BackendData& backendData, SurfaceData& surfaceData, SwapchainManager& manager)
+{
+	SwapchainFrame& frame = manager.frames[manager.currentFrame];
+	VulkanCheck(vkWaitForFences(backendData.logicalDevice, 1, &frame.inFlight, VK_TRUE, UINT64_MAX));
+
+	// The slot was last used frames in flight ago, that frame and everything submitted before it has finished.
+	const uint64_t framesInFlight = manager.frames.size();
+	if (manager.frameNumber >= framesInFlight)
+	{
+		manager.completedFrames = (std::max)(manager.completedFrames, manager.frameNumber - framesInFlight + 1);
+	}
+
+	ReleaseRetiredSwapchains(backendData, manager);
+
+	if (manager.needsRecreation && !RecreateManagedSwapchain(backendData, surfaceData, manager))
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	VkResult result = vkAcquireNextImageKHR(backendData.logicalDevice, manager.swapchain, UINT64_MAX, frame.imageAcquired,
+		VK_NULL_HANDLE, &manager.imageIndex);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		// The semaphore is left unsignaled on failure, so it can be reused for the retry.
+		if (!RecreateManagedSwapchain(backendData, surfaceData, manager))
+		{
+			return VK_NULL_HANDLE;
+		}
+		result = vkAcquireNextImageKHR(backendData.logicalDevice, manager.swapchain, UINT64_MAX, frame.imageAcquired,
+			VK_NULL_HANDLE, &manager.imageIndex);
+	}
+
+	if (result == VK_SUBOPTIMAL_KHR)
+	{
+		// The image is still presentable, the swapchain is replaced on the next frame.
+		manager.needsRecreation = true;
+	}
+	else if (result != VK_SUCCESS)
+	{
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			manager.needsRecreation = true;
+		}
+		else
+		{
+			VulkanCheck(result);
+		}
+		return VK_NULL_HANDLE;
+	}
+
+	// The fence is only reset once an image has been acquired, a skipped frame must not leave it unsignaled.
+	VulkanCheck(vkResetFences(backendData.logicalDevice, 1, &frame.inFlight));
+	ResetCommandPool(backendData, frame.commandPool);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VulkanCheck(vkBeginCommandBuffer(frame.commandBuffer, &beginInfo));
+
+	return frame.commandBuffer;
+}
+
+void VulkanBackend::EndSwapchainFrame(const BackendData& backendData, const SurfaceData& surfaceData, SwapchainManager& manager, VkQueue queue)
+{
+	SwapchainFrame& frame = manager.frames[manager.currentFrame];
+	VulkanCheck(vkEndCommandBuffer(frame.commandBuffer));
+
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	VkSemaphore renderFinished = manager.renderFinished[manager.imageIndex];
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = &frame.imageAcquired;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &frame.commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &renderFinished;
+	// The frame command buffers are allocated from pools of the general family, so they are submitted there.
+	VulkanCheck(vkQueueSubmit(backendData.generalQueues[0], 1, &submitInfo, frame.inFlight));
+
+	VkPresentInfoKHR presentInfo{};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.waitSemaphoreCount = 1;
+	presentInfo.pWaitSemaphores = &renderFinished;
+	presentInfo.swapchainCount = 1;
+	presentInfo.pSwapchains = &manager.swapchain;
+	presentInfo.pImageIndices = &manager.imageIndex;
+
+	const uint64_t nextPresentId = manager.presentId + 1;
+#ifdef VK_KHR_present_id
+	VkPresentIdKHR presentId{};
+	presentId.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+	presentId.swapchainCount = 1;
+	presentId.pPresentIds = &nextPresentId;
+	if (IsDeviceExtensionEnabled(backendData, VK_KHR_PRESENT_ID_EXTENSION_NAME))
+	{
+		presentInfo.pNext = &presentId;
+	}
+#endif
+
+	VkResult result = vkQueuePresentKHR(queue, &presentInfo);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+	{
+		manager.needsRecreation = true;
+	}
+	else
+	{
+		VulkanCheck(result);
+	}
+
+	manager.presentId = nextPresentId;
+	manager.currentFrame = (manager.currentFrame + 1) % (uint32_t)manager.frames.size();
+	++manager.frameNumber;
+}
+
+void VulkanBackend::ResizeSwapchain(SurfaceData& surfaceData, SwapchainManager& manager, uint32_t width, uint32_t height)
+{
+	surfaceData.width = width;
+	surfaceData.height = height;
+	manager.needsRecreation = true;
+}
@@ -0,0 +1,387 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include "FileMapping.hpp"
+#include "Formats.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <string.h>
+
+// Data ranges of the file, each one becomes a single copy region.
+struct TextureRegion
+{
+	size_t fileOffset;
+	VkDeviceSize size;
+	uint32_t mipLevel;
+	uint32_t baseLayer;
+	uint32_t layerCount;
+};
+
+struct TextureLayout
+{
+	VkFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t layerCount;
+	uint32_t mipCount;
+	std::vector<TextureRegion> regions;
+};
+
+template<typename T>
+static T ReadValue(const uint8_t* data)
+{
+	// The file data has no alignment guarantees.
+	T value;
+	memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+// ==================================== KTX2 ====================================
+
+static const uint8_t ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static constexpr size_t ktx2HeaderSize = 80;
+static constexpr size_t ktx2LevelIndexEntrySize = 24;
+
+static bool ParseKTX2(const FileMapping::MappedFile& file, TextureLayout& layout)
+{
+	if (file.size < ktx2HeaderSize)
+	{
+		return false;
+	}
+
+	const uint8_t* header = file.data + sizeof(ktx2Identifier);
+	const uint32_t vkFormat = ReadValue<uint32_t>(header);
+	const uint32_t pixelWidth = ReadValue<uint32_t>(header + 8);
+	const uint32_t pixelHeight = ReadValue<uint32_t>(header + 12);
+	const uint32_t pixelDepth = ReadValue<uint32_t>(header + 16);
+	const uint32_t layerCount = ReadValue<uint32_t>(header + 20);
+	const uint32_t faceCount = ReadValue<uint32_t>(header + 24);
+	const uint32_t levelCount = ReadValue<uint32_t>(header + 28);
+	const uint32_t supercompressionScheme = ReadValue<uint32_t>(header + 32);
+
+	if (supercompressionScheme != 0 || vkFormat == VK_FORMAT_UNDEFINED)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Supercompressed KTX2 files are not supported.");
+		return false;
+	}
+	if (pixelDepth > 1 || pixelHeight == 0)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Only 2D KTX2 textures are supported.");
+		return false;
+	}
+
+	layout.format = (VkFormat)vkFormat;
+	layout.width = pixelWidth;
+	layout.height = pixelHeight;
+	layout.layerCount = (std::max)(1u, layerCount) * (std::max)(1u, faceCount);
+	// A zero level count asks for the mips to be generated, only the base level is stored.
+	layout.mipCount = (std::max)(1u, levelCount);
+
+	if (file.size < ktx2HeaderSize + layout.mipCount * ktx2LevelIndexEntrySize)
+	{
+		return false;
+	}
+
+	// Each level stores all its layers and faces together, so one region covers the whole level.
+	const uint8_t* levelIndex = file.data + ktx2HeaderSize;
+	for (uint32_t m = 0; m < layout.mipCount; ++m)
+	{
+		TextureRegion region{};
+		region.fileOffset = (size_t)ReadValue<uint64_t>(levelIndex + m * ktx2LevelIndexEntrySize);
+		region.size = ReadValue<uint64_t>(levelIndex + m * ktx2LevelIndexEntrySize + 8);
+		region.mipLevel = m;
+		region.baseLayer = 0;
+		region.layerCount = layout.layerCount;
+		layout.regions.push_back(region);
+	}
+
+	return true;
+}
+
+// ==================================== DDS =====================================
+
+static constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+{
+	return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+}
+
+static constexpr size_t ddsHeaderSize = 4 + 124;
+static constexpr size_t ddsHeaderDX10Size = 20;
+static constexpr uint32_t ddsPixelFormatFourCC = 0x4;
+static constexpr uint32_t ddsPixelFormatRGB = 0x40;
+static constexpr uint32_t ddsCaps2Cubemap = 0x200;
+static constexpr uint32_t ddsMiscTextureCube = 0x4;
+
+static VkFormat FormatFromDXGI(uint32_t dxgiFormat)
+{
+	switch (dxgiFormat)
+	{
+	case 2: return VK_FORMAT_R32G32B32A32_SFLOAT;
+	case 10: return VK_FORMAT_R16G16B16A16_SFLOAT;
+	case 16: return VK_FORMAT_R32G32_SFLOAT;
+	case 24: return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+	case 26: return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+	case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+	case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+	case 34: return VK_FORMAT_R16G16_SFLOAT;
+	case 41: return VK_FORMAT_R32_SFLOAT;
+	case 49: return VK_FORMAT_R8G8_UNORM;
+	case 54: return VK_FORMAT_R16_SFLOAT;
+	case 61: return VK_FORMAT_R8_UNORM;
+	case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+	case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+	case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+	case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+	case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+	case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+	case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+	case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+	case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+	case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+	case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+	case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+	case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+	case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+	case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+	case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+	default: return VK_FORMAT_UNDEFINED;
+	}
+}
+
+static VkFormat FormatFromDDSPixelFormat(const uint8_t* pixelFormat)
+{
+	const uint32_t flags = ReadValue<uint32_t>(pixelFormat + 4);
+	const uint32_t fourCC = ReadValue<uint32_t>(pixelFormat + 8);
+	const uint32_t bitCount = ReadValue<uint32_t>(pixelFormat + 12);
+	const uint32_t redMask = ReadValue<uint32_t>(pixelFormat + 16);
+
+	if (flags & ddsPixelFormatFourCC)
+	{
+		switch (fourCC)
+		{
+		case MakeFourCC('D', 'X', 'T', '1'): return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case MakeFourCC('D', 'X', 'T', '3'): return VK_FORMAT_BC2_UNORM_BLOCK;
+		case MakeFourCC('D', 'X', 'T', '5'): return VK_FORMAT_BC3_UNORM_BLOCK;
+		case MakeFourCC('A', 'T', 'I', '1'):
+		case MakeFourCC('B', 'C', '4', 'U'): return VK_FORMAT_BC4_UNORM_BLOCK;
+		case MakeFourCC('A', 'T', 'I', '2'):
+		case MakeFourCC('B', 'C', '5', 'U'): return VK_FORMAT_BC5_UNORM_BLOCK;
+		default: return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	if ((flags & ddsPixelFormatRGB) && bitCount == 32)
+	{
+		return redMask == 0x000000FF ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;
+	}
+
+	return VK_FORMAT_UNDEFINED;
+}
+
+static bool ParseDDS(const FileMapping::MappedFile& file, TextureLayout& layout)
+{
+	if (file.size < ddsHeaderSize)
+	{
+		return false;
+	}
+
+	const uint8_t* header = file.data + 4;
+	const uint32_t height = ReadValue<uint32_t>(header + 8);
+	const uint32_t width = ReadValue<uint32_t>(header + 12);
+	const uint32_t mipMapCount = ReadValue<uint32_t>(header + 24);
+	const uint8_t* pixelFormat = header + 72;
+	const uint32_t caps2 = ReadValue<uint32_t>(header + 108);
+
+	size_t dataOffset = ddsHeaderSize;
+	uint32_t layerCount = (caps2 & ddsCaps2Cubemap) ? 6 : 1;
+
+	if ((ReadValue<uint32_t>(pixelFormat + 4) & ddsPixelFormatFourCC) && ReadValue<uint32_t>(pixelFormat + 8) == MakeFourCC('D', 'X', '1', '0'))
+	{
+		if (file.size < ddsHeaderSize + ddsHeaderDX10Size)
+		{
+			return false;
+		}
+
+		const uint8_t* headerDX10 = file.data + ddsHeaderSize;
+		layout.format = FormatFromDXGI(ReadValue<uint32_t>(headerDX10));
+		const uint32_t miscFlag = ReadValue<uint32_t>(headerDX10 + 8);
+		const uint32_t arraySize = (std::max)(1u, ReadValue<uint32_t>(headerDX10 + 12));
+		layerCount = arraySize * ((miscFlag & ddsMiscTextureCube) ? 6 : 1);
+		dataOffset += ddsHeaderDX10Size;
+	}
+	else
+	{
+		layout.format = FormatFromDDSPixelFormat(pixelFormat);
+	}
+
+	Formats::FormatBlock block;
+	if (!Formats::GetFormatBlock(layout.format, block))
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Unsupported DDS pixel format.");
+		return false;
+	}
+
+	layout.width = width;
+	layout.height = height;
+	layout.layerCount = layerCount;
+	layout.mipCount = (std::max)(1u, mipMapCount);
+	if (layout.mipCount > 32)
+	{
+		return false;
+	}
+
+	// Unlike KTX2, the data is stored layer by layer with the full mip chain of each layer.
+	size_t offset = dataOffset;
+	for (uint32_t l = 0; l < layout.layerCount; ++l)
+	{
+		for (uint32_t m = 0; m < layout.mipCount; ++m)
+		{
+			TextureRegion region{};
+			region.fileOffset = offset;
+			region.size = Formats::GetRegionSize(block, (std::max)(1u, width >> m), (std::max)(1u, height >> m));
+			region.mipLevel = m;
+			region.baseLayer = l;
+			region.layerCount = 1;
+			layout.regions.push_back(region);
+
+			offset += (size_t)region.size;
+			if (offset > file.size)
+			{
+				// Crafted layer counts would otherwise build regions far past the end of the file.
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// ================================== Loading ==================================
+
+static void TransitionTextureLayout(VkCommandBuffer commandBuffer, VkImage image, const TextureLayout& layout,
+	VkImageLayout currentLayout, VkImageLayout nextLayout, VkPipelineStageFlags sourceStage, VkPipelineStageFlags destinationStage,
+	VkAccessFlags sourceAccessMask, VkAccessFlags destinationAccessMask)
+{
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = currentLayout;
+	barrier.newLayout = nextLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, layout.mipCount, 0, layout.layerCount };
+	barrier.srcAccessMask = sourceAccessMask;
+	barrier.dstAccessMask = destinationAccessMask;
+
+	vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VulkanBackend::Texture VulkanBackend::LoadTexture(const BackendData& backendData, StagingRing& ring, VkCommandBuffer commandBuffer,
+	const char* path, VkImageUsageFlags usage)
+{
+	Texture texture{};
+
+	FileMapping::MappedFile file;
+	if (!FileMapping::Map(path, file))
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Failed to map texture file %s.", path);
+		return texture;
+	}
+
+	TextureLayout layout{};
+	bool parsed = false;
+	if (file.size >= sizeof(ktx2Identifier) && memcmp(file.data, ktx2Identifier, sizeof(ktx2Identifier)) == 0)
+	{
+		parsed = ParseKTX2(file, layout);
+	}
+	else if (file.size >= 4 && ReadValue<uint32_t>(file.data) == MakeFourCC('D', 'D', 'S', ' '))
+	{
+		parsed = ParseDDS(file, layout);
+	}
+
+	Formats::FormatBlock block;
+	if (parsed && !Formats::GetFormatBlock(layout.format, block))
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Unsupported texture format in %s.", path);
+		parsed = false;
+	}
+
+	// Mip shifts past the size of the base level are invalid, and would be undefined for the shifts below.
+	if (parsed && (layout.width == 0 || layout.height == 0 || layout.mipCount > 32 ||
+		((std::max)(layout.width, layout.height) >> (layout.mipCount - 1)) == 0))
+	{
+		parsed = false;
+	}
+
+	// Truncated files would make the copies below read past the mapping, and short levels would leave the image partly unwritten.
+	for (size_t r = 0; parsed && r < layout.regions.size(); ++r)
+	{
+		const TextureRegion& region = layout.regions[r];
+		const VkDeviceSize expectedSize = Formats::GetRegionSize(block, (std::max)(1u, layout.width >> region.mipLevel),
+			(std::max)(1u, layout.height >> region.mipLevel)) * region.layerCount;
+		parsed = region.fileOffset <= file.size && region.size <= file.size - region.fileOffset && region.size == expectedSize;
+	}
+
+	if (!parsed)
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Failed to parse texture file %s.", path);
+		FileMapping::Unmap(file);
+		return texture;
+	}
+
+	// Buffer offsets of image copies have to be multiples of both the block size and 4.
+	const VkDeviceSize alignment = block.bytes % 4 == 0 ? block.bytes : block.bytes * 4;
+	VkDeviceSize stagingSize = 0;
+	for (auto& region : layout.regions)
+	{
+		stagingSize = (stagingSize + alignment - 1) / alignment * alignment + region.size;
+	}
+
+	VkDeviceSize stagingOffset;
+	if (!AllocateStaging(backendData, ring, stagingSize, alignment, stagingOffset))
+	{
+		FileMapping::Unmap(file);
+		return texture;
+	}
+
+	// The only copy on the CPU, straight from the file pages into the upload memory.
+	std::vector<VkBufferImageCopy> copies(layout.regions.size());
+	VkDeviceSize regionOffset = stagingOffset;
+	for (size_t r = 0; r < layout.regions.size(); ++r)
+	{
+		const TextureRegion& region = layout.regions[r];
+		regionOffset = (regionOffset + alignment - 1) / alignment * alignment;
+		memcpy(ring.data + regionOffset, file.data + region.fileOffset, (size_t)region.size);
+
+		copies[r] = {};
+		copies[r].bufferOffset = regionOffset;
+		copies[r].imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, region.mipLevel, region.baseLayer, region.layerCount };
+		copies[r].imageExtent = { (std::max)(1u, layout.width >> region.mipLevel), (std::max)(1u, layout.height >> region.mipLevel), 1 };
+
+		regionOffset += region.size;
+	}
+
+	FileMapping::Unmap(file);
+
+	texture.image = CreateImage2D(backendData, layout.width, layout.height, layout.layerCount, layout.mipCount,
+		usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT, layout.format, VMA_MEMORY_USAGE_GPU_ONLY);
+	texture.format = layout.format;
+	texture.width = layout.width;
+	texture.height = layout.height;
+	texture.layerCount = layout.layerCount;
+	texture.mipCount = layout.mipCount;
+
+	TransitionTextureLayout(commandBuffer, texture.image.image, layout, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+	CopyBufferToImage(backendData, ring.buffer.buffer, texture.image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, copies);
+	TransitionTextureLayout(commandBuffer, texture.image.image, layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	return texture;
+}
+
+void VulkanBackend::DestroyTexture(const BackendData& backendData, Texture& texture)
+{
+	DestroyImage(backendData, texture.image);
+	texture = {};
+}
@@ -0,0 +1,365 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+static VkExtent2D GetMipExtent(uint32_t width, uint32_t height, uint32_t mip)
+{
+	return { (std::max)(1u, width >> mip), (std::max)(1u, height >> mip) };
+}
+
+static VkDeviceSize GetMipChainSize(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t bytesPerTexel)
+{
+	VkDeviceSize size = 0;
+	for (uint32_t m = 0; m < mipCount; ++m)
+	{
+		VkExtent2D extent = GetMipExtent(width, height, m);
+		size += (VkDeviceSize)extent.width * extent.height * bytesPerTexel;
+	}
+	return size;
+}
+
+#ifdef VK_EXT_host_image_copy
+static void UploadImage2DFromHost(const VulkanBackend::BackendData& backendData, VkImage image, uint32_t width, uint32_t height,
+	uint32_t mipCount, uint32_t bytesPerTexel, const void* data, VkImageLayout finalLayout, VkImageAspectFlags aspect)
+{
+	// The layout change happens on the host as well, so no command buffer is involved at all.
+	VkHostImageLayoutTransitionInfoEXT transition{};
+	transition.sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT;
+	transition.image = image;
+	transition.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	transition.newLayout = finalLayout;
+	transition.subresourceRange = { aspect, 0, mipCount, 0, 1 };
+	VulkanCheck(backendData.transitionImageLayout(backendData.logicalDevice, 1, &transition));
+
+	std::vector<VkMemoryToImageCopyEXT> regions(mipCount);
+	const uint8_t* mipData = (const uint8_t*)data;
+	for (uint32_t m = 0; m < mipCount; ++m)
+	{
+		VkExtent2D extent = GetMipExtent(width, height, m);
+
+		regions[m] = {};
+		regions[m].sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT;
+		regions[m].pHostPointer = mipData;
+		regions[m].imageSubresource = { aspect, m, 0, 1 };
+		regions[m].imageExtent = { extent.width, extent.height, 1 };
+
+		mipData += (VkDeviceSize)extent.width * extent.height * bytesPerTexel;
+	}
+
+	VkCopyMemoryToImageInfoEXT copyInfo{};
+	copyInfo.sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT;
+	copyInfo.dstImage = image;
+	copyInfo.dstImageLayout = finalLayout;
+	copyInfo.regionCount = mipCount;
+	copyInfo.pRegions = regions.data();
+	VulkanCheck(backendData.copyMemoryToImage(backendData.logicalDevice, &copyInfo));
+}
+#endif
+
+VkImageUsageFlags VulkanBackend::GetUploadImageUsage(const BackendData& backendData)
+{
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+#ifdef VK_EXT_host_image_copy
+	if (!backendData.hostImageCopyLayouts.empty())
+	{
+		usage |= VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+	}
+#endif
+	return usage;
+}
+
+bool VulkanBackend::CanUploadImageFromHost(const BackendData& backendData, VkFormat format, VkImageUsageFlags usage, VkImageLayout finalLayout)
+{
+#ifdef VK_EXT_host_image_copy
+	if (!backendData.copyMemoryToImage || !(usage & VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT))
+	{
+		return false;
+	}
+
+	const auto& layouts = backendData.hostImageCopyLayouts;
+	if (std::find(layouts.begin(), layouts.end(), finalLayout) == layouts.end())
+	{
+		return false;
+	}
+
+	VkFormatProperties3 formatProperties3{};
+	formatProperties3.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3;
+
+	VkFormatProperties2 formatProperties2{};
+	formatProperties2.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2;
+	formatProperties2.pNext = &formatProperties3;
+	vkGetPhysicalDeviceFormatProperties2(backendData.physicalDevice, format, &formatProperties2);
+
+	return (formatProperties3.optimalTilingFeatures & VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT) != 0;
+#else
+	return false;
+#endif
+}
+
+void VulkanBackend::UploadImage2D(const BackendData& backendData, VkImage image, VkFormat format, VkImageUsageFlags usage, uint32_t width,
+	uint32_t height, uint32_t mipCount, uint32_t bytesPerTexel, const void* data, VkImageLayout finalLayout, VkImageAspectFlags aspect)
+{
+#ifdef VK_EXT_host_image_copy
+	if (CanUploadImageFromHost(backendData, format, usage, finalLayout))
+	{
+		UploadImage2DFromHost(backendData, image, width, height, mipCount, bytesPerTexel, data, finalLayout, aspect);
+		return;
+	}
+#endif
+
+	UploadImage2DStaged(backendData, image, width, height, mipCount, bytesPerTexel, data, finalLayout, aspect);
+}
+
+void VulkanBackend::UploadImage2DStaged(const BackendData& backendData, VkImage image, uint32_t width, uint32_t height, uint32_t mipCount,
+	uint32_t bytesPerTexel, const void* data, VkImageLayout finalLayout, VkImageAspectFlags aspect)
+{
+	const VkDeviceSize size = GetMipChainSize(width, height, mipCount, bytesPerTexel);
+
+	Buffer stagingBuffer = CreateBuffer(backendData, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size, VMA_MEMORY_USAGE_CPU_ONLY);
+
+	void* stagingData;
+	VulkanCheck(vmaMapMemory(backendData.allocator, stagingBuffer.allocation, &stagingData));
+	memcpy(stagingData, data, size);
+	vmaUnmapMemory(backendData.allocator, stagingBuffer.allocation);
+
+	std::vector<VkBufferImageCopy> regions(mipCount);
+	VkDeviceSize offset = 0;
+	for (uint32_t m = 0; m < mipCount; ++m)
+	{
+		VkExtent2D extent = GetMipExtent(width, height, m);
+
+		regions[m] = {};
+		regions[m].bufferOffset = offset;
+		regions[m].imageSubresource = { aspect, m, 0, 1 };
+		regions[m].imageExtent = { extent.width, extent.height, 1 };
+
+		offset += (VkDeviceSize)extent.width * extent.height * bytesPerTexel;
+	}
+
+	VkCommandBuffer commandBuffer = AllocateCommandBuffer(backendData, backendData.generalCommandPool);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VulkanCheck(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+	TransitionImageLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, image, mipCount,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, aspect, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		(uint32_t)regions.size(), regions.data());
+	TransitionImageLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout, image, mipCount,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, aspect, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT);
+
+	VulkanCheck(vkEndCommandBuffer(commandBuffer));
+
+	VkFence fence = CreateFence(backendData);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	VulkanCheck(vkQueueSubmit(backendData.generalQueues[0], 1, &submitInfo, fence));
+	VulkanCheck(vkWaitForFences(backendData.logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX));
+
+	DestroyFence(backendData, fence);
+	FreeCommandBuffer(backendData, backendData.generalCommandPool, commandBuffer);
+	DestroyBuffer(backendData, stagingBuffer);
+}
+
+VulkanBackend::ImageUploadBenchmark VulkanBackend::BenchmarkImageUpload(const BackendData& backendData, uint32_t width, uint32_t height,
+	uint32_t iterations)
+{
+	const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+	const VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	std::vector<uint32_t> texels((size_t)width * height);
+	for (size_t t = 0; t < texels.size(); ++t)
+	{
+		texels[t] = (uint32_t)(t * 2654435761u);
+	}
+
+	ImageUploadBenchmark benchmark{};
+	const VkImageUsageFlags usage = GetUploadImageUsage(backendData) | VK_IMAGE_USAGE_SAMPLED_BIT;
+	benchmark.hostCopyAvailable = CanUploadImageFromHost(backendData, format, usage, finalLayout);
+
+	Image image = CreateImage2D(backendData, width, height, 1, 1, usage, format, VMA_MEMORY_USAGE_GPU_ONLY);
+
+	// Every upload starts from the undefined layout, so the same image can be reused for all the iterations.
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		UploadImage2DStaged(backendData, image.image, width, height, 1, 4, texels.data(), finalLayout);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	benchmark.stagedMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / (std::max)(1u, iterations);
+
+	if (benchmark.hostCopyAvailable)
+	{
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			UploadImage2D(backendData, image.image, format, usage, width, height, 1, 4, texels.data(), finalLayout);
+		}
+		end = std::chrono::high_resolution_clock::now();
+		benchmark.hostCopyMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / (std::max)(1u, iterations);
+	}
+
+	DestroyImage(backendData, image);
+
+	return benchmark;
+}
+
+static bool ImportHostMemory(const VulkanBackend::BackendData& backendData, VkBufferUsageFlags usage, void* hostPointer, VkDeviceSize size,
+	VulkanBackend::Buffer& buffer)
+{
+	const VkDeviceSize alignment = backendData.minImportedHostPointerAlignment;
+	if (alignment == 0 || !backendData.getMemoryHostPointerProperties)
+	{
+		return false;
+	}
+
+	// The imported range has to be aligned at both ends, the buffer is then bound at the offset of the pointer inside it.
+	const uintptr_t address = (uintptr_t)hostPointer;
+	const uintptr_t importAddress = address / alignment * alignment;
+	const VkDeviceSize memoryOffset = address - importAddress;
+	const VkDeviceSize importSize = (memoryOffset + size + alignment - 1) / alignment * alignment;
+
+	VkMemoryHostPointerPropertiesEXT hostPointerProperties{};
+	hostPointerProperties.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+	if (backendData.getMemoryHostPointerProperties(backendData.logicalDevice, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+		(void*)importAddress, &hostPointerProperties) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	VkExternalMemoryBufferCreateInfo externalMemoryBufferCreateInfo{};
+	externalMemoryBufferCreateInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+	externalMemoryBufferCreateInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+	VkBufferCreateInfo bufferCreateInfo{};
+	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferCreateInfo.pNext = &externalMemoryBufferCreateInfo;
+	bufferCreateInfo.usage = usage;
+	bufferCreateInfo.size = size;
+	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer importedBuffer;
+	if (vkCreateBuffer(backendData.logicalDevice, &bufferCreateInfo, nullptr, &importedBuffer) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetBufferMemoryRequirements(backendData.logicalDevice, importedBuffer, &memoryRequirements);
+
+	const uint32_t memoryTypeBits = memoryRequirements.memoryTypeBits & hostPointerProperties.memoryTypeBits;
+	if (memoryTypeBits == 0 || memoryOffset % memoryRequirements.alignment != 0 || memoryOffset + memoryRequirements.size > importSize)
+	{
+		vkDestroyBuffer(backendData.logicalDevice, importedBuffer, nullptr);
+		return false;
+	}
+
+	uint32_t memoryTypeIndex = 0;
+	while (!(memoryTypeBits & (1u << memoryTypeIndex)))
+	{
+		++memoryTypeIndex;
+	}
+
+	VkImportMemoryHostPointerInfoEXT importInfo{};
+	importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+	importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+	importInfo.pHostPointer = (void*)importAddress;
+
+	// Device addresses of the buffer need the memory to be allocated with the matching flag.
+	VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo{};
+	memoryAllocateFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+	memoryAllocateFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+	if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+	{
+		importInfo.pNext = &memoryAllocateFlagsInfo;
+	}
+
+	VkMemoryAllocateInfo memoryAllocateInfo{};
+	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocateInfo.pNext = &importInfo;
+	memoryAllocateInfo.allocationSize = importSize;
+	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory importedMemory;
+	if (vkAllocateMemory(backendData.logicalDevice, &memoryAllocateInfo, nullptr, &importedMemory) != VK_SUCCESS)
+	{
+		vkDestroyBuffer(backendData.logicalDevice, importedBuffer, nullptr);
+		return false;
+	}
+
+	VulkanCheck(vkBindBufferMemory(backendData.logicalDevice, importedBuffer, importedMemory, memoryOffset));
+
+	buffer.buffer = importedBuffer;
+	buffer.allocation = VK_NULL_HANDLE;
+	buffer.importedMemory = importedMemory;
+	if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+	{
+		buffer.deviceAddress = VulkanBackend::GetBufferDeviceAddress(backendData, importedBuffer);
+	}
+	return true;
+}
+
+static void UploadBufferStaged(const VulkanBackend::BackendData& backendData, VkBuffer destination, const void* data, VkDeviceSize size)
+{
+	// The staging buffer is bounded, large uploads go through it in chunks.
+	const VkDeviceSize chunkCapacity = (std::min)(size, (VkDeviceSize)64 * 1024 * 1024);
+
+	VulkanBackend::Buffer stagingBuffer = VulkanBackend::CreateBuffer(backendData, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, chunkCapacity,
+		VMA_MEMORY_USAGE_CPU_ONLY);
+
+	uint8_t* stagingData;
+	VulkanCheck(vmaMapMemory(backendData.allocator, stagingBuffer.allocation, (void**)&stagingData));
+
+	VkCommandBuffer commandBuffer = VulkanBackend::AllocateCommandBuffer(backendData, backendData.generalCommandPool);
+	VkFence fence = VulkanBackend::CreateFence(backendData);
+
+	for (VkDeviceSize offset = 0; offset < size; offset += chunkCapacity)
+	{
+		const VkDeviceSize chunkSize = (std::min)(chunkCapacity, size - offset);
+		memcpy(stagingData, (const uint8_t*)data + offset, (size_t)chunkSize);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VulkanCheck(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+		VulkanBackend::CopyBufferToBuffer(backendData, stagingBuffer.buffer, destination, chunkSize, commandBuffer, 0, offset);
+		VulkanCheck(vkEndCommandBuffer(commandBuffer));
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		VulkanCheck(vkQueueSubmit(backendData.generalQueues[0], 1, &submitInfo, fence));
+		VulkanCheck(vkWaitForFences(backendData.logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX));
+		VulkanCheck(vkResetFences(backendData.logicalDevice, 1, &fence));
+	}
+
+	VulkanBackend::DestroyFence(backendData, fence);
+	VulkanBackend::FreeCommandBuffer(backendData, backendData.generalCommandPool, commandBuffer);
+	vmaUnmapMemory(backendData.allocator, stagingBuffer.allocation);
+	VulkanBackend::DestroyBuffer(backendData, stagingBuffer);
+}
+
+VulkanBackend::Buffer VulkanBackend::CreateBufferFromHostMemory(const BackendData& backendData, VkBufferUsageFlags usage, void* hostPointer,
+	VkDeviceSize size)
+{
+	Buffer buffer;
+	if (ImportHostMemory(backendData, usage, hostPointer, size, buffer))
+	{
+		return buffer;
+	}
+
+	CoreLogInfo(DefaultLogger, "Vulkan backend: Host memory import not possible, the buffer is uploaded through staging.");
+
+	buffer = CreateBuffer(backendData, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, size, VMA_MEMORY_USAGE_GPU_ONLY);
+	UploadBufferStaged(backendData, buffer.buffer, hostPointer, size);
+	return buffer;
+}
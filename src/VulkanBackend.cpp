@@ -4,6 +4,7 @@
 #include <SoftwareCore/DefaultLogger.hpp>
 #include <vulkan/vulkan.hpp>
 #include <yaml-cpp/yaml.h>
+#include <algorithm>
 
 VKAPI_ATTR VkBool32 VKAPI_CALL ValidationCallback(
 	VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -13,6 +14,91 @@ VKAPI_ATTR VkBool32 VKAPI_CALL ValidationCallback(
 
 void DestroyInstance(VulkanBackend::BackendData& backendData);
 
+static bool ContainsExtension(const std::vector<std::string>& extensions, const std::string& extension)
+{
+	return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+static bool ContainsExtension(const std::vector<VkExtensionProperties>& extensions, const std::string& extension)
+{
+	for (auto& extensionProperties : extensions)
+	{
+		if (extension == extensionProperties.extensionName)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool AnyFeatureEnabled(const VkPhysicalDeviceVulkan12Features& features)
+{
+	const VkBool32 featureValues[] =
+	{
+		features.samplerMirrorClampToEdge,
+		features.drawIndirectCount,
+		features.storageBuffer8BitAccess,
+		features.uniformAndStorageBuffer8BitAccess,
+		features.storagePushConstant8,
+		features.shaderBufferInt64Atomics,
+		features.shaderSharedInt64Atomics,
+		features.shaderFloat16,
+		features.shaderInt8,
+		features.descriptorIndexing,
+		features.shaderInputAttachmentArrayDynamicIndexing,
+		features.shaderUniformTexelBufferArrayDynamicIndexing,
+		features.shaderStorageTexelBufferArrayDynamicIndexing,
+		features.shaderUniformBufferArrayNonUniformIndexing,
+		features.shaderSampledImageArrayNonUniformIndexing,
+		features.shaderStorageBufferArrayNonUniformIndexing,
+		features.shaderStorageImageArrayNonUniformIndexing,
+		features.shaderInputAttachmentArrayNonUniformIndexing,
+		features.shaderUniformTexelBufferArrayNonUniformIndexing,
+		features.shaderStorageTexelBufferArrayNonUniformIndexing,
+		features.descriptorBindingUniformBufferUpdateAfterBind,
+		features.descriptorBindingSampledImageUpdateAfterBind,
+		features.descriptorBindingStorageImageUpdateAfterBind,
+		features.descriptorBindingStorageBufferUpdateAfterBind,
+		features.descriptorBindingUniformTexelBufferUpdateAfterBind,
+		features.descriptorBindingStorageTexelBufferUpdateAfterBind,
+		features.descriptorBindingUpdateUnusedWhilePending,
+		features.descriptorBindingPartiallyBound,
+		features.descriptorBindingVariableDescriptorCount,
+		features.runtimeDescriptorArray,
+		features.samplerFilterMinmax,
+		features.scalarBlockLayout,
+		features.imagelessFramebuffer,
+		features.uniformBufferStandardLayout,
+		features.shaderSubgroupExtendedTypes,
+		features.separateDepthStencilLayouts,
+		features.hostQueryReset,
+		features.timelineSemaphore,
+		features.bufferDeviceAddress,
+		features.bufferDeviceAddressCaptureReplay,
+		features.bufferDeviceAddressMultiDevice,
+		features.vulkanMemoryModel,
+		features.vulkanMemoryModelDeviceScope,
+		features.vulkanMemoryModelAvailabilityVisibilityChains,
+		features.shaderOutputViewportIndex,
+		features.shaderOutputLayer,
+		features.subgroupBroadcastDynamicId,
+	};
+	for (VkBool32 feature : featureValues)
+	{
+		if (feature)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void ChainFeatures(void**& tail, void* features)
+{
+	*tail = features;
+	tail = &((VkBaseOutStructure*)features)->pNext;
+}
+
 VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 {
 	// TODO: Allocator.
@@ -58,6 +144,30 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 				extensions.push_back(extensionsData[e].as<std::string>());
 			}
 		}
+		// Optional extensions are only enabled when the instance supports them.
+		auto optionalExtensionsData = configData["Instance"]["optional-extensions"];
+		if (optionalExtensionsData)
+		{
+			uint32_t availableExtensionCount;
+			VulkanCheck(vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionCount, nullptr));
+
+			std::vector<VkExtensionProperties> availableExtensions(availableExtensionCount);
+			VulkanCheck(vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionCount, availableExtensions.data()));
+
+			for (int e = 0; e < optionalExtensionsData.size(); ++e)
+			{
+				std::string extension = optionalExtensionsData[e].as<std::string>();
+				if (ContainsExtension(availableExtensions, extension))
+				{
+					hasExtensions = true;
+					extensions.push_back(extension);
+				}
+				else
+				{
+					CoreLogInfo(DefaultLogger, "Configuration: Optional instance extension %s is not available.", extension.c_str());
+				}
+			}
+		}
 		// Retrieving layers.
 		bool hasLayers = false;
 		auto layersData = configData["Instance"]["validation-layers"];
@@ -118,6 +228,7 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 
 	// Creating Vulkan instance.
 	VulkanCheck(vkCreateInstance(&instanceCreateInfo, nullptr, &backendData.instance));
+	backendData.enabledInstanceExtensions = extensions;
 
 	if (!backendData.instance)
 	{
@@ -170,18 +281,13 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 		}
 	}
 
-	// Converting device extensions to const char*.
-	std::vector<const char*> deviceExtensionsChar(deviceExtensions.size());
-	for (int e = 0; e < deviceExtensions.size(); ++e)
-	{
-		deviceExtensionsChar[e] = deviceExtensions[e].c_str();
-	}
-
 	// The chosen device and its features and properties.
 	VkPhysicalDeviceProperties pickedDeviceProperties{};
 	VkPhysicalDeviceFeatures pickedDeviceFeatures{};
 
-	VkPhysicalDeviceFeatures enabledFeatures;
+	VkPhysicalDeviceFeatures enabledFeatures{};
+	VkPhysicalDeviceVulkan12Features enabledFeatures12{};
+	enabledFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
 
 	std::vector<std::vector<int>> outputIndices;
 	std::vector<std::map<std::string, int>> indexMappings;
@@ -221,6 +327,7 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 		}
 
 		enabledFeatures = Configurator::FeaturesFromString(requiredFeatures);
+		enabledFeatures12 = Configurator::Features12FromString(requiredFeatures);
 
 
 		std::vector<std::vector<VkQueueFamilyProperties>> queueProperties(deviceCount);
@@ -230,6 +337,7 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 
 		std::vector<VkPhysicalDeviceProperties> deviceProperties(deviceCount);
 		std::vector<VkPhysicalDeviceFeatures> deviceFeatures(deviceCount);
+		std::vector<VkPhysicalDeviceVulkan12Features> deviceFeatures12(deviceCount);
 		std::string preferredName = "";
 		bool foundPreferredDevice = true;
 		if (configData["Device"]["preferred"])
@@ -244,6 +352,18 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 			vkGetPhysicalDeviceProperties(devices[d], &deviceProperties[d]);
 			vkGetPhysicalDeviceFeatures(devices[d], &deviceFeatures[d]);
 
+			// Vulkan 1.2 features can only be queried from devices supporting that version.
+			deviceFeatures12[d] = {};
+			deviceFeatures12[d].sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			if (deviceProperties[d].apiVersion >= VK_API_VERSION_1_2)
+			{
+				VkPhysicalDeviceFeatures2 deviceFeatures2{};
+				deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+				deviceFeatures2.pNext = &deviceFeatures12[d];
+				vkGetPhysicalDeviceFeatures2(devices[d], &deviceFeatures2);
+				deviceFeatures12[d].pNext = nullptr;
+			}
+
 			uint32_t familyCount;
 			vkGetPhysicalDeviceQueueFamilyProperties(devices[d], &familyCount, NULL);
 			queueProperties[d].resize(familyCount);
@@ -256,7 +376,7 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 				if (deviceProperties[d].apiVersion >= vulkanApplicationInfo.apiVersion)
 				{
 					// If the requested API version is supported by the device, checking required features support.
-					if (Configurator::CheckFeaturesPresent(deviceFeatures[d], deviceProperties[d], requiredFeatures) &&
+					if (Configurator::CheckFeaturesPresent(deviceFeatures[d], deviceFeatures12[d], deviceProperties[d], requiredFeatures) &&
 						Configurator::CheckQueueSupport(configData["Device"]["queues"], queueProperties[d], outputIndices[d], indexMappings[d]))
 					{
 						// In this case, we found the preferred device and it fits the requirements.
@@ -309,9 +429,11 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 			std::vector<VkPhysicalDevice> preferredDevices;
 			std::vector<VkPhysicalDeviceProperties> preferredDevicesProperties;
 			std::vector<VkPhysicalDeviceFeatures> preferredDevicesFeatures;
+			std::vector<VkPhysicalDeviceVulkan12Features> preferredDevicesFeatures12;
 			std::vector<VkPhysicalDevice> otherDevices;
 			std::vector<VkPhysicalDeviceProperties> otherDevicesProperties;
 			std::vector<VkPhysicalDeviceFeatures> otherDevicesFeatures;
+			std::vector<VkPhysicalDeviceVulkan12Features> otherDevicesFeatures12;
 
 			for (int d = 0; d < devices.size(); ++d)
 			{
@@ -322,12 +444,14 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 						preferredDevices.push_back(devices[d]);
 						preferredDevicesProperties.push_back(deviceProperties[d]);
 						preferredDevicesFeatures.push_back(deviceFeatures[d]);
+						preferredDevicesFeatures12.push_back(deviceFeatures12[d]);
 					}
 					else
 					{
 						otherDevices.push_back(devices[d]);
 						otherDevicesProperties.push_back(deviceProperties[d]);
 						otherDevicesFeatures.push_back(deviceFeatures[d]);
+						otherDevicesFeatures12.push_back(deviceFeatures12[d]);
 					}
 				}
 			}
@@ -337,7 +461,8 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 			{
 				if (preferredDevicesProperties[d].apiVersion >= vulkanApplicationInfo.apiVersion)
 				{
-					if (Configurator::CheckFeaturesPresent(preferredDevicesFeatures[d], preferredDevicesProperties[d], requiredFeatures) &&
+					if (Configurator::CheckFeaturesPresent(preferredDevicesFeatures[d], preferredDevicesFeatures12[d], preferredDevicesProperties[d],
+						requiredFeatures) &&
 						Configurator::CheckQueueSupport(configData["Device"]["queues"], queueProperties[d], outputIndices[d], indexMappings[d]))
 					{
 						backendData.physicalDevice = preferredDevices[d];
@@ -362,7 +487,8 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 				{
 					if (otherDevicesProperties[d].apiVersion >= vulkanApplicationInfo.apiVersion)
 					{
-						if (Configurator::CheckFeaturesPresent(otherDevicesFeatures[d], otherDevicesProperties[d], requiredFeatures) &&
+						if (Configurator::CheckFeaturesPresent(otherDevicesFeatures[d], otherDevicesFeatures12[d], otherDevicesProperties[d],
+							requiredFeatures) &&
 							Configurator::CheckQueueSupport(configData["Device"]["queues"], queueProperties[d], outputIndices[d], indexMappings[d]))
 						{
 							backendData.physicalDevice = otherDevices[d];
@@ -387,6 +513,87 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 		}
 	}
 
+	// Optional extensions are only enabled when the picked device supports them.
+	auto optionalExtensionsData = configData["Device"]["optional-extensions"];
+	if (optionalExtensionsData)
+	{
+		uint32_t availableExtensionCount;
+		VulkanCheck(vkEnumerateDeviceExtensionProperties(backendData.physicalDevice, nullptr, &availableExtensionCount, nullptr));
+
+		std::vector<VkExtensionProperties> availableExtensions(availableExtensionCount);
+		VulkanCheck(vkEnumerateDeviceExtensionProperties(backendData.physicalDevice, nullptr, &availableExtensionCount, availableExtensions.data()));
+
+		for (int e = 0; e < optionalExtensionsData.size(); ++e)
+		{
+			std::string extension = optionalExtensionsData[e].as<std::string>();
+			if (ContainsExtension(availableExtensions, extension))
+			{
+				deviceExtensions.push_back(extension);
+			}
+			else
+			{
+				CoreLogInfo(DefaultLogger, "Configuration: Optional device extension %s is not available.", extension.c_str());
+			}
+		}
+	}
+
+#ifdef VK_KHR_present_wait
+	// Present wait is optional even on devices exposing the extensions, both are dropped if the features are missing.
+	if (ContainsExtension(deviceExtensions, VK_KHR_PRESENT_ID_EXTENSION_NAME) || ContainsExtension(deviceExtensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+	{
+		VkPhysicalDevicePresentWaitFeaturesKHR supportedPresentWaitFeatures{};
+		supportedPresentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+		VkPhysicalDevicePresentIdFeaturesKHR supportedPresentIdFeatures{};
+		supportedPresentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+		supportedPresentIdFeatures.pNext = &supportedPresentWaitFeatures;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures2{};
+		supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures2.pNext = &supportedPresentIdFeatures;
+		vkGetPhysicalDeviceFeatures2(backendData.physicalDevice, &supportedFeatures2);
+
+		if (!supportedPresentIdFeatures.presentId)
+		{
+			CoreLogInfo(DefaultLogger, "Configuration: Present id is not supported by the device.");
+			deviceExtensions.erase(std::remove(deviceExtensions.begin(), deviceExtensions.end(), VK_KHR_PRESENT_ID_EXTENSION_NAME), deviceExtensions.end());
+		}
+		if (!supportedPresentIdFeatures.presentId || !supportedPresentWaitFeatures.presentWait)
+		{
+			CoreLogInfo(DefaultLogger, "Configuration: Present wait is not supported by the device.");
+			deviceExtensions.erase(std::remove(deviceExtensions.begin(), deviceExtensions.end(), VK_KHR_PRESENT_WAIT_EXTENSION_NAME), deviceExtensions.end());
+		}
+	}
+#endif
+
+#ifdef VK_EXT_graphics_pipeline_library
+	// Graphics pipeline libraries are optional even on devices exposing the extension.
+	if (ContainsExtension(deviceExtensions, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supportedLibraryFeatures{};
+		supportedLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures2{};
+		supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures2.pNext = &supportedLibraryFeatures;
+		vkGetPhysicalDeviceFeatures2(backendData.physicalDevice, &supportedFeatures2);
+
+		if (!supportedLibraryFeatures.graphicsPipelineLibrary || !ContainsExtension(deviceExtensions, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME))
+		{
+			CoreLogInfo(DefaultLogger, "Configuration: Graphics pipeline libraries are not supported by the device.");
+			deviceExtensions.erase(std::remove(deviceExtensions.begin(), deviceExtensions.end(), VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME),
+				deviceExtensions.end());
+		}
+	}
+#endif
+
+	// Converting device extensions to const char*.
+	std::vector<const char*> deviceExtensionsChar(deviceExtensions.size());
+	for (int e = 0; e < deviceExtensions.size(); ++e)
+	{
+		deviceExtensionsChar[e] = deviceExtensions[e].c_str();
+	}
+
 	// TODO: Figure out priorities.
 	std::vector<float> queuePriorities;
 	int maxCount = 1;
@@ -427,9 +634,110 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 		}
 	}
 	
+	// Extension features are chained behind VkPhysicalDeviceFeatures2, which then carries the core features as well.
+	VkPhysicalDeviceFeatures2 enabledFeatures2{};
+	enabledFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	enabledFeatures2.features = enabledFeatures;
+	void** featureChainTail = &enabledFeatures2.pNext;
+
+	if (AnyFeatureEnabled(enabledFeatures12))
+	{
+		ChainFeatures(featureChainTail, &enabledFeatures12);
+	}
+
+#ifdef VK_EXT_host_image_copy
+	VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures{};
+	hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+	if (ContainsExtension(deviceExtensions, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME))
+	{
+		// The main feature of this and the following extensions is mandatory for devices exposing the extension.
+		hostImageCopyFeatures.hostImageCopy = VK_TRUE;
+		ChainFeatures(featureChainTail, &hostImageCopyFeatures);
+	}
+#endif
+
+#ifdef VK_KHR_dynamic_rendering
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	if (ContainsExtension(deviceExtensions, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+	{
+		dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+		ChainFeatures(featureChainTail, &dynamicRenderingFeatures);
+	}
+#endif
+
+	VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures{};
+	extendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+	if (ContainsExtension(deviceExtensions, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+	{
+		extendedDynamicStateFeatures.extendedDynamicState = VK_TRUE;
+		ChainFeatures(featureChainTail, &extendedDynamicStateFeatures);
+	}
+
+#ifdef VK_EXT_extended_dynamic_state2
+	VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2Features{};
+	extendedDynamicState2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+	if (ContainsExtension(deviceExtensions, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME))
+	{
+		extendedDynamicState2Features.extendedDynamicState2 = VK_TRUE;
+		ChainFeatures(featureChainTail, &extendedDynamicState2Features);
+	}
+#endif
+
+#ifdef VK_EXT_extended_dynamic_state3
+	// Each of the states is an optional feature of its own, all the supported ones are enabled.
+	VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features{};
+	extendedDynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+	if (ContainsExtension(deviceExtensions, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceFeatures2 supportedFeatures2{};
+		supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures2.pNext = &extendedDynamicState3Features;
+		vkGetPhysicalDeviceFeatures2(backendData.physicalDevice, &supportedFeatures2);
+
+		extendedDynamicState3Features.pNext = nullptr;
+		ChainFeatures(featureChainTail, &extendedDynamicState3Features);
+	}
+#endif
+
+#ifdef VK_EXT_graphics_pipeline_library
+	VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures{};
+	graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+	if (ContainsExtension(deviceExtensions, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+	{
+		graphicsPipelineLibraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+		ChainFeatures(featureChainTail, &graphicsPipelineLibraryFeatures);
+	}
+#endif
+
+#ifdef VK_KHR_present_wait
+	VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+	presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+	if (ContainsExtension(deviceExtensions, VK_KHR_PRESENT_ID_EXTENSION_NAME))
+	{
+		presentIdFeatures.presentId = VK_TRUE;
+		ChainFeatures(featureChainTail, &presentIdFeatures);
+	}
+
+	VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+	presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+	if (ContainsExtension(deviceExtensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+	{
+		presentWaitFeatures.presentWait = VK_TRUE;
+		ChainFeatures(featureChainTail, &presentWaitFeatures);
+	}
+#endif
+
 	VkDeviceCreateInfo deviceCreateInfo{};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-	deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+	if (enabledFeatures2.pNext)
+	{
+		deviceCreateInfo.pNext = &enabledFeatures2;
+	}
+	else
+	{
+		deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+	}
 	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensionsChar.data();
 	deviceCreateInfo.enabledExtensionCount = (uint32_t)deviceExtensionsChar.size();
 	deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfos.data();
@@ -437,6 +745,141 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 
 	VulkanCheck(vkCreateDevice(backendData.physicalDevice, &deviceCreateInfo, nullptr, &backendData.logicalDevice));
 
+	// Keeping the device limits and enabled features around for the subsystems that depend on them.
+	backendData.deviceProperties = pickedDeviceProperties;
+	backendData.enabledFeatures = enabledFeatures;
+	backendData.enabledFeatures12 = enabledFeatures12;
+	backendData.enabledFeatures12.pNext = nullptr;
+	backendData.enabledDeviceExtensions = deviceExtensions;
+
+#ifdef VK_EXT_host_image_copy
+	if (IsDeviceExtensionEnabled(backendData, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME))
+	{
+		// The layouts the host can copy into are queried once, the upload path checks them on every copy.
+		VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProperties{};
+		hostImageCopyProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT;
+
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &hostImageCopyProperties;
+		vkGetPhysicalDeviceProperties2(backendData.physicalDevice, &properties2);
+
+		backendData.hostImageCopyLayouts.resize(hostImageCopyProperties.copyDstLayoutCount);
+		hostImageCopyProperties.pCopyDstLayouts = backendData.hostImageCopyLayouts.data();
+		vkGetPhysicalDeviceProperties2(backendData.physicalDevice, &properties2);
+
+		backendData.transitionImageLayout = reinterpret_cast<PFN_vkTransitionImageLayoutEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkTransitionImageLayoutEXT"));
+		backendData.copyMemoryToImage = reinterpret_cast<PFN_vkCopyMemoryToImageEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCopyMemoryToImageEXT"));
+	}
+#endif
+
+#ifdef VK_KHR_dynamic_rendering
+	if (IsDeviceExtensionEnabled(backendData, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+	{
+		backendData.cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdBeginRenderingKHR"));
+		backendData.cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdEndRenderingKHR"));
+	}
+#endif
+
+	// Extended dynamic states are set on every draw, so their entry points are fetched once.
+	auto& dynamicStateFunctions = backendData.extendedDynamicStateFunctions;
+	if (IsDeviceExtensionEnabled(backendData, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+	{
+		dynamicStateFunctions.setCullMode = reinterpret_cast<PFN_vkCmdSetCullModeEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetCullModeEXT"));
+		dynamicStateFunctions.setFrontFace = reinterpret_cast<PFN_vkCmdSetFrontFaceEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetFrontFaceEXT"));
+		dynamicStateFunctions.setPrimitiveTopology = reinterpret_cast<PFN_vkCmdSetPrimitiveTopologyEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetPrimitiveTopologyEXT"));
+		dynamicStateFunctions.setDepthTestEnable = reinterpret_cast<PFN_vkCmdSetDepthTestEnableEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetDepthTestEnableEXT"));
+		dynamicStateFunctions.setDepthWriteEnable = reinterpret_cast<PFN_vkCmdSetDepthWriteEnableEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetDepthWriteEnableEXT"));
+		dynamicStateFunctions.setDepthCompareOp = reinterpret_cast<PFN_vkCmdSetDepthCompareOpEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetDepthCompareOpEXT"));
+		dynamicStateFunctions.setStencilTestEnable = reinterpret_cast<PFN_vkCmdSetStencilTestEnableEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetStencilTestEnableEXT"));
+
+		backendData.extendedDynamicStates.insert(backendData.extendedDynamicStates.end(),
+		{
+			VK_DYNAMIC_STATE_CULL_MODE_EXT,
+			VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+			VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT,
+			VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+			VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+			VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT,
+			VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT
+		});
+	}
+
+#ifdef VK_EXT_extended_dynamic_state2
+	if (IsDeviceExtensionEnabled(backendData, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME))
+	{
+		dynamicStateFunctions.setRasterizerDiscardEnable = reinterpret_cast<PFN_vkCmdSetRasterizerDiscardEnableEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetRasterizerDiscardEnableEXT"));
+		dynamicStateFunctions.setDepthBiasEnable = reinterpret_cast<PFN_vkCmdSetDepthBiasEnableEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetDepthBiasEnableEXT"));
+		dynamicStateFunctions.setPrimitiveRestartEnable = reinterpret_cast<PFN_vkCmdSetPrimitiveRestartEnableEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetPrimitiveRestartEnableEXT"));
+
+		backendData.extendedDynamicStates.insert(backendData.extendedDynamicStates.end(),
+		{
+			VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE_EXT,
+			VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT,
+			VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT
+		});
+	}
+#endif
+
+#ifdef VK_EXT_extended_dynamic_state3
+	if (IsDeviceExtensionEnabled(backendData, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME))
+	{
+		if (extendedDynamicState3Features.extendedDynamicState3PolygonMode)
+		{
+			dynamicStateFunctions.setPolygonMode = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(
+				vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetPolygonModeEXT"));
+			backendData.extendedDynamicStates.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+		}
+		if (extendedDynamicState3Features.extendedDynamicState3RasterizationSamples)
+		{
+			dynamicStateFunctions.setRasterizationSamples = reinterpret_cast<PFN_vkCmdSetRasterizationSamplesEXT>(
+				vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetRasterizationSamplesEXT"));
+			backendData.extendedDynamicStates.push_back(VK_DYNAMIC_STATE_RASTERIZATION_SAMPLES_EXT);
+		}
+		if (extendedDynamicState3Features.extendedDynamicState3ColorBlendEnable)
+		{
+			dynamicStateFunctions.setColorBlendEnable = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(
+				vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetColorBlendEnableEXT"));
+			backendData.extendedDynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+		}
+		if (extendedDynamicState3Features.extendedDynamicState3ColorWriteMask)
+		{
+			dynamicStateFunctions.setColorWriteMask = reinterpret_cast<PFN_vkCmdSetColorWriteMaskEXT>(
+				vkGetDeviceProcAddr(backendData.logicalDevice, "vkCmdSetColorWriteMaskEXT"));
+			backendData.extendedDynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT);
+		}
+	}
+#endif
+
+	if (IsDeviceExtensionEnabled(backendData, VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceExternalMemoryHostPropertiesEXT externalMemoryHostProperties{};
+		externalMemoryHostProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &externalMemoryHostProperties;
+		vkGetPhysicalDeviceProperties2(backendData.physicalDevice, &properties2);
+
+		backendData.minImportedHostPointerAlignment = externalMemoryHostProperties.minImportedHostPointerAlignment;
+		backendData.getMemoryHostPointerProperties = reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(
+			vkGetDeviceProcAddr(backendData.logicalDevice, "vkGetMemoryHostPointerPropertiesEXT"));
+	}
+
 	std::vector<int> currentQueues(outputIndices[deviceIndex].size());
 
 	backendData.generalQueues.resize(configData["Device"]["queues"]["general"].as<int>());
@@ -501,6 +944,10 @@ VulkanBackend::BackendData VulkanBackend::Initialize(const char* configFilePath)
 	allocatorInfo.physicalDevice = backendData.physicalDevice;
 	allocatorInfo.device = backendData.logicalDevice;
 	allocatorInfo.instance = backendData.instance;
+	if (enabledFeatures12.bufferDeviceAddress)
+	{
+		allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+	}
 	
 	VulkanCheck(vmaCreateAllocator(&allocatorInfo, &backendData.allocator));
 
@@ -526,6 +973,16 @@ void VulkanBackend::Shutdown(BackendData& backendData)
 	backendData.computeQueues.clear();
 	backendData.transferQueues.clear();
 	backendData.presentQueueCandidates.clear();
+	backendData.enabledInstanceExtensions.clear();
+	backendData.enabledDeviceExtensions.clear();
+	backendData.hostImageCopyLayouts.clear();
+	backendData.minImportedHostPointerAlignment = 0;
+	backendData.extendedDynamicStates.clear();
+	backendData.extendedDynamicStateFunctions = {};
+#ifdef VK_KHR_dynamic_rendering
+	backendData.cmdBeginRendering = nullptr;
+	backendData.cmdEndRendering = nullptr;
+#endif
 
 
 	vkDestroyDevice(backendData.logicalDevice, nullptr);
@@ -535,6 +992,16 @@ void VulkanBackend::Shutdown(BackendData& backendData)
 	DestroyInstance(backendData);
 }
 
+bool VulkanBackend::IsInstanceExtensionEnabled(const BackendData& backendData, const char* extension)
+{
+	return ContainsExtension(backendData.enabledInstanceExtensions, extension);
+}
+
+bool VulkanBackend::IsDeviceExtensionEnabled(const BackendData& backendData, const char* extension)
+{
+	return ContainsExtension(backendData.enabledDeviceExtensions, extension);
+}
+
 void VulkanBackend::DestroySurface(const BackendData& backendData, VkSurfaceKHR& surface)
 {
 	vkDestroySurfaceKHR(backendData.instance, surface, nullptr);
@@ -646,14 +1113,18 @@ void VulkanBackend::GetSurfaceExtent(const BackendData& backendData, SurfaceData
 	if (surfaceData.surfaceCapabilities.currentExtent.width != UINT32_MAX)
 	{
 		surfaceData.surfaceExtent = surfaceData.surfaceCapabilities.currentExtent;
+		return;
 	}
 
+	// The surface size is determined by the swapchain, so the requested size is clamped to the supported range.
 	VkExtent2D actualExtent = { surfaceData.width, surfaceData.height };
 
 	actualExtent.width = std::max<uint32_t>(surfaceData.surfaceCapabilities.minImageExtent.width,
 		std::min<uint32_t>(surfaceData.surfaceCapabilities.maxImageExtent.width, actualExtent.width));
 	actualExtent.height = std::max<uint32_t>(surfaceData.surfaceCapabilities.minImageExtent.height,
 		std::min<uint32_t>(surfaceData.surfaceCapabilities.maxImageExtent.height, actualExtent.height));
+
+	surfaceData.surfaceExtent = actualExtent;
 }
 
 void VulkanBackend::GetPresentMode(const BackendData& backendData, SurfaceData& surfaceData, bool vSync)
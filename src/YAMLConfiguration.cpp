@@ -133,8 +133,8 @@ uint32_t Configurator::VendorIdFromString(const std::string& name)
 	return 0;
 }
 
-bool Configurator::CheckFeaturesPresent(const VkPhysicalDeviceFeatures& deviceFeatures, const VkPhysicalDeviceProperties& deviceProperties,
-	const std::vector<std::string>& requiredFeatures)
+bool Configurator::CheckFeaturesPresent(const VkPhysicalDeviceFeatures& deviceFeatures, const VkPhysicalDeviceVulkan12Features& deviceFeatures12,
+	const VkPhysicalDeviceProperties& deviceProperties, const std::vector<std::string>& requiredFeatures)
 {
 	// TODO: discrete from bool and the rest from actual VkPhysicalDeviceFeatures.
 	if ((std::find(requiredFeatures.begin(), requiredFeatures.end(), "dedicated") != requiredFeatures.end() ||
@@ -156,6 +156,12 @@ bool Configurator::CheckFeaturesPresent(const VkPhysicalDeviceFeatures& deviceFe
 		return false;
 	}
 
+	if (std::find(requiredFeatures.begin(), requiredFeatures.end(), "sparse residency") != requiredFeatures.end() &&
+		(deviceFeatures.sparseBinding != VK_TRUE || deviceFeatures.sparseResidencyImage2D != VK_TRUE))
+	{
+		return false;
+	}
+
 	if (std::find(requiredFeatures.begin(), requiredFeatures.end(), "tessellation shader") != requiredFeatures.end() &&
 		deviceFeatures.tessellationShader != VK_TRUE)
 	{
@@ -179,6 +185,26 @@ bool Configurator::CheckFeaturesPresent(const VkPhysicalDeviceFeatures& deviceFe
 	{
 		return false;
 	}
+
+	if (std::find(requiredFeatures.begin(), requiredFeatures.end(), "buffer device address") != requiredFeatures.end() &&
+		deviceFeatures12.bufferDeviceAddress != VK_TRUE)
+	{
+		return false;
+	}
+
+	if (std::find(requiredFeatures.begin(), requiredFeatures.end(), "descriptor indexing") != requiredFeatures.end() &&
+		(deviceFeatures12.descriptorIndexing != VK_TRUE || deviceFeatures12.runtimeDescriptorArray != VK_TRUE ||
+		deviceFeatures12.descriptorBindingPartiallyBound != VK_TRUE || deviceFeatures12.descriptorBindingVariableDescriptorCount != VK_TRUE ||
+		deviceFeatures12.descriptorBindingUpdateUnusedWhilePending != VK_TRUE ||
+		deviceFeatures12.descriptorBindingSampledImageUpdateAfterBind != VK_TRUE ||
+		deviceFeatures12.descriptorBindingStorageImageUpdateAfterBind != VK_TRUE ||
+		deviceFeatures12.descriptorBindingStorageBufferUpdateAfterBind != VK_TRUE ||
+		deviceFeatures12.shaderSampledImageArrayNonUniformIndexing != VK_TRUE ||
+		deviceFeatures12.shaderStorageImageArrayNonUniformIndexing != VK_TRUE ||
+		deviceFeatures12.shaderStorageBufferArrayNonUniformIndexing != VK_TRUE))
+	{
+		return false;
+	}
 	
 	return true;
 }
@@ -197,6 +223,13 @@ VkPhysicalDeviceFeatures Configurator::FeaturesFromString(const std::vector<std:
 		result.sparseBinding = VK_TRUE;
 	}
 
+	if (std::find(requiredFeatures.begin(), requiredFeatures.end(), "sparse residency") != requiredFeatures.end())
+	{
+		// Residency is useless without binding, so both are enabled.
+		result.sparseBinding = VK_TRUE;
+		result.sparseResidencyImage2D = VK_TRUE;
+	}
+
 	if (std::find(requiredFeatures.begin(), requiredFeatures.end(), "tessellation shader") != requiredFeatures.end())
 	{
 		result.tessellationShader = VK_TRUE;
@@ -220,6 +253,36 @@ VkPhysicalDeviceFeatures Configurator::FeaturesFromString(const std::vector<std:
 	return result;
 }
 
+VkPhysicalDeviceVulkan12Features Configurator::Features12FromString(const std::vector<std::string>& requiredFeatures)
+{
+	VkPhysicalDeviceVulkan12Features result{};
+	result.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	if (std::find(requiredFeatures.begin(), requiredFeatures.end(), "buffer device address") != requiredFeatures.end())
+	{
+		result.bufferDeviceAddress = VK_TRUE;
+	}
+
+	if (std::find(requiredFeatures.begin(), requiredFeatures.end(), "descriptor indexing") != requiredFeatures.end())
+	{
+		// Everything the bindless heap relies on: update after bind, partially bound and variable count arrays,
+		// indexed non-uniformly from shaders.
+		result.descriptorIndexing = VK_TRUE;
+		result.runtimeDescriptorArray = VK_TRUE;
+		result.descriptorBindingPartiallyBound = VK_TRUE;
+		result.descriptorBindingVariableDescriptorCount = VK_TRUE;
+		result.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		result.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		result.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+		result.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		result.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		result.shaderStorageImageArrayNonUniformIndexing = VK_TRUE;
+		result.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+	}
+
+	return result;
+}
+
 bool Configurator::CheckQueueSupport(const YAML::Node& queueRequirements, const std::vector<VkQueueFamilyProperties>& queueProperties,
 	std::vector<int>& outputIndices, std::map<std::string, int>& queueTypeMapping)
 {
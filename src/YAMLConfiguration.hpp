@@ -36,9 +36,10 @@ namespace Configurator
 
 	uint32_t VendorIdFromString(const std::string& name);
 
-	bool CheckFeaturesPresent(const VkPhysicalDeviceFeatures& deviceFeatures, const VkPhysicalDeviceProperties& deviceProperties,
-		const std::vector<std::string>& requiredFeatures);
+	bool CheckFeaturesPresent(const VkPhysicalDeviceFeatures& deviceFeatures, const VkPhysicalDeviceVulkan12Features& deviceFeatures12,
+		const VkPhysicalDeviceProperties& deviceProperties, const std::vector<std::string>& requiredFeatures);
 	VkPhysicalDeviceFeatures FeaturesFromString(const std::vector<std::string>& requiredFeatures);
+	VkPhysicalDeviceVulkan12Features Features12FromString(const std::vector<std::string>& requiredFeatures);
 
 	bool CheckQueueSupport(const YAML::Node& queueRequirements, const std::vector<VkQueueFamilyProperties>& queueProperties,
 		std::vector<int>& outputIndices, std::map<std::string, int>& queueTypeMapping);
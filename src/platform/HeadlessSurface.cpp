@@ -0,0 +1,30 @@
+#include "VulkanBackend/VulkanBackendAPI.hpp"
+#include "VulkanBackend/ErrorCheck.hpp"
+#include <SoftwareCore/DefaultLogger.hpp>
+
+bool VulkanBackend::CreateHeadlessSurface(const BackendData& backendData, SurfaceData& surfaceData, uint32_t width, uint32_t height)
+{
+#ifdef VK_EXT_headless_surface
+	if (!IsInstanceExtensionEnabled(backendData, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME))
+	{
+		CoreLogError(DefaultLogger, "Vulkan backend: Headless surface requires the \"VK_EXT_headless_surface\" instance extension.");
+		return false;
+	}
+
+	auto VkCreateHeadlessSurfaceEXT = reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>(
+		vkGetInstanceProcAddr(backendData.instance, "vkCreateHeadlessSurfaceEXT"));
+
+	VkHeadlessSurfaceCreateInfoEXT surfaceCreateInfo{};
+	surfaceCreateInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+	VulkanCheck(VkCreateHeadlessSurfaceEXT(backendData.instance, &surfaceCreateInfo, nullptr, &surfaceData.surface));
+
+	// Headless surfaces have no extent of their own, the swapchain extent comes from the requested size.
+	surfaceData.width = width;
+	surfaceData.height = height;
+	return surfaceData.surface != VK_NULL_HANDLE;
+#else
+	CoreLogError(DefaultLogger, "Vulkan backend: Headless surface is not supported by the Vulkan headers.");
+	return false;
+#endif
+}
@@ -0,0 +1,50 @@
+#ifdef __linux__
+
+#include "../FileMapping.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool FileMapping::Map(const char* path, MappedFile& file)
+{
+	int descriptor = open(path, O_RDONLY);
+	if (descriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(descriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		close(descriptor);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	// The mapping keeps its own reference to the file.
+	close(descriptor);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	// The file is read front to back exactly once.
+	madvise(data, (size_t)fileStatus.st_size, MADV_SEQUENTIAL);
+
+	file.data = (const uint8_t*)data;
+	file.size = (size_t)fileStatus.st_size;
+	return true;
+}
+
+void FileMapping::Unmap(MappedFile& file)
+{
+	if (file.data)
+	{
+		munmap((void*)file.data, file.size);
+	}
+	file = {};
+}
+
+#endif